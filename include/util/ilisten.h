@@ -16,17 +16,26 @@
  */
 #pragma once
 
+#include <array>
 #include <map>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <atomic>
 
+#include "util/stringutil.h"
+
 namespace util::log {
 
 class ListenStream;
 
+namespace detail {
+/// Type erased argument to the listen format functions.
+using ListenFormatArg = util::string::FormatArg;
+}  // namespace detail
+
 /** \brief Defines the type of listen objects.
  *
  * Define type of listen (server) objects
@@ -35,6 +44,30 @@ enum class TypeOfListen {
   ListenProxyType = 0, ///< Forward the listen messages in shared memory.
   ListenServerType, ///< TCP/IP server that forwards the listen messages.
   ListenConsoleType, ///< Forward the listen messages to a console window.
+  ListenMuxServerType, ///< TCP/IP server that multiplex many channels.
+};
+
+/** \brief Defines what a server does when a client queue is full.
+ *
+ * A listen server queues the messages for each connected client. If a client
+ * cannot keep up, the queue reaches its limit and the policy selects what
+ * happens.
+ */
+enum class ListenOverflowPolicy {
+  DropOldest = 0, ///< Removes the oldest message in the queue.
+  DropNewest, ///< Ignores the new message.
+  Disconnect, ///< Closes the client connection.
+};
+
+/** \brief Defines the format of a listen server's shared memory queue.
+ *
+ * The proxies sends their messages to the server through a shared memory
+ * queue. Older proxies only supports the mutex queue.
+ */
+enum class ListenQueueFormat {
+  MutexQueue = 0, ///< Fixed 256 messages guarded by a mutex (default).
+  RingQueue, ///< Lock-free ring of fixed size messages.
+  RecordQueue, ///< Lock-free ring of variable length messages.
 };
 
 /** \class IListen ilisten.h "util/ilisten.h"
@@ -126,6 +159,99 @@ class IListen {
    */
   void Port(uint16_t port) { port_ = port; }
 
+  /** \brief Sets the maximum number of queued messages per client.
+   *
+   * Limits the number of messages that a server queues for each connected
+   * client. The policy defines what happens when the limit is reached. The
+   * viewer gets a 'N messages dropped' text when messages have been dropped.
+   * The server's input queue uses the same limit. It drops new messages when
+   * it is full, except for the shared memory messages that waits for a free
+   * place. The limit should be set before the server is started. Only valid
+   * for listen servers.
+   * @param max_messages Maximum queued messages. Zero means no limit.
+   * @param policy What to do when the limit is reached.
+   */
+  void QueueLimit(
+      size_t max_messages,
+      ListenOverflowPolicy policy = ListenOverflowPolicy::DropOldest) {
+    queue_limit_ = max_messages;
+    overflow_policy_ = policy;
+  }
+
+  /** \brief Maximum number of queued messages per client.
+   *
+   * @return Maximum queued messages. Zero means no limit.
+   */
+  [[nodiscard]] size_t QueueLimit() const { return queue_limit_; }
+
+  /** \brief Enables batching of text messages.
+   *
+   * When enabled, a listen server packs text messages that are forwarded at
+   * the same time into one compressed message. This reduces the bandwidth on
+   * high-rate channels. Only clients that support batches receive them.
+   * Only valid for listen servers. Default is disabled.
+   * @param batch True if text messages should be batched.
+   */
+  void BatchMessages(bool batch) { batch_messages_ = batch; }
+
+  /** \brief Returns true if text messages are batched.
+   *
+   * @return True if text messages are batched.
+   */
+  [[nodiscard]] bool BatchMessages() const { return batch_messages_; }
+
+  /** \brief Selects the format of the shared memory queue.
+   *
+   * The ring format doesn't lock any mutex when the proxies adds messages.
+   * The record format stores each message as one variable length record, so
+   * long texts are not split into several messages. The capacity is rounded
+   * up to a power of two. The format should be set before the server is
+   * started. Only valid for listen servers.
+   * @param format Shared memory queue format.
+   * @param capacity Number of messages (ring) or bytes (record). The record
+   * format uses at least 64 kB.
+   */
+  void ShareQueueFormat(ListenQueueFormat format, size_t capacity = 256) {
+    share_queue_format_ = format;
+    share_queue_capacity_ = capacity;
+  }
+
+  /** \brief Returns the format of the shared memory queue.
+   *
+   * @return Shared memory queue format.
+   */
+  [[nodiscard]] ListenQueueFormat ShareQueueFormat() const {
+    return share_queue_format_;
+  }
+
+  /** \brief Returns the capacity of the shared memory queue.
+   *
+   * @return Number of messages (ring) or bytes (record).
+   */
+  [[nodiscard]] size_t ShareQueueCapacity() const {
+    return share_queue_capacity_;
+  }
+
+  /** \brief Returns the queue overflow policy.
+   *
+   * @return What to do when the queue limit is reached.
+   */
+  [[nodiscard]] ListenOverflowPolicy OverflowPolicy() const {
+    return overflow_policy_;
+  }
+
+  /** \brief Adds a channel to a multiplexed server.
+   *
+   * A multiplexed server forwards many shared memory queues (channels) over
+   * one TCP/IP port. Each channel is a listen object that can be configured
+   * as a normal listen server, for example its log level texts. Channels
+   * should be added before the server is started. Only valid for multiplexed
+   * servers.
+   * @param share_name Shared memory name of the channel.
+   * @return Channel object or nullptr if not supported.
+   */
+  virtual IListen *AddChannel(const std::string &share_name);
+
   /** \brief Sets the log level menu texts.
    *
    * Sets the log level menu text. Note that level 0 should
@@ -150,6 +276,13 @@ class IListen {
    */
   void ListenString(const std::string &text);
 
+  /** \brief Generates a listen text line if the level is enabled.
+   *
+   * @param level Level of the text line. See IsEnabled().
+   * @param text text as a string
+   */
+  void ListenString(size_t level, const std::string &text);
+
   ListenStream ListenOut();  ///< Internal debug function (unit tests)
 
   /** \brief Generates a listen text line.
@@ -161,6 +294,16 @@ class IListen {
    */
   void ListenText(const char *format_text, ...);
 
+  /** \brief Generates a listen text line if the level is enabled.
+   *
+   * Same as ListenText() but nothing is formatted if the level isn't
+   * enabled. See IsEnabled().
+   * @param level Level of the text line.
+   * @param format_text C-style text format
+   * @param ... Ellipse function.
+   */
+  void ListenText(size_t level, const char *format_text, ...);
+
   /** \brief Generate a user defined text line.
    *
    * Generates a text line with user defined time stamp and pre-text.
@@ -172,6 +315,80 @@ class IListen {
   void ListenTextEx(uint64_t ns1970, const std::string &pre_text,
                     const char *format_text, ...);
 
+  /** \brief Generates a listen text line with type-safe arguments.
+   *
+   * Generates a listen text line with the default pre-text and now as time
+   * stamp. The format string uses '{}' placeholders, for example
+   * ListenFormat("Value: {} Name: {}", 12, name). Each argument is written by
+   * its stream operator. Any format specification inside the braces is
+   * ignored. Use '{{' and '}}' for braces.
+   *
+   * Nothing is formatted if the listen object is inactive.
+   * @tparam Args Argument types. All types need a stream operator.
+   * @param format Format string.
+   * @param args Arguments.
+   */
+  template <typename... Args>
+  void ListenFormat(std::string_view format, const Args &...args) {
+    if (!IsActive()) {
+      return;
+    }
+    ListenString(FormatText(format, args...));
+  }
+
+  /** \brief Generates a listen text line if the level is enabled.
+   *
+   * Same as ListenFormat() but nothing is formatted if the level isn't
+   * enabled. See IsEnabled().
+   * @tparam Args Argument types. All types need a stream operator.
+   * @param level Level of the text line.
+   * @param format Format string.
+   * @param args Arguments.
+   */
+  template <typename... Args>
+  void ListenFormat(size_t level, std::string_view format,
+                    const Args &...args) {
+    if (!IsEnabled(level)) {
+      return;
+    }
+    ListenString(FormatText(format, args...));
+  }
+
+  /** \brief Generates a user defined text line with type-safe arguments.
+   *
+   * Generates a text line with user defined time stamp and pre-text. See
+   * ListenFormat() for the format string.
+   * @tparam Args Argument types. All types need a stream operator.
+   * @param ns1970 Time stamp nanoseconds since 1970.
+   * @param pre_text Pre-text string.
+   * @param format Format string.
+   * @param args Arguments.
+   */
+  template <typename... Args>
+  void ListenFormatEx(uint64_t ns1970, const std::string &pre_text,
+                      std::string_view format, const Args &...args) {
+    if (!IsActive()) {
+      return;
+    }
+    AddMessage(ns1970, pre_text, FormatText(format, args...));
+  }
+
+  /** \brief Formats a text with '{}' placeholders.
+   *
+   * Support function for the ListenFormat() functions.
+   * @tparam Args Argument types. All types need a stream operator.
+   * @param format Format string.
+   * @param args Arguments.
+   * @return Formatted text.
+   */
+  template <typename... Args>
+  static std::string FormatText(std::string_view format, const Args &...args) {
+    const std::array<detail::ListenFormatArg, sizeof...(Args)> arg_list = {
+        detail::ListenFormatArg{&args,
+                                &detail::ListenFormatArg::WriteArg<Args>}...};
+    return FormatArgList(format, arg_list.data(), arg_list.size());
+  }
+
   /** \brief Generates a hex string text from a byte buffer
    *
    * Function used when parsing byte buffer typically in protocol applications.
@@ -196,6 +413,38 @@ class IListen {
   virtual void ListenReceive(uint64_t ns1970, const std::string &pre_text,
                              const std::vector<uint8_t> &buffer, void *hint);
 
+  /** \brief Parses a byte buffer into a hexadecimal string.
+   *
+   * Formats the bytes as lower case hexadecimal values separated by a space,
+   * for example '01 a2 ff'. The string is allocated once with its exact size.
+   * @param buffer Bytes to format.
+   * @return Hexadecimal string.
+   */
+  static std::string ParseHex(const std::vector<uint8_t> &buffer);
+
+  /** \brief Formats bytes as hexadecimal text into a caller buffer.
+   *
+   * Same format as ParseHex() but without any allocation. Only whole bytes
+   * are written and the text is not null terminated. Use HexSize() to get
+   * the required destination size.
+   * @param data Bytes to format.
+   * @param size Number of bytes.
+   * @param dest Destination buffer.
+   * @param dest_size Size of the destination buffer.
+   * @return Number of characters written.
+   */
+  static size_t ParseHex(const uint8_t *data, size_t size, char *dest,
+                         size_t dest_size);
+
+  /** \brief Returns the number of characters for a hexadecimal dump.
+   *
+   * @param nof_bytes Number of bytes.
+   * @return Number of characters (3 * bytes - 1).
+   */
+  static constexpr size_t HexSize(size_t nof_bytes) {
+    return nof_bytes > 0 ? 3 * nof_bytes - 1 : 0;
+  }
+
   virtual void SetActive(
       bool active);  ///< Activate or deactivate the listen object
 
@@ -215,6 +464,22 @@ class IListen {
    */
   [[nodiscard]] virtual size_t LogLevel() = 0;
 
+  /** \brief Returns true if a text line with the level should be generated.
+   *
+   * Fast check that should be called before any text is built. A text line
+   * is enabled if a listen window is connected and the level is equal or
+   * larger than the current log level. This matches the log level menu
+   * where level 0 shows all text lines and higher levels hide more.
+   *
+   * The check doesn't allocate anything. The proxy reads the log level from
+   * an atomic copy of the shared memory level.
+   * @param level Level of the text line.
+   * @return True if the text line should be generated.
+   */
+  [[nodiscard]] bool IsEnabled(size_t level) {
+    return IsActive() && level >= LogLevel();
+  }
+
   /** \brief Starts the listen object.
    *
    * Starts the listen object.
@@ -237,6 +502,14 @@ class IListen {
    */
   [[nodiscard]] virtual size_t NofConnections() const;
 
+  /** \brief Number of messages that have been dropped.
+   *
+   * Number of messages that have been dropped due to full client or input
+   * queues. Only valid for listen servers.
+   * @return Number of dropped messages.
+   */
+  [[nodiscard]] virtual uint64_t NofDroppedMessages() const;
+
   /** \brief Returns number of generated messages.
    *
    * Returns number of messages that have been sent.
@@ -260,6 +533,13 @@ class IListen {
   std::string host_name_ = "127.0.0.1";             ///< Host name
   uint16_t port_ = 0;                               ///< IP-port to listen on.
   std::map<uint64_t, std::string> log_level_list_;  ///< Log level index and
+  size_t queue_limit_ = 0; ///< Max queued messages per client (0 = no limit).
+  ListenOverflowPolicy overflow_policy_ =
+      ListenOverflowPolicy::DropOldest; ///< What to do when a queue is full.
+  std::atomic<bool> batch_messages_ = false; ///< Batch text messages.
+  ListenQueueFormat share_queue_format_ =
+      ListenQueueFormat::MutexQueue; ///< Shared memory queue format.
+  size_t share_queue_capacity_ = 256; ///< Shared memory queue capacity.
 
 
   IListen() = default;                              ///< Default constructor
@@ -275,12 +555,16 @@ class IListen {
   virtual void AddMessage(uint64_t nano_sec_1970, const std::string &pre_text,
                           const std::string &text) = 0;
 
-  /** \brief Parses a byte buffer into a hexadecimal string.
+  /** \brief Formats a text from a list of type erased arguments.
    *
-   * @param buffer
-   * @return
+   * @param format Format string with '{}' placeholders.
+   * @param arg_list Pointer to the first argument.
+   * @param nof_args Number of arguments.
+   * @return Formatted text.
    */
-  static std::string ParseHex(const std::vector<uint8_t> &buffer);
+  static std::string FormatArgList(std::string_view format,
+                                   const detail::ListenFormatArg *arg_list,
+                                   size_t nof_args);
 
   /** Increments the number of messages.
    *
@@ -14,6 +14,7 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "util/threadsafequeue.h"
 namespace util::log {
@@ -125,6 +126,25 @@ class IListenClient {
    */
   virtual void SendLogLevel(uint64_t level) = 0;
 
+  /** \brief Send log level to a channel on a multiplexed server.
+   *
+   * Sets the log level of one channel on a multiplexed server. The channel
+   * number is found in the subscribe reply.
+   * @param channel Channel number.
+   * @param level The log level is dependent on the channel functionality
+   */
+  virtual void SendLogLevel(uint32_t channel, uint64_t level);
+
+  /** \brief Subscribes to channels on a multiplexed server.
+   *
+   * The subscription is sent each time the client connects. The server
+   * replies with a subscribe message that maps the share names to channel
+   * numbers. All messages from the server have their channel number set.
+   * An empty list subscribes to all channels.
+   * @param share_names Share names to listen to.
+   */
+  virtual void Subscribe(const std::vector<std::string>& share_names);
+
  protected:
   std::atomic<bool> active_ =
       true;  ///< Indicate if the message should be used or not
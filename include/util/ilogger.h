@@ -8,6 +8,8 @@
 #pragma once
 #include <array>
 #include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
 
 #include "logmessage.h"
@@ -24,9 +26,17 @@ enum class LogType {
   LogToFile,       ///< Log to file.
   LogToListen,     ///< Log to listen window (system messages).
   LogToSyslog,     ///< Logs to a syslog server.
-  LogToList        ///< Logs to an internal list.
+  LogToList,       ///< Logs to an internal list.
+  LogToBinaryFile  ///< Log to a memory-mapped binary file.
 };
 
+/** \brief Number of loggers that have enabled each severity.
+ *
+ * The counters are indexed by the severity. A severity is enabled if any
+ * logger has enabled it.
+ */
+using SeverityCount = std::array<std::atomic<uint32_t>, 9>;
+
 /** \class ILogger ilogger.h "util/ilogger.h"
  * \brief Interface against a generic logger.
  *
@@ -35,9 +45,20 @@ enum class LogType {
  */
 class ILogger {
  public:
-  virtual ~ILogger() = default;  ///< Destructor
+  virtual ~ILogger();  ///< Destructor
   virtual void AddLogMessage(
       const LogMessage &message) = 0;  ///< Handle a log message
+
+  /** \brief Handles a shared log message.
+   *
+   * The asynchronous log front end shares one immutable message between all
+   * loggers. Loggers with an internal queue should override this function
+   * and keep the shared pointer instead of copying the message. The default
+   * implementation calls AddLogMessage().
+   * @param message Shared log message.
+   */
+  virtual void AddSharedMessage(
+      const std::shared_ptr<const LogMessage> &message);
   virtual void Stop();                 ///< Stops any worker thread
 
   /** \brief Enable or disable a severity
@@ -60,6 +81,16 @@ class ILogger {
    */
   [[nodiscard]] bool IsSeverityLevelEnabled(LogSeverity severity) const;
 
+  /** \brief Attaches counters of enabled severities.
+   *
+   * The log configuration attaches its counters when the logger is added to
+   * the log chain. The logger adds its enabled severities to the counters
+   * and updates them when a severity is enabled or disabled. The logger
+   * detaches itself when it is deleted.
+   * @param count Counters or nullptr to detach.
+   */
+  void AttachSeverityCount(SeverityCount *count);
+
   /** \brief Enable or disable the source location information
    *
    * The source location normally appended to the log message. It logs the
@@ -86,6 +117,8 @@ class ILogger {
  private:
   std::array<std::atomic<bool>, 9> severity_filter_ = {
       true, true, true, true, true, true, true, true, true};
+  std::mutex severity_lock_;  ///< Locks the filter changes and the counters.
+  SeverityCount *severity_count_ = nullptr;  ///< Attached counters.
   std::atomic<bool> show_location_ = true;
 };
 
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2025 Ingemar Hedvall
+ * SPDX-License-Identifier: MIT
+ */
+
+/** \file iocontextpool.h
+ * \brief Implements a small thread pool that runs a shared I/O context.
+ */
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace boost::asio {
+class io_context;
+}
+
+namespace util {
+
+/** \class IoContextPool iocontextpool.h "util/iocontextpool.h"
+ * \brief Thread pool that runs one shared I/O context.
+ *
+ * The network components (listen servers and clients, syslog servers, the
+ * syslog logger and the process master) normally own an I/O context and a
+ * worker thread each. A component that is created with a pool uses the
+ * context of the pool instead. Each component serializes its handlers with
+ * its own strand, so a few threads may serve all components.
+ *
+ * The pool is shared by the components and is deleted when the last
+ * component is deleted. A component must not be deleted by a handler that
+ * runs in the pool.
+ */
+class IoContextPool final {
+ public:
+  /** \brief Starts the pool threads.
+   *
+   * @param nof_threads Number of threads that runs the context.
+   */
+  explicit IoContextPool(size_t nof_threads = 2);
+  ~IoContextPool();
+
+  IoContextPool(const IoContextPool&) = delete;
+  IoContextPool& operator=(const IoContextPool&) = delete;
+
+  /** \brief Returns the shared context. */
+  [[nodiscard]] boost::asio::io_context& Context();
+
+  /** \brief Returns number of threads in the pool. */
+  [[nodiscard]] size_t NofThreads() const { return worker_list_.size(); }
+
+ private:
+  std::unique_ptr<boost::asio::io_context> context_;
+  std::shared_ptr<void> work_;  ///< Keeps the context running when idle.
+  std::vector<std::thread> worker_list_;
+
+  void WorkerTask();
+};
+
+}  // namespace util
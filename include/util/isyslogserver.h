@@ -18,7 +18,7 @@
 #include <optional>
 
 #include "util/syslogmessage.h"
-#include "util/threadsafequeue.h"
+#include "util/ringqueue.h"
 
 namespace util::syslog {
 
@@ -99,6 +99,18 @@ class ISyslogServer {
    */
   std::optional<SyslogMessage> GetMsg(bool block);
 
+  /** \brief Fetch the next message in the queue into a message object.
+   *
+   * The message object is swapped with the message in the queue. The old
+   * content of the object is reused by the queue, so a caller that keeps its
+   * message object doesn't cause any memory allocations.
+   *
+   * @param msg Destination message.
+   * @param block Set tor true if the call should block until a message exist.
+   * @return True if a message was returned.
+   */
+  bool GetMsg(SyslogMessage& msg, bool block);
+
   virtual void Start();  ///< Starts the worker thread in the server.
   virtual void Stop();   ///< Stops the worker thread in the server.
 
@@ -107,6 +119,28 @@ class ISyslogServer {
     return msg_queue_ ? msg_queue_->Size() : 0;
   }
 
+  /** \brief Sets the maximum number of queued messages.
+   *
+   * Limits the internal message queue. New messages are dropped when the
+   * queue is full. The limit should be set before the server is started.
+   * @param max_messages Maximum number of messages. Zero means no limit.
+   */
+  void MaxMessages(size_t max_messages) { max_messages_ = max_messages; }
+
+  [[nodiscard]] size_t MaxMessages() const {  ///< Returns the queue limit.
+    return max_messages_;
+  }
+
+  [[nodiscard]] uint64_t NofDroppedMessages()
+      const {  ///< Returns number of messages dropped on a full queue.
+    return msg_queue_ ? msg_queue_->NofDropped() : 0;
+  }
+
+  [[nodiscard]] size_t HighWaterMark()
+      const {  ///< Returns the highest number of queued messages.
+    return msg_queue_ ? msg_queue_->HighWaterMark() : 0;
+  }
+
   /** \brief Returns true if the receiver works as normal.
    *
    * The operable flag is false if the receiving of messages fails of some
@@ -132,7 +166,8 @@ class ISyslogServer {
   std::string address_ = "0.0.0.0";  ///< Bind address. Default is  0.0.0.0
   std::string name_;                 ///< Display name of the server.
   uint16_t port_ = 0;                ///< Server port.
-  std::unique_ptr<log::ThreadSafeQueue<SyslogMessage>>
+  size_t max_messages_ = 0;          ///< Max queued messages. 0 = No limit.
+  std::unique_ptr<log::RingQueue<SyslogMessage>>
       msg_queue_;                    ///< Message queue
 };
 
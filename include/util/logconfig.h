@@ -8,14 +8,18 @@
  */
 #pragma once
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "ilogger.h"
 #include "logmessage.h"
+#include "util/mpscqueue.h"
 #include "util/stringutil.h"
 
 namespace util::log {
@@ -131,6 +135,42 @@ class LogConfig final {
    */
   void AddLogMessage(const LogMessage &message) const;  ///< Adds a log message.
 
+  /** \brief Adds a log message that may be moved.
+   *
+   * Same as the copy version but the message is moved into the asynchronous
+   * queue without a copy.
+   * @param [in] message Message to log.
+   */
+  void AddLogMessage(LogMessage &&message) const;
+
+  /** \brief Turns on or off the asynchronous log front end.
+   *
+   * By default, each log call is passed to all loggers on the caller's
+   * thread under a global lock. The asynchronous front end instead puts the
+   * message into a lock-free queue. A dispatcher thread passes one shared
+   * message to all loggers. Turning it off, dispatches any queued messages.
+   * @param async True to use the asynchronous front end.
+   */
+  void AsyncLogging(bool async);
+
+  [[nodiscard]] bool AsyncLogging() const {  ///< True if asynchronous logging.
+    return async_;
+  }
+
+  /** \brief Returns true if any logger handles the severity.
+   *
+   * The check uses counters of the loggers that have enabled each severity.
+   * The loggers in the log chain update the counters themselves. It is
+   * false if the loggers are disabled.
+   * @param severity Log severity.
+   * @return True if the severity is enabled.
+   */
+  [[nodiscard]] bool IsSeverityEnabled(LogSeverity severity) const {
+    const auto level = static_cast<uint8_t>(severity);
+    return enabled_ && level < severity_count_.size() &&
+           severity_count_[level].load(std::memory_order_relaxed) > 0;
+  }
+
   void Type(LogType log_type);  ///< Sets the type of default logger.
 
   [[nodiscard]] LogType Type() const;  ///< Returns the type of default logger.
@@ -159,6 +199,93 @@ class LogConfig final {
   [[nodiscard]] const std::string &SubDir()
       const;  ///< Returns the sub directory.
 
+  /** \brief Turns on the high-throughput mode for log files.
+   *
+   * By default, a log file is opened and closed for each batch of messages
+   * and each message is written separately. In high-throughput mode, the file
+   * is kept open and each batch is formatted into one buffer that is written
+   * with one call. Should be set before the log file is created.
+   * @param enable True to enable the high-throughput mode.
+   */
+  void FileHighThroughput(bool enable) { file_high_throughput_ = enable; }
+  [[nodiscard]] bool FileHighThroughput() const {  ///< True if enabled.
+    return file_high_throughput_;
+  }
+
+  /** \brief Sets how often a log file writes its queued messages.
+   *
+   * Messages are collected during the interval and written in one batch.
+   * Default is 1 second.
+   * @param interval Flush interval.
+   */
+  void FileFlushInterval(std::chrono::milliseconds interval) {
+    file_flush_interval_ = interval;
+  }
+  [[nodiscard]] std::chrono::milliseconds FileFlushInterval()
+      const {  ///< Returns the flush interval.
+    return file_flush_interval_;
+  }
+
+  /** \brief Sets how often a log file is synchronized to disk.
+   *
+   * Only used in high-throughput mode. Zero means that the file is never
+   * synchronized, which leaves that to the operating system.
+   * @param interval Sync interval.
+   */
+  void FileSyncInterval(std::chrono::milliseconds interval) {
+    file_sync_interval_ = interval;
+  }
+  [[nodiscard]] std::chrono::milliseconds FileSyncInterval()
+      const {  ///< Returns the sync interval.
+    return file_sync_interval_;
+  }
+
+  /** \brief Sets the size when a log file is rotated.
+   *
+   * The log file is moved to the first backup file (file_0.log) when it
+   * passes this size. Default is 10 MB.
+   * @param size Rotation size in bytes.
+   */
+  void FileRotationSize(uint64_t size) { file_rotation_size_ = size; }
+  [[nodiscard]] uint64_t FileRotationSize() const {  ///< Rotation size.
+    return file_rotation_size_;
+  }
+
+  /** \brief Sets the number of backup files that are kept.
+   *
+   * The backup files are named file_0.log to file_N-1.log. Default is 10.
+   * @param generations Number of backup files.
+   */
+  void FileGenerations(size_t generations) {
+    file_generations_ = generations;
+  }
+  [[nodiscard]] size_t FileGenerations() const {  ///< Number of backups.
+    return file_generations_;
+  }
+
+  /** \brief Compresses the rotated backup files.
+   *
+   * The backup files are gzip compressed (file_N.log.gz) by a background
+   * thread, so the log writer isn't delayed.
+   * @param compress True to compress the backup files.
+   */
+  void FileCompressBackups(bool compress) { file_compress_backups_ = compress; }
+  [[nodiscard]] bool FileCompressBackups() const {  ///< True if compressed.
+    return file_compress_backups_;
+  }
+
+  /** \brief Sets the size of a binary log file.
+   *
+   * The binary log file (LogType::LogToBinaryFile) is preallocated with this
+   * size and keeps the latest messages that fit. Should be set before the
+   * log file is created. Default is 10 MB.
+   * @param size File size in bytes.
+   */
+  void BinaryFileSize(uint64_t size) { binary_file_size_ = size; }
+  [[nodiscard]] uint64_t BinaryFileSize() const {  ///< Binary file size.
+    return binary_file_size_;
+  }
+
   /** \brief Sets the default application name.
    *
    * Some logger includes application name in their message logs. The
@@ -187,12 +314,35 @@ class LogConfig final {
   std::string sub_dir_;
   std::string root_dir_;
   std::string application_name_;
+  std::atomic<bool> file_high_throughput_ = false;
+  std::atomic<std::chrono::milliseconds> file_flush_interval_ =
+      std::chrono::milliseconds(1000);
+  std::atomic<std::chrono::milliseconds> file_sync_interval_ =
+      std::chrono::milliseconds(0);
+  std::atomic<uint64_t> file_rotation_size_ = 10'000'000;
+  std::atomic<size_t> file_generations_ = 10;
+  std::atomic<bool> file_compress_backups_ = false;
+  std::atomic<uint64_t> binary_file_size_ = 10'000'000;
+
+  /// Loggers that have enabled each severity. Must outlive the log chain.
+  SeverityCount severity_count_ = {};
 
   mutable std::mutex locker_;
   std::map<std::string, std::unique_ptr<ILogger>, util::string::IgnoreCase>
       log_chain_;
 
+  std::atomic<bool> async_ = false;
+  mutable MpscQueue<LogMessage> async_queue_;  ///< Asynchronous messages.
+  std::mutex dispatcher_lock_;  ///< Serializes start and stop of the thread.
+  std::thread dispatcher_thread_;
+
   LogConfig() = default;
   ~LogConfig();
+
+  void StartDispatcher();
+  void StopDispatcher();
+  void DispatcherTask();
+  /// Sends the queued messages to all loggers.
+  void DispatchMessages(std::vector<std::unique_ptr<LogMessage>> &msg_list);
 };
 }  // namespace util::log
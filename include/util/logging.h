@@ -7,9 +7,21 @@
  * \brief Standard log interfaces.
  */
 #pragma once
+#include <cstddef>
 #include <cstdint>
 #include <string>
 
+/** \def UTIL_LOG_MIN_SEVERITY
+ * \brief Compile-time minimum log severity.
+ *
+ * The LOG_TRACE() ... LOG_EMERGENCY() macros with a severity below this
+ * level compiles to nothing. The value is the number of the LogSeverity
+ * enumerate, for example 2 removes all trace and debug statements.
+ */
+#ifndef UTIL_LOG_MIN_SEVERITY
+#define UTIL_LOG_MIN_SEVERITY 0
+#endif
+
 #if __has_include(<source_location>)
 #include <source_location>
 #else
@@ -50,6 +62,15 @@ void LogError(const Loc &loc, const char *fmt,
 void LogString(const Loc &loc, LogSeverity severity,
                const std::string &message);  ///< Creates a generic message
 
+/** \brief Returns true if any logger handles the severity.
+ *
+ * Fast check against the enabled severities of all loggers. It is used by
+ * the log macros, so no message is created if no logger wants it.
+ * @param severity Log severity.
+ * @return True if the severity is enabled.
+ */
+[[nodiscard]] bool IsLogEnabled(LogSeverity severity);
+
 /**
  * @brief Alternate loh function that can be used with legacy loggers.
  *
@@ -77,12 +98,42 @@ std::string FindNotepad();
 /** \brief Backup up a file with the 9 last changes.
  *
  * Backup a file by adding a sequence number 0..9 to the file (file_N.ext).
+ * Compressed backups (file_N.ext.gz) are shifted as well.
  * @param filename Full path to the file.
  * @param remove_file If set to true the file will be renamed to file_0. If set
  * to false the file will copy its content to file_0. The latter is slower but
  * safer.
+ * @param nof_generations Number of backup files to keep.
+ * @return True if successful
+ */
+bool BackupFiles(const std::string &filename, bool remove_file = true,
+                 size_t nof_generations = 10);
+
+/** \brief Moves a rotated file into the backup files of a file.
+ *
+ * Shifts the backup files of the file (file_N.ext) and moves the source
+ * file to file_0.ext. The source file is typically the log file that has
+ * been renamed by the writer, so the writer may continue with a new file
+ * while this function runs. Optionally is the file_0.ext gzip compressed
+ * into file_0.ext.gz.
+ * @param filename Full path to the file that owns the backups.
+ * @param source Full path to the rotated file.
+ * @param nof_generations Number of backup files to keep.
+ * @param compress True if the backup should be compressed.
+ * @return True if successful
+ */
+bool RotateFile(const std::string &filename, const std::string &source,
+                size_t nof_generations, bool compress);
+
+/** \brief Converts a binary log file to a text log file.
+ *
+ * Renders the messages in a binary log file (LogType::LogToBinaryFile) with
+ * the same text format as a normal log file. The oldest message is first.
+ * @param binary_file Full path to the binary log file.
+ * @param text_file Full path to the text file that is created.
  * @return True if successful
  */
-bool BackupFiles(const std::string &filename, bool remove_file = true);
+bool ConvertBinaryLogFile(const std::string &binary_file,
+                          const std::string &text_file);
 
 }  // namespace util::log
@@ -9,6 +9,7 @@
 #include <chrono>
 #include <cstdint>
 #include <string>
+#include <string_view>
 
 #include "util/logging.h"
 
@@ -16,6 +17,16 @@ namespace util::log {
 std::string GetSeverityString(
     LogSeverity severity);  ///< Returns the log level as a string
 
+/** \brief Returns a permanent copy of a text.
+ *
+ * The same text always returns the same pointer. The copies are never
+ * deleted, so the function should only be used for a limited set of texts,
+ * for example source file and function names.
+ * @param text Text to store.
+ * @return Pointer to a null-terminated copy of the text.
+ */
+const char *InternString(std::string_view text);
+
 /** \struct LogMessage logmessage.h "util/logging.h"
  *
  * Structure that holds one log message. The log message simply consist of time,
@@ -23,6 +34,9 @@ std::string GetSeverityString(
  * while the location is the file, line and function where the message was
  * created.
  *
+ * The file and function names are pointers to texts that are never deleted,
+ * typically the static strings of a std::source_location. Other texts should
+ * be stored with InternString(). Copying a message doesn't copy the names.
  */
 struct LogMessage {
   std::chrono::time_point<std::chrono::system_clock> timestamp =
@@ -31,8 +45,8 @@ struct LogMessage {
   LogSeverity severity = LogSeverity::kInfo;  ///< Type of message
   uint32_t line = 0;
   uint32_t column = 0;
-  std::string file;
-  std::string function;
+  const char *file = "";      ///< Source file name. Never null.
+  const char *function = "";  ///< Function name. Never null.
 };
 
 }  // namespace util::log
@@ -9,48 +9,56 @@
  * around the location calls.
  */
 #pragma once
-#include <sstream>
+#include <array>
+#include <ostream>
+#include <streambuf>
 #include <string>
+#include <string_view>
 
 #include "util/logging.h"
+#include "util/stringutil.h"
 
 namespace util::log {
 
-#define LOG_TRACE()                               \
-  util::log::LogStream(util::log::Loc::current(), \
-                       util::log::LogSeverity::kTrace) ///< Trace log stream
+/** \def UTIL_LOG_STREAM
+ * \brief Creates a log stream if the severity is enabled.
+ *
+ * Statements below the UTIL_LOG_MIN_SEVERITY level are removed at compile
+ * time. Otherwise, the stream is only created if any logger handles the
+ * severity, so the stream operators are not run for disabled messages.
+ */
+#define UTIL_LOG_STREAM(level, severity)                          \
+  if constexpr ((level) < UTIL_LOG_MIN_SEVERITY) {                \
+  } else if (!util::log::IsLogEnabled(severity)) {                \
+  } else                                                          \
+    util::log::LogStream(util::log::Loc::current(), severity)
+
+#define LOG_TRACE() \
+  UTIL_LOG_STREAM(0, util::log::LogSeverity::kTrace) ///< Trace log stream
 
-#define LOG_DEBUG()                               \
-  util::log::LogStream(util::log::Loc::current(), \
-                       util::log::LogSeverity::kDebug) ///< Debug log stream
+#define LOG_DEBUG() \
+  UTIL_LOG_STREAM(1, util::log::LogSeverity::kDebug) ///< Debug log stream
 
-#define LOG_INFO()                                \
-  util::log::LogStream(util::log::Loc::current(), \
-                       util::log::LogSeverity::kInfo) ///< Info log stream
+#define LOG_INFO() \
+  UTIL_LOG_STREAM(2, util::log::LogSeverity::kInfo) ///< Info log stream
 
-#define LOG_NOTICE()                               \
-  util::log::LogStream(util::log::Loc::current(), \
-                       util::log::LogSeverity::kNotice) ///< Notice log stream
+#define LOG_NOTICE() \
+  UTIL_LOG_STREAM(3, util::log::LogSeverity::kNotice) ///< Notice log stream
 
-#define LOG_WARNING()                               \
-  util::log::LogStream(util::log::Loc::current(), \
-                       util::log::LogSeverity::kWarning) ///< Warning log stream
+#define LOG_WARNING() \
+  UTIL_LOG_STREAM(4, util::log::LogSeverity::kWarning) ///< Warning log stream
 
-#define LOG_ERROR()                               \
-  util::log::LogStream(util::log::Loc::current(), \
-                       util::log::LogSeverity::kError)  ///< Error log stream
+#define LOG_ERROR() \
+  UTIL_LOG_STREAM(5, util::log::LogSeverity::kError) ///< Error log stream
 
-#define LOG_CRITICAL()                               \
-  util::log::LogStream(util::log::Loc::current(), \
-                       util::log::LogSeverity::kCritical) ///< Critical log stream
+#define LOG_CRITICAL() \
+  UTIL_LOG_STREAM(6, util::log::LogSeverity::kCritical) ///< Critical log stream
 
-#define LOG_ALERT()                               \
-  util::log::LogStream(util::log::Loc::current(), \
-                       util::log::LogSeverity::kAlert) ///< Alert log stream
+#define LOG_ALERT() \
+  UTIL_LOG_STREAM(7, util::log::LogSeverity::kAlert) ///< Alert log stream
 
-#define LOG_EMERGENCY()                               \
-  util::log::LogStream(util::log::Loc::current(), \
-                       util::log::LogSeverity::kEmergency) ///< Emergency log stream
+#define LOG_EMERGENCY() \
+  UTIL_LOG_STREAM(8, util::log::LogSeverity::kEmergency) ///< Emergency log stream
 
 /** \class LogStream logstream.h "util/logstream,h"
  * \brief This class implements a stream interface around a log message.
@@ -59,13 +67,18 @@ namespace util::log {
  * uss this class directly. Instead use the LOG_INFO() and LOG_ERROR() macro
  * instead.
  *
+ * The stream writes into a character buffer that is reused by the thread, so
+ * short messages don't allocate any memory. The text is moved into the log
+ * message. The Format() function appends a text with '{}' placeholders.
+ *
  * Usage:
  * \code
  * LOG_INFO() << "Foo was here";
  * LOG_ERROR() << "Foo is not leaving";
+ * LOG_INFO().Format("Foo has {} bars", nof_bars);
  * \endcode
  */
-class LogStream : public std::ostringstream {
+class LogStream : public std::ostream {
  public:
   LogStream(const Loc &location, LogSeverity severity);  ///< Constructor
   ~LogStream() override;                                 ///< Destructor
@@ -76,8 +89,45 @@ class LogStream : public std::ostringstream {
   LogStream &operator=(const LogStream &) = delete;
   LogStream &operator=(LogStream &&) = delete;
 
+  /** \brief Appends a text with '{}' placeholders.
+   *
+   * See util::string::WriteFormat() for the format string.
+   * @tparam Args Argument types. All types need a stream operator.
+   * @param format Format string.
+   * @param args Arguments.
+   * @return Reference to this stream.
+   */
+  template <typename... Args>
+  LogStream &Format(std::string_view format, const Args &...args) {
+    const std::array<util::string::FormatArg, sizeof...(Args)> arg_list = {
+        util::string::FormatArg{&args,
+                                &util::string::FormatArg::WriteArg<Args>}...};
+    util::string::WriteFormat(*this, format, arg_list.data(), arg_list.size());
+    return *this;
+  }
+
+  /** \brief Returns the text so far. */
+  [[nodiscard]] std::string str() const { return *text_; }
+
  private:
+  /** \brief Stream buffer that appends to a string. */
+  class TextBuffer final : public std::streambuf {
+   public:
+    explicit TextBuffer(std::string &text) : text_(text) {}
+
+   protected:
+    int_type overflow(int_type in_char) override;
+    std::streamsize xsputn(const char *text, std::streamsize count) override;
+
+   private:
+    std::string &text_;
+  };
+
   Loc location_;          ///< File and function location.
   LogSeverity severity_;  ///< Log level of the stream
+  bool thread_text_;      ///< True if the thread's buffer is used.
+  std::string own_text_;  ///< Used if the thread's buffer is busy.
+  std::string *text_;     ///< Message text.
+  TextBuffer buffer_;     ///< Stream buffer that writes into the text.
 };
 }  // namespace util::log
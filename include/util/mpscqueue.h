@@ -0,0 +1,278 @@
+/*
+ * Copyright 2025 Ingemar Hedvall
+ * SPDX-License-Identifier: MIT
+ */
+
+/** \file mpscqueue.h
+ * \brief Implements a lock-free multi-producer single-consumer queue.
+ */
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace util::log {
+
+/** \class MpscQueue mpscqueue.h "util/mpscqueue.h"
+ * \brief Lock-free queue with many producers and one consumer.
+ *
+ * The queue has the same interface as the ThreadSafeQueue but the producers
+ * never lock a mutex. A producer links its node with one atomic exchange,
+ * so producers don't block each other or the consumer. The consumer only
+ * needs to be woken if it is blocked in Get() or GetAll().
+ *
+ * Only one thread at the time may call the Get(), GetAll(), GetRemaining()
+ * and Clear() functions. A value that is being added may not be visible to
+ * the consumer until the producer has completed its Put() call.
+ *
+ * When Stop() returns, no producer adds any more values. Values that were
+ * added before the stop, can be fetched with GetRemaining().
+ *
+ * @tparam T Type of object to store.
+ */
+template <typename T>
+class MpscQueue {
+ public:
+  MpscQueue();
+  virtual ~MpscQueue();
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  /** \brief Adds a value at the end of the queue.
+   *
+   * The value is not moved if the queue is stopped.
+   * @param value Value to add.
+   * @return False if the queue is stopped.
+   */
+  bool Put(std::unique_ptr<T>& value);
+
+  /** \brief Adds many values at the end of the queue.
+   *
+   * The values are linked before they are added with one atomic exchange.
+   * The input list is cleared unless the queue is stopped.
+   * @param values Values to add.
+   * @return False if the queue is stopped.
+   */
+  bool PutMany(std::vector<std::unique_ptr<T>>& values);
+
+  /** \brief Fetch the first object from the queue.
+   *
+   * @param dest Returning object
+   * @param block True if the function should block until a value is available.
+   * @return True if a value was returned.
+   */
+  [[nodiscard]] bool Get(std::unique_ptr<T>& dest, bool block);
+
+  /** \brief Fetch all objects from the queue.
+   *
+   * @param dest Destination list. The objects are appended to the list.
+   * @param block True if the function should block until a value is available.
+   * @return True if any value was returned.
+   */
+  [[nodiscard]] bool GetAll(std::vector<std::unique_ptr<T>>& dest, bool block);
+
+  /** \brief Fetch the values that are left in a stopped queue.
+   *
+   * @param dest Destination list. The objects are appended to the list.
+   * @return True if any value was returned.
+   */
+  bool GetRemaining(std::vector<std::unique_ptr<T>>& dest);
+
+  /** \brief Returns true if the queue is empty. */
+  [[nodiscard]] bool Empty() const { return size_ == 0; }
+
+  /** \brief Returns number of items in the queue. */
+  [[nodiscard]] size_t Size() const { return size_; }
+
+  void Clear();  ///< Clears the queue.
+  void Start();  ///< Restarts the queue
+  void Stop();   ///< Stops all blocking Get() and all Put() calls.
+
+ private:
+  struct Node {
+    std::atomic<Node*> next = nullptr;
+    std::unique_ptr<T> value;
+  };
+
+  std::atomic<Node*> head_;  ///< Last added node. Used by the producers.
+  Node* tail_ = nullptr;     ///< Stub node before the first value.
+  std::atomic<size_t> size_ = 0;
+  std::atomic<bool> stop_ = false;
+  std::atomic<bool> waiting_ = false;  ///< True if the consumer sleeps.
+  std::atomic<size_t> producers_ = 0;  ///< Producers inside Put().
+
+  /// Tells Stop() that a producer is adding a value.
+  class ProducerGuard {
+   public:
+    explicit ProducerGuard(std::atomic<size_t>& producers)
+        : producers_(producers) {
+      producers_.fetch_add(1);
+    }
+    ~ProducerGuard() { producers_.fetch_sub(1); }
+    ProducerGuard(const ProducerGuard&) = delete;
+    ProducerGuard& operator=(const ProducerGuard&) = delete;
+
+   private:
+    std::atomic<size_t>& producers_;
+  };
+
+  void Link(Node* first, Node* last, size_t count);
+  [[nodiscard]] bool Pop(std::unique_ptr<T>& dest);
+  [[nodiscard]] bool Wait();
+};
+
+template <typename T>
+MpscQueue<T>::MpscQueue() : head_(new Node), tail_(head_.load()) {}
+
+template <typename T>
+MpscQueue<T>::~MpscQueue() {
+  Stop();
+  std::unique_ptr<T> temp;
+  while (Pop(temp)) {
+    temp.reset();
+  }
+  delete tail_;
+}
+
+template <typename T>
+void MpscQueue<T>::Link(Node* first, Node* last, size_t count) {
+  size_.fetch_add(count);
+  // The exchange orders the producers. The consumer sees the nodes when the
+  // previous node is linked to them.
+  Node* prev = head_.exchange(last);
+  prev->next.store(first);
+  if (waiting_.load() && waiting_.exchange(false)) {
+    waiting_.notify_one();
+  }
+}
+
+template <typename T>
+bool MpscQueue<T>::Put(std::unique_ptr<T>& value) {
+  // The guard is counted before the stop flag is checked, so Stop() either
+  // waits for this call or this call sees the stop.
+  ProducerGuard guard(producers_);
+  if (stop_) {
+    return false;
+  }
+  auto* node = new Node;
+  node->value = std::move(value);
+  Link(node, node, 1);
+  return true;
+}
+
+template <typename T>
+bool MpscQueue<T>::PutMany(std::vector<std::unique_ptr<T>>& values) {
+  ProducerGuard guard(producers_);
+  if (stop_) {
+    return false;
+  }
+  if (values.empty()) {
+    return true;
+  }
+  Node* first = nullptr;
+  Node* last = nullptr;
+  for (auto& value : values) {
+    auto* node = new Node;
+    node->value = std::move(value);
+    if (last == nullptr) {
+      first = node;
+    } else {
+      last->next.store(node, std::memory_order_relaxed);
+    }
+    last = node;
+  }
+  Link(first, last, values.size());
+  values.clear();
+  return true;
+}
+
+template <typename T>
+bool MpscQueue<T>::Pop(std::unique_ptr<T>& dest) {
+  Node* next = tail_->next.load();
+  if (next == nullptr) {
+    return false;
+  }
+  // The next node becomes the new stub node
+  dest = std::move(next->value);
+  delete tail_;
+  tail_ = next;
+  size_.fetch_sub(1);
+  return true;
+}
+
+template <typename T>
+bool MpscQueue<T>::Wait() {
+  while (!stop_) {
+    waiting_.store(true);
+    if (tail_->next.load() != nullptr || stop_) {
+      waiting_.store(false);
+      break;
+    }
+    waiting_.wait(true);
+  }
+  return !stop_;
+}
+
+template <typename T>
+bool MpscQueue<T>::Get(std::unique_ptr<T>& dest, bool block) {
+  if (stop_) {
+    return false;
+  }
+  if (Pop(dest)) {
+    return true;
+  }
+  return block && Wait() && Pop(dest);
+}
+
+template <typename T>
+bool MpscQueue<T>::GetAll(std::vector<std::unique_ptr<T>>& dest, bool block) {
+  if (stop_) {
+    return false;
+  }
+  if (block && tail_->next.load() == nullptr && !Wait()) {
+    return false;
+  }
+  bool found = false;
+  for (std::unique_ptr<T> value; Pop(value); found = true) {
+    dest.push_back(std::move(value));
+  }
+  return found;
+}
+
+template <typename T>
+bool MpscQueue<T>::GetRemaining(std::vector<std::unique_ptr<T>>& dest) {
+  bool found = false;
+  for (std::unique_ptr<T> value; Pop(value); found = true) {
+    dest.push_back(std::move(value));
+  }
+  return found;
+}
+
+template <typename T>
+void MpscQueue<T>::Clear() {
+  std::unique_ptr<T> temp;
+  while (Pop(temp)) {
+    temp.reset();
+  }
+}
+
+template <typename T>
+void MpscQueue<T>::Start() {
+  stop_ = false;
+}
+
+template <typename T>
+void MpscQueue<T>::Stop() {
+  stop_ = true;
+  waiting_.store(false);
+  waiting_.notify_all();  // Release any blocking Get()
+  // Wait for producers that are linking their values. Linking never blocks.
+  while (producers_.load() > 0) {
+    std::this_thread::yield();
+  }
+}
+
+}  // namespace util::log
@@ -0,0 +1,409 @@
+/*
+ * Copyright 2025 Ingemar Hedvall
+ * SPDX-License-Identifier: MIT
+ */
+
+/** \file ringqueue.h
+ * \brief Implements a thread-safe queue that stores the values in a ring.
+ */
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace util::log {
+
+/** \class RingQueue ringqueue.h "util/ringqueue.h"
+ * \brief Thread-safe queue that stores the values by value in a ring buffer.
+ *
+ * The queue has the same interface as the ThreadSafeQueue but the values
+ * are stored in a ring buffer instead of as separate heap objects. The
+ * slots in the ring are never destroyed. A value is copied or moved into an
+ * existing slot and the Get() function swaps the slot with the destination
+ * object. The consumer's old object is in this way recycled by the next
+ * producer, so objects with strings or lists reuse their memory.
+ *
+ * The ring grows when it is full. When the ring has reached its working
+ * size, the queue doesn't allocate any memory. If a maximum size is set, the
+ * ring doesn't grow beyond it. The Put(), TryPut() and Emplace() functions
+ * then drop the new value when the queue is full, while the Put() with a
+ * timeout waits for a free slot.
+ *
+ * @tparam T Type of object to store. Must be default constructible.
+ */
+template <typename T>
+class RingQueue {
+ public:
+  /** \brief Creates a queue with an initial ring size.
+   *
+   * @param capacity Initial number of slots in the ring.
+   */
+  explicit RingQueue(size_t capacity = 64);
+  virtual ~RingQueue();
+
+  RingQueue(const RingQueue&) = delete;
+  RingQueue& operator=(const RingQueue&) = delete;
+
+  /** \brief Copies a value into the end of the queue.
+   *
+   * The value is copy assigned to a recycled slot. If the queue is full,
+   * the value is dropped.
+   * @param value Value to add.
+   */
+  void Put(const T& value);
+
+  /** \brief Moves a value into the end of the queue.
+   *
+   * @param value Value to add.
+   */
+  void Put(T&& value);
+
+  /** \brief Copies a value if the queue isn't full.
+   *
+   * @param value Value to add.
+   * @return True if the value was added.
+   */
+  [[nodiscard]] bool TryPut(const T& value);
+
+  /** \brief Copies a value and waits for a free slot in a full queue.
+   *
+   * @param value Value to add.
+   * @param timeout Maximum time to wait for a free slot.
+   * @return True if the value was added.
+   */
+  [[nodiscard]] bool Put(const T& value, std::chrono::milliseconds timeout);
+
+  /** \brief Fills a recycled slot at the end of the queue.
+   *
+   * The fill function is called with a reference to the recycled object in
+   * the ring. The function is called under the queue lock and shall be short.
+   * @param fill Function with the signature void(T&).
+   */
+  template <typename Fill>
+  void Emplace(Fill&& fill);
+
+  /** \brief Fetch the first object from the queue.
+   *
+   * The first object is swapped with the destination object. The destination
+   * object's old value is recycled by the queue. The function may block until
+   * a value is available.
+   *
+   * @param dest Returning object
+   * @param block True if the function should block until a value is available.
+   * @return True if a value was returned.
+   */
+  [[nodiscard]] bool Get(T& dest, bool block);
+
+  /** \brief Fetch the first object and wait at most a timeout.
+   *
+   * @param dest Returning object
+   * @param timeout Maximum time to wait for a value.
+   * @return True if a value was returned.
+   */
+  [[nodiscard]] bool Get(T& dest, std::chrono::milliseconds timeout);
+
+  /** \brief Fetch all objects from the queue.
+   *
+   * The objects are appended to the destination list under one lock.
+   *
+   * @param dest Destination list.
+   * @param block True if the function should block until a value is available.
+   * @return True if any value was returned.
+   */
+  [[nodiscard]] bool GetAll(std::vector<T>& dest, bool block);
+
+  [[nodiscard]] bool Empty() const;      ///< Returns true if the queue is empty.
+  [[nodiscard]] size_t Size() const;     ///< Returns number of items.
+  [[nodiscard]] size_t Capacity() const; ///< Returns number of slots.
+
+  /** \brief Sets the maximum number of items in the queue.
+   *
+   * @param max_size Maximum number of items. Zero means no limit.
+   */
+  void MaxSize(size_t max_size);
+  [[nodiscard]] size_t MaxSize() const;  ///< Returns the maximum size.
+
+  /** \brief Returns the highest number of items that has been queued. */
+  [[nodiscard]] size_t HighWaterMark() const;
+
+  /** \brief Returns number of items dropped due to a full queue. */
+  [[nodiscard]] uint64_t NofDropped() const { return nof_dropped_; }
+
+  void Clear();  ///< Clears the queue.
+  void Start();  ///< Restarts the queue
+  void Stop();   ///< Stops all blocking Get() calls.
+
+ private:
+  mutable std::mutex lock_;  ///< Mutex lock for the queue.
+  std::vector<T> ring_;      ///< The slots. Never shrinks.
+  size_t first_ = 0;         ///< Index of the first value.
+  size_t size_ = 0;          ///< Number of values in the ring.
+  size_t max_size_ = 0;        ///< Maximum number of items. 0 = No limit.
+  size_t high_water_mark_ = 0; ///< Highest number of queued items.
+  std::atomic<uint64_t> nof_dropped_ = 0;  ///< Items dropped on a full queue.
+  std::atomic<bool> stop_ = false;
+  std::condition_variable queue_event_;
+  std::condition_variable space_event_;  ///< Producers waiting on a full queue.
+
+  /// Returns true if the queue is full. Requires the lock.
+  [[nodiscard]] bool IsFull() const {
+    return max_size_ > 0 && size_ >= max_size_;
+  }
+  T& NextSlot();  ///< Returns the next free slot. Requires the lock.
+  /// Returns the next free slot or null if the queue is full. Counts the drop.
+  [[nodiscard]] T* TrySlot();
+  [[nodiscard]] bool WaitForValue(std::unique_lock<std::mutex>& lock,
+                                  bool block);
+};
+
+template <typename T>
+RingQueue<T>::RingQueue(size_t capacity) : ring_(capacity > 0 ? capacity : 1) {}
+
+template <typename T>
+RingQueue<T>::~RingQueue() {
+  stop_ = true;
+  queue_event_.notify_all();    // Release any blocking Get()
+  space_event_.notify_all();    // Release any blocking Put()
+  std::lock_guard lock(lock_);  // Waiting for Get() to release
+}
+
+template <typename T>
+T& RingQueue<T>::NextSlot() {
+  if (size_ >= ring_.size()) {
+    // Double the ring and rotate the values so the first value is at index 0.
+    // A full queue never gets here, so the ring is smaller than the max size.
+    const size_t grow = ring_.size() * 2;
+    std::vector<T> temp(max_size_ > 0 ? std::min(grow, max_size_) : grow);
+    for (size_t index = 0; index < size_; ++index) {
+      std::swap(temp[index], ring_[(first_ + index) % ring_.size()]);
+    }
+    ring_.swap(temp);
+    first_ = 0;
+  }
+  T& slot = ring_[(first_ + size_) % ring_.size()];
+  ++size_;
+  if (size_ > high_water_mark_) {
+    high_water_mark_ = size_;
+  }
+  return slot;
+}
+
+template <typename T>
+T* RingQueue<T>::TrySlot() {
+  if (IsFull()) {
+    ++nof_dropped_;
+    return nullptr;
+  }
+  return &NextSlot();
+}
+
+template <typename T>
+void RingQueue<T>::Put(const T& value) {
+  static_cast<void>(TryPut(value));
+}
+
+template <typename T>
+void RingQueue<T>::Put(T&& value) {
+  if (stop_) {
+    return;
+  }
+  {
+    std::lock_guard lock(lock_);
+    T* slot = TrySlot();
+    if (slot == nullptr) {
+      return;
+    }
+    *slot = std::move(value);
+  }
+  queue_event_.notify_one();
+}
+
+template <typename T>
+bool RingQueue<T>::TryPut(const T& value) {
+  if (stop_) {
+    return false;
+  }
+  {
+    std::lock_guard lock(lock_);
+    T* slot = TrySlot();
+    if (slot == nullptr) {
+      return false;
+    }
+    *slot = value;
+  }
+  queue_event_.notify_one();
+  return true;
+}
+
+template <typename T>
+bool RingQueue<T>::Put(const T& value, std::chrono::milliseconds timeout) {
+  if (stop_) {
+    return false;
+  }
+  {
+    std::unique_lock lock(lock_);
+    space_event_.wait_for(lock, timeout,
+                          [&] { return !IsFull() || stop_.load(); });
+    if (IsFull() || stop_) {
+      return false;
+    }
+    NextSlot() = value;
+  }
+  queue_event_.notify_one();
+  return true;
+}
+
+template <typename T>
+template <typename Fill>
+void RingQueue<T>::Emplace(Fill&& fill) {
+  if (stop_) {
+    return;
+  }
+  {
+    std::lock_guard lock(lock_);
+    T* slot = TrySlot();
+    if (slot == nullptr) {
+      return;
+    }
+    fill(*slot);
+  }
+  queue_event_.notify_one();
+}
+
+template <typename T>
+bool RingQueue<T>::WaitForValue(std::unique_lock<std::mutex>& lock,
+                                bool block) {
+  if (block) {
+    queue_event_.wait(lock, [&] { return size_ > 0 || stop_.load(); });
+  }
+  return size_ > 0 && !stop_;
+}
+
+template <typename T>
+bool RingQueue<T>::Get(T& dest, bool block) {
+  if (stop_) {
+    return false;
+  }
+  std::unique_lock lock(lock_);
+  if (!WaitForValue(lock, block)) {
+    return false;
+  }
+  std::swap(dest, ring_[first_]);
+  first_ = (first_ + 1) % ring_.size();
+  --size_;
+  if (max_size_ > 0) {
+    space_event_.notify_one();
+  }
+  return true;
+}
+
+template <typename T>
+bool RingQueue<T>::Get(T& dest, std::chrono::milliseconds timeout) {
+  if (stop_) {
+    return false;
+  }
+  std::unique_lock lock(lock_);
+  queue_event_.wait_for(lock, timeout,
+                        [&] { return size_ > 0 || stop_.load(); });
+  if (size_ == 0 || stop_) {
+    return false;
+  }
+  std::swap(dest, ring_[first_]);
+  first_ = (first_ + 1) % ring_.size();
+  --size_;
+  if (max_size_ > 0) {
+    space_event_.notify_one();
+  }
+  return true;
+}
+
+template <typename T>
+bool RingQueue<T>::GetAll(std::vector<T>& dest, bool block) {
+  if (stop_) {
+    return false;
+  }
+  std::unique_lock lock(lock_);
+  if (!WaitForValue(lock, block)) {
+    return false;
+  }
+  dest.reserve(dest.size() + size_);
+  for (; size_ > 0; --size_) {
+    dest.push_back(std::move(ring_[first_]));
+    first_ = (first_ + 1) % ring_.size();
+  }
+  if (max_size_ > 0) {
+    space_event_.notify_all();
+  }
+  return true;
+}
+
+template <typename T>
+bool RingQueue<T>::Empty() const {
+  std::lock_guard lock(lock_);
+  return size_ == 0;
+}
+
+template <typename T>
+size_t RingQueue<T>::Size() const {
+  std::lock_guard lock(lock_);
+  return size_;
+}
+
+template <typename T>
+size_t RingQueue<T>::Capacity() const {
+  std::lock_guard lock(lock_);
+  return ring_.size();
+}
+
+template <typename T>
+void RingQueue<T>::MaxSize(size_t max_size) {
+  {
+    std::lock_guard lock(lock_);
+    max_size_ = max_size;
+  }
+  space_event_.notify_all();
+}
+
+template <typename T>
+size_t RingQueue<T>::MaxSize() const {
+  std::lock_guard lock(lock_);
+  return max_size_;
+}
+
+template <typename T>
+size_t RingQueue<T>::HighWaterMark() const {
+  std::lock_guard lock(lock_);
+  return high_water_mark_;
+}
+
+template <typename T>
+void RingQueue<T>::Clear() {
+  // The slots are kept for reuse
+  std::lock_guard lock(lock_);
+  first_ = 0;
+  size_ = 0;
+  space_event_.notify_all();
+}
+
+template <typename T>
+void RingQueue<T>::Start() {
+  stop_ = false;
+  if (!Empty()) {
+    queue_event_.notify_one();  // Release any blocking Get()
+  }
+}
+
+template <typename T>
+void RingQueue<T>::Stop() {
+  stop_ = true;
+  queue_event_.notify_all();  // Release any blocking Get()
+  space_event_.notify_all();  // Release any blocking Put()
+}
+
+}  // namespace util::log
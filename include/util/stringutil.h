@@ -5,7 +5,9 @@
 #pragma once
 
 #include <cstdint>
+#include <ostream>
 #include <string>
+#include <string_view>
 
 namespace util::string {
 /** \brief Compare strings by ignoring case.
@@ -93,4 +95,33 @@ bool WildcardMatch(const std::string &text, const std::string &wildcard,
  * @return The double value as text
  */
 [[nodiscard]] std::string DoubleToString(double value);
+
+/** \brief Type erased argument to the '{}' format functions.
+ *
+ * Support struct that references one argument and a function that writes
+ * the argument to a stream.
+ */
+struct FormatArg {
+  const void *value = nullptr; ///< Pointer to the argument.
+  void (*write)(std::ostream &, const void *) = nullptr; ///< Writer.
+
+  /** \brief Writes an argument by its stream operator. */
+  template <typename T>
+  static void WriteArg(std::ostream &stream, const void *value) {
+    stream << *static_cast<const T *>(value);
+  }
+};
+
+/** \brief Writes a text with '{}' placeholders to a stream.
+ *
+ * The placeholders follow the std::format syntax but each argument is
+ * written by its stream operator. Any format specification inside the braces
+ * is ignored. Use '{{' and '}}' for braces.
+ * @param stream Destination stream.
+ * @param format Format string.
+ * @param arg_list Arguments.
+ * @param nof_args Number of arguments.
+ */
+void WriteFormat(std::ostream &stream, std::string_view format,
+                 const FormatArg *arg_list, size_t nof_args);
 }  // namespace util::string
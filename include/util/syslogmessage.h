@@ -79,6 +79,9 @@ class SyslogMessage {
   SyslogMessage();
 
   SyslogMessage(const SyslogMessage&) = default; ///< Default copy constructor
+  SyslogMessage(SyslogMessage&&) = default; ///< Default move constructor
+  SyslogMessage& operator=(const SyslogMessage&) = default; ///< Copy assignment
+  SyslogMessage& operator=(SyslogMessage&&) = default; ///< Move assignment
 
   /** \brief Constructor that converts a log message,
    *
@@ -9,10 +9,14 @@
  * Simple thread-safe queue.
  */
 #pragma once
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <vector>
 
 namespace util::log {
 
@@ -22,6 +26,11 @@ namespace util::log {
  * Implements a thread-safe queue based upon a std::queue. The queue
  * uses stores the objects with smart pointers.
  *
+ * By default, the queue has no size limit. If a maximum size is set, the
+ * Put() and TryPut() functions drop the new value when the queue is full,
+ * while the Put() with a timeout waits for a free place. The dropped values
+ * and the highest number of queued values are counted.
+ *
  * @tparam T Type of object to store.
  */
 template <typename T>
@@ -35,11 +44,40 @@ class ThreadSafeQueue {
 
   /** \brief Adds a value at the end of the queue.
    *
-   * Add a value last in the queue.
+   * Add a value last in the queue. If the queue is full, the value is
+   * dropped.
    * @param value
    */
   void Put(std::unique_ptr<T>& value);
 
+  /** \brief Adds a value if the queue isn't full.
+   *
+   * The value is kept by the caller if it wasn't added. A full queue counts
+   * the value as dropped.
+   * @param value Value to add.
+   * @return True if the value was added.
+   */
+  [[nodiscard]] bool TryPut(std::unique_ptr<T>& value);
+
+  /** \brief Adds a value and waits for a free place in a full queue.
+   *
+   * The value is kept by the caller if it wasn't added within the timeout.
+   * @param value Value to add.
+   * @param timeout Maximum time to wait for a free place.
+   * @return True if the value was added.
+   */
+  [[nodiscard]] bool Put(std::unique_ptr<T>& value,
+                         std::chrono::milliseconds timeout);
+
+  /** \brief Adds many values at the end of the queue.
+   *
+   * All values are added under one lock and the waiting calls are notified
+   * once. The input list is cleared. Values that doesn't fit in a full queue
+   * are dropped.
+   * @param values Values to add.
+   */
+  void PutMany(std::vector<std::unique_ptr<T>>& values);
+
   /** \brief Fetch the first object from the queue.
    *
    * Gets the first object in the queue. The function may block until a value is
@@ -51,6 +89,26 @@ class ThreadSafeQueue {
    */
   [[nodiscard]] bool Get(std::unique_ptr<T>& dest, bool block);
 
+  /** \brief Fetch the first object and wait at most a timeout.
+   *
+   * @param dest Returning object
+   * @param timeout Maximum time to wait for a value.
+   * @return True if a value was returned.
+   */
+  [[nodiscard]] bool Get(std::unique_ptr<T>& dest,
+                         std::chrono::milliseconds timeout);
+
+  /** \brief Fetch all objects from the queue.
+   *
+   * Swaps out the whole queue under one lock and appends the objects to the
+   * destination list. The function may block until a value is available.
+   *
+   * @param dest Destination list.
+   * @param block True if the function should block until a value is available.
+   * @return True if any value was returned.
+   */
+  [[nodiscard]] bool GetAll(std::vector<std::unique_ptr<T>>& dest, bool block);
+
   /** \brief Returns true if the queue is empty.
    *
    * Returns true if the queue is empty.
@@ -65,6 +123,19 @@ class ThreadSafeQueue {
    */
   [[nodiscard]] size_t Size() const;
 
+  /** \brief Sets the maximum number of items in the queue.
+   *
+   * @param max_size Maximum number of items. Zero means no limit.
+   */
+  void MaxSize(size_t max_size);
+  [[nodiscard]] size_t MaxSize() const;  ///< Returns the maximum size.
+
+  /** \brief Returns the highest number of items that has been queued. */
+  [[nodiscard]] size_t HighWaterMark() const;
+
+  /** \brief Returns number of items dropped due to a full queue. */
+  [[nodiscard]] uint64_t NofDropped() const { return nof_dropped_; }
+
   void Clear();  ///< Clears the queue.
   void Start();  ///< Restarts the queue
   void Stop();   ///< Stops all blocking Get() calls.
@@ -76,26 +147,106 @@ class ThreadSafeQueue {
       false;  ///< Set to true to indicate that any blocking call shall end.
   std::condition_variable
       queue_event_;  ///< Condition to speed up waiting calls.
+  std::condition_variable
+      space_event_;  ///< Condition for producers waiting on a full queue.
+  size_t max_size_ = 0;        ///< Maximum number of items. 0 = No limit.
+  size_t high_water_mark_ = 0; ///< Highest number of queued items.
+  std::atomic<uint64_t> nof_dropped_ = 0;  ///< Items dropped on a full queue.
+
+  /// Returns true if the queue is full. Requires the lock.
+  [[nodiscard]] bool IsFull() const {
+    return max_size_ > 0 && queue_.size() >= max_size_;
+  }
+  /// Adds a value to a non-full queue. Requires the lock.
+  void Push(std::unique_ptr<T>& value);
+  /// Removes the first item. Requires the lock.
+  void Pop(std::unique_ptr<T>& dest);
 };
 
 template <typename T>
 ThreadSafeQueue<T>::~ThreadSafeQueue() {
   stop_ = true;
   queue_event_.notify_one();    // Release any blocking Get()
+  space_event_.notify_all();    // Release any blocking Put()
   std::lock_guard lock(lock_);  // Waiting for Get() to release
   while (!queue_.empty()) {
     queue_.pop();
   }
 }
 
+template <typename T>
+void ThreadSafeQueue<T>::Push(std::unique_ptr<T>& value) {
+  queue_.push(std::move(value));
+  if (queue_.size() > high_water_mark_) {
+    high_water_mark_ = queue_.size();
+  }
+}
+
+template <typename T>
+void ThreadSafeQueue<T>::Pop(std::unique_ptr<T>& dest) {
+  dest = std::move(queue_.front());
+  queue_.pop();
+  if (max_size_ > 0) {
+    space_event_.notify_one();
+  }
+}
+
 template <typename T>
 void ThreadSafeQueue<T>::Put(std::unique_ptr<T>& value) {
+  if (!TryPut(value)) {
+    value.reset();  // Dropped
+  }
+}
+
+template <typename T>
+bool ThreadSafeQueue<T>::TryPut(std::unique_ptr<T>& value) {
   if (stop_) {
-    return;
+    return false;
   }
   std::lock_guard lock(lock_);
-  queue_.push(std::move(value));
+  if (IsFull()) {
+    ++nof_dropped_;
+    return false;
+  }
+  Push(value);
   queue_event_.notify_one();
+  return true;
+}
+
+template <typename T>
+bool ThreadSafeQueue<T>::Put(std::unique_ptr<T>& value,
+                             std::chrono::milliseconds timeout) {
+  if (stop_) {
+    return false;
+  }
+  std::unique_lock lock(lock_);
+  space_event_.wait_for(lock, timeout,
+                        [&] { return !IsFull() || stop_.load(); });
+  if (IsFull() || stop_) {
+    return false;
+  }
+  Push(value);
+  queue_event_.notify_one();
+  return true;
+}
+
+template <typename T>
+void ThreadSafeQueue<T>::PutMany(std::vector<std::unique_ptr<T>>& values) {
+  if (stop_ || values.empty()) {
+    return;
+  }
+  {
+    std::lock_guard lock(lock_);
+    for (auto& value : values) {
+      if (IsFull()) {
+        ++nof_dropped_;
+      } else {
+        Push(value);
+      }
+    }
+  }
+  values.clear();
+  queue_event_.notify_all();
 }
 
 template <typename T>
@@ -110,15 +261,57 @@ bool ThreadSafeQueue<T>::Get(std::unique_ptr<T>& dest, bool block) {
     if (queue_.empty() || stop_) {
       return false;
     }
-    dest = std::move(queue_.front());
-    queue_.pop();
+    Pop(dest);
   } else {
     std::lock_guard lock(lock_);
     if (queue_.empty() || stop_) {
       return false;
     }
-    dest = std::move(queue_.front());
-    queue_.pop();
+    Pop(dest);
+  }
+  return true;
+}
+
+template <typename T>
+bool ThreadSafeQueue<T>::Get(std::unique_ptr<T>& dest,
+                             std::chrono::milliseconds timeout) {
+  if (stop_) {
+    return false;
+  }
+  std::unique_lock lock(lock_);
+  queue_event_.wait_for(lock, timeout,
+                        [&] { return !queue_.empty() || stop_.load(); });
+  if (queue_.empty() || stop_) {
+    return false;
+  }
+  Pop(dest);
+  return true;
+}
+
+template <typename T>
+bool ThreadSafeQueue<T>::GetAll(std::vector<std::unique_ptr<T>>& dest,
+                                bool block) {
+  if (stop_) {
+    return false;
+  }
+  std::queue<std::unique_ptr<T>> temp;
+  {
+    std::unique_lock lock(lock_);
+    if (block) {
+      queue_event_.wait(lock, [&] { return !queue_.empty() || stop_.load(); });
+    }
+    if (queue_.empty() || stop_) {
+      return false;
+    }
+    queue_.swap(temp);
+    if (max_size_ > 0) {
+      space_event_.notify_all();
+    }
+  }
+  // The objects are moved outside the lock
+  dest.reserve(dest.size() + temp.size());
+  for (; !temp.empty(); temp.pop()) {
+    dest.push_back(std::move(temp.front()));
   }
   return true;
 }
@@ -134,6 +327,28 @@ size_t ThreadSafeQueue<T>::Size() const {
   std::lock_guard lock(lock_);
   return queue_.size();
 }
+
+template <typename T>
+void ThreadSafeQueue<T>::MaxSize(size_t max_size) {
+  {
+    std::lock_guard lock(lock_);
+    max_size_ = max_size;
+  }
+  space_event_.notify_all();
+}
+
+template <typename T>
+size_t ThreadSafeQueue<T>::MaxSize() const {
+  std::lock_guard lock(lock_);
+  return max_size_;
+}
+
+template <typename T>
+size_t ThreadSafeQueue<T>::HighWaterMark() const {
+  std::lock_guard lock(lock_);
+  return high_water_mark_;
+}
+
 template <typename T>
 void ThreadSafeQueue<T>::Clear() {
   std::unique_ptr<T> temp;
@@ -153,6 +368,7 @@ template <typename T>
 void ThreadSafeQueue<T>::Stop() {
   stop_ = true;
   queue_event_.notify_one();  // Release any blocking Get()
+  space_event_.notify_all();  // Release any blocking Put()
 }
 
 }  // namespace util::log
\ No newline at end of file
@@ -62,6 +62,18 @@ std::string GetLocalDateTime(TimeStamp timestamp = SystemClock::now());
  */
 std::string GetLocalTimestampWithMs(TimeStamp timestamp = SystemClock::now());
 
+/** \brief Appends a local timestamp with milliseconds to a text.
+ *
+ * Same format as GetLocalTimestampWithMs() (YYYY-MM-DD hh:mm:ss.ms) but
+ * intended for log sinks that format many timestamps. The date and time
+ * text is cached per thread for the current second, so only the millisecond
+ * digits are updated for timestamps within the same second.
+ *
+ * @param [in] timestamp System clock timestamp (UTC)
+ * @param [out] text Text that the timestamp is appended to.
+ */
+void AppendLocalTimestampWithMs(TimeStamp timestamp, std::string &text);
+
 /** \brief Converts a UTC timestamp to a local date and time string in the YYYY-MM-DD hh:mm:ss.us
  *
  * The function converts a system clock timestamp (UTC) to a date and time string including microseconds.
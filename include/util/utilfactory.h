@@ -15,6 +15,7 @@
 #include "util/ilisten.h"
 #include "util/ilistenclient.h"
 #include "util/ilogger.h"
+#include "util/iocontextpool.h"
 #include "util/isyslogserver.h"
 #include "util/isupervisemaster.h"
 
@@ -25,6 +26,18 @@ namespace util {
  */
 class UtilFactory {
  public:
+  /** \brief Creates a thread pool that runs a shared I/O context.
+   *
+   * The network objects are normally created with an own I/O context and
+   * an own worker thread. Objects created with a pool share the threads of
+   * the pool instead. The pool is deleted when the last object that uses it
+   * is deleted.
+   * @param nof_threads Number of threads in the pool.
+   * @return Shared pointer to the pool.
+   */
+  static std::shared_ptr<IoContextPool> CreateIoContextPool(
+      size_t nof_threads = 2);
+
   /** \brief Creates different types of syslog servers
    *
    * Creates a syslog server. Choose between UDP, TLS or TCP servers.
@@ -34,6 +47,18 @@ class UtilFactory {
   static std::unique_ptr<syslog::ISyslogServer> CreateSyslogServer(
       syslog::SyslogServerType type);
 
+  /** \brief Creates a syslog server that uses a shared context pool.
+   *
+   * Same as above but the server uses the threads of the pool. A null pool
+   * creates a server with an own thread.
+   * @param type Type of syslog protocol.
+   * @param pool Shared context pool.
+   * @return Smart pointer to a syslog server.
+   */
+  static std::unique_ptr<syslog::ISyslogServer> CreateSyslogServer(
+      syslog::SyslogServerType type,
+      const std::shared_ptr<IoContextPool> &pool);
+
   /** \brief Creates a pre-defined log source.
    *
    *  Creates a pre-defined log source. Choose between console, file, listen or
@@ -48,6 +73,19 @@ class UtilFactory {
   static std::unique_ptr<log::ILogger> CreateLogger(
       log::LogType type, const std::vector<std::string> &arg_list);
 
+  /** \brief Creates a log source that uses a shared context pool.
+   *
+   * Only the syslog source uses the pool. The other sources are created as
+   * above.
+   * @param type Type of log source.
+   * @param arg_list Extra arguments
+   * @param pool Shared context pool.
+   * @return Smart pointer to a log source.
+   */
+  static std::unique_ptr<log::ILogger> CreateLogger(
+      log::LogType type, const std::vector<std::string> &arg_list,
+      const std::shared_ptr<IoContextPool> &pool);
+
   /** \brief Creates a listen object.
    *
    * Creates a listen object. It only exist 3 basic objects to create.
@@ -97,13 +135,31 @@ class UtilFactory {
    * shall be used when putting messages from a proxy onto a console window. This
    * object is mainly used for testing.
    *
-   * @param type Select between ListenProxyType,ListenServerType'
-   * or ListenConsoleType
+   * The ListenMuxServerType object forwards many shared memories over one
+   * TCP/IP port. The share name is not used. Add the share names with
+   * IListen::AddChannel() instead.
+   *
+   * @param type Select between ListenProxyType,ListenServerType',
+   * ListenConsoleType or ListenMuxServerType
    * @param share_name Unique share name or empty string.
    * @return A smart pointer to a listen object.
    */
   static std::unique_ptr<log::IListen> CreateListen(
       log::TypeOfListen type, const std::string &share_name);
+
+  /** \brief Creates a listen object that uses a shared context pool.
+   *
+   * The listen server and the multiplexed server use the threads of the
+   * pool. The other types are created as above.
+   * @param type Type of listen object.
+   * @param share_name Unique share name or empty string.
+   * @param pool Shared context pool.
+   * @return A smart pointer to a listen object.
+   */
+  static std::unique_ptr<log::IListen> CreateListen(
+      log::TypeOfListen type, const std::string &share_name,
+      const std::shared_ptr<IoContextPool> &pool);
+
   /** \brief Creates a listen client.
    *
    * Creates a TCP/IP listen client object.
@@ -114,6 +170,17 @@ class UtilFactory {
   static std::unique_ptr<log::IListenClient> CreateListenClient(
       const std::string &host, uint16_t port);
 
+  /** \brief Creates a listen client that uses a shared context pool.
+   *
+   * @param host Host name
+   * @param port TCP/IP port to connect to.
+   * @param pool Shared context pool.
+   * @return Smart pointer to a IListenClient.
+   */
+  static std::unique_ptr<log::IListenClient> CreateListenClient(
+      const std::string &host, uint16_t port,
+      const std::shared_ptr<IoContextPool> &pool);
+
   /** \brief Create a supervise master object.
    *
    * Creates a supervise
@@ -122,6 +189,17 @@ class UtilFactory {
    */
   static std::unique_ptr<supervise::ISuperviseMaster> CreateSuperviseMaster(
       supervise::TypeOfSuperviseMaster type);
+
+  /** \brief Creates a supervise master that uses a shared context pool.
+   *
+   * Only the process master uses the pool.
+   * @param type Type of supervise master.
+   * @param pool Shared context pool.
+   * @return Smart pointer to a supervise master.
+   */
+  static std::unique_ptr<supervise::ISuperviseMaster> CreateSuperviseMaster(
+      supervise::TypeOfSuperviseMaster type,
+      const std::shared_ptr<IoContextPool> &pool);
 };
 
 }  // namespace util
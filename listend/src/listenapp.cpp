@@ -10,6 +10,7 @@
 #include <util/ixmlfile.h>
 #include <util/logconfig.h>
 #include <util/logstream.h>
+#include <util/stringutil.h>
 #include <util/utilfactory.h>
 
 using namespace std::filesystem;
@@ -17,9 +18,72 @@ using namespace std::chrono_literals;
 
 using namespace util::log;
 using namespace util::xml;
+using namespace util::string;
+
+namespace {
+
+ListenOverflowPolicy StringToOverflowPolicy(const std::string& policy) {
+  if (IEquals(policy, "DropNewest")) {
+    return ListenOverflowPolicy::DropNewest;
+  }
+  if (IEquals(policy, "Disconnect")) {
+    return ListenOverflowPolicy::Disconnect;
+  }
+  return ListenOverflowPolicy::DropOldest;
+}
+
+ListenQueueFormat StringToQueueFormat(const std::string& format) {
+  if (IEquals(format, "RingQueue")) {
+    return ListenQueueFormat::RingQueue;
+  }
+  if (IEquals(format, "RecordQueue")) {
+    return ListenQueueFormat::RecordQueue;
+  }
+  return ListenQueueFormat::MutexQueue;
+}
+
+}  // namespace
 
 namespace util {
 
+void ListenApp::ReadListenConfig(const IXmlNode& node, IListen& listen) const {
+  const auto name = node.Property<std::string>("Name", "");
+  const auto description = node.Property<std::string>("Description", "");
+  const auto pre_text = node.Property<std::string>("PreText", "");
+  const auto host_name = node.Property<std::string>("HostName", "127.0.0.1");
+  const auto port = node.Property<uint16_t>("Port", 0);
+  const auto queue_limit = node.Property<size_t>("QueueLimit", kQueueLimit);
+  const auto overflow_policy =
+      node.Property<std::string>("OverflowPolicy", "DropOldest");
+  const auto batch_messages = node.Property<bool>("BatchMessages", false);
+  const auto queue_format =
+      node.Property<std::string>("QueueFormat", "MutexQueue");
+  const auto queue_capacity = node.Property<size_t>("QueueCapacity", 256);
+
+  listen.Name(name);
+  listen.Description(description);
+  listen.PreText(pre_text);
+  listen.HostName(host_name);
+  listen.Port(port);
+  listen.QueueLimit(queue_limit, StringToOverflowPolicy(overflow_policy));
+  listen.BatchMessages(batch_messages);
+  listen.ShareQueueFormat(StringToQueueFormat(queue_format), queue_capacity);
+
+  const auto* list = node.GetNode("LogLevelList");
+  IXmlNode::ChildList log_list;
+  if (list != nullptr) {
+    list->GetChildList(log_list);
+  }
+  for (const auto* level : log_list) {
+    if (!level->IsTagName("LogLevel")) {
+      continue;
+    }
+    const auto number = level->Attribute<uint64_t>("level", 0);
+    const auto menu_text = level->Value<std::string>();
+    listen.SetLogLevelText(number, menu_text);
+  }
+}
+
 void ListenApp::AddAllKnownServers() {
   // Add System Logger
   {
@@ -29,6 +93,7 @@ void ListenApp::AddAllKnownServers() {
     system_log->Description("Logs all system messages");
     system_log->HostName("127.0.0.1");
     system_log->Port(kFreePort++);
+    system_log->QueueLimit(kQueueLimit);
     system_log->SetLogLevelText(0, "Show all log messages");
     system_log->SetLogLevelText(1, "Hide trace messages");
     system_log->SetLogLevelText(2, "Hide trace/debug messages");
@@ -44,6 +109,7 @@ void ListenApp::AddAllKnownServers() {
     sqlite_log->Description("Logs all SQL calls");
     sqlite_log->HostName("127.0.0.1");
     sqlite_log->Port(kFreePort++);
+    sqlite_log->QueueLimit(kQueueLimit);
     sqlite_log->SetLogLevelText(0, "Show all SQL calls");
     kServerList.push_back(std::move(sqlite_log));
   }
@@ -56,6 +122,7 @@ void ListenApp::AddAllKnownServers() {
     mqtt_log->Description("Logs all MQTT calls");
     mqtt_log->HostName("127.0.0.1");
     mqtt_log->Port(kFreePort++);
+    mqtt_log->QueueLimit(kQueueLimit);
     mqtt_log->SetLogLevelText(0, "Show basic MQTT messages");
     mqtt_log->SetLogLevelText(1, "Show MQTT publish messages");
     mqtt_log->SetLogLevelText(2, "Show MQTT subscribe messages");
@@ -71,6 +138,8 @@ void ListenApp::AddAllKnownServers() {
     mqtt_log->Description("Logs all message on a bus message queue");
     mqtt_log->HostName("127.0.0.1");
     mqtt_log->Port(kFreePort++);
+    mqtt_log->QueueLimit(kQueueLimit);
+    mqtt_log->BatchMessages(true);  // High-rate and repetitive hex texts
     mqtt_log->SetLogLevelText(0, "Show all messages");
     mqtt_log->SetLogLevelText(1, "Show CAN messages");
     mqtt_log->SetLogLevelText(2, "Show LIN messages");
@@ -157,36 +226,33 @@ bool ListenApp::OnInit() {
     for (const auto* node : node_list) {
       if (node->IsTagName("ListenServer")) {
         const auto share_name = node->Property<std::string>("ShareName", "");
-        const auto name = node->Property<std::string>("Name", "");
-        const auto description = node->Property<std::string>("Description", "");
-        const auto pre_text = node->Property<std::string>("PreText", "");
-        const auto host_name =
-            node->Property<std::string>("HostName", "127.0.0.1");
-        const auto port = node->Property<uint16_t>("Port", 0);
-
         auto listen = UtilFactory::CreateListen(TypeOfListen::ListenServerType,
                                                 share_name);
         if (!listen) {
           continue;
         }
-        listen->Name(name);
-        listen->Description(description);
-        listen->PreText(pre_text);
-        listen->HostName(host_name);
-        listen->Port(port);
-
-        const auto* list = node->GetNode("LogLevelList");
-        IXmlNode::ChildList log_list;
-        if (list != nullptr) {
-          list->GetChildList(log_list);
+        ReadListenConfig(*node, *listen);
+        kServerList.push_back(std::move(listen));
+      } else if (node->IsTagName("ListenMuxServer")) {
+        // All channels share one port and one thread pool
+        auto listen = UtilFactory::CreateListen(
+            TypeOfListen::ListenMuxServerType, "");
+        if (!listen) {
+          continue;
         }
-        for (const auto* level : log_list) {
-          if (!level->IsTagName("LogLevel")) {
+        ReadListenConfig(*node, *listen);
+        IXmlNode::ChildList channel_list;
+        node->GetChildList(channel_list);
+        for (const auto* channel_node : channel_list) {
+          if (!channel_node->IsTagName("ListenServer")) {
             continue;
           }
-          const auto number = level->Attribute<uint64_t>("level", 0);
-          const auto menu_text = level->Value<std::string>();
-          listen->SetLogLevelText(number, menu_text);
+          const auto share_name =
+              channel_node->Property<std::string>("ShareName", "");
+          auto* channel = listen->AddChannel(share_name);
+          if (channel != nullptr) {
+            ReadListenConfig(*channel_node, *channel);
+          }
         }
         kServerList.push_back(std::move(listen));
       }
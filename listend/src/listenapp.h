@@ -7,6 +7,7 @@
 
 #include <util/consoleapp.h>
 #include <util/ilisten.h>
+#include <util/ixmlnode.h>
 #include <util/listenconfig.h>
 #include <memory>
 
@@ -21,10 +22,19 @@ class ListenApp : public ConsoleApp {
  private:
   std::vector<std::unique_ptr<log::IListen>> kServerList;
   uint16_t kFreePort = 42511;
+  size_t kQueueLimit = 10'000; ///< Max queued messages per viewer.
 
   std::unique_ptr<log::ListenConfig> master;
 
   void AddAllKnownServers();
+
+  /** \brief Configures a listen server from an XML node.
+   *
+   * Used for both listen servers and multiplexed servers and their channels.
+   * @param node XML node with the properties.
+   * @param listen Listen object to configure.
+   */
+  void ReadListenConfig(const xml::IXmlNode& node, log::IListen& listen) const;
 };
 
 }  // namespace util
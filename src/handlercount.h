@@ -0,0 +1,82 @@
+/*
+ * Copyright 2025 Ingemar Hedvall
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <atomic>
+#include <boost/asio.hpp>
+#include <future>
+#include <memory>
+
+namespace util {
+
+/** \brief Counts the handlers that an object has queued on a context.
+ *
+ * An object that uses the shared context of an IoContextPool cannot stop
+ * the context when it is stopped. Instead, each handler holds a token and
+ * the object waits until all tokens are released before its members are
+ * deleted. The count is shared with the tokens, so a token may outlive the
+ * counter object.
+ */
+class HandlerCount final {
+ public:
+  using Token = std::shared_ptr<void>;
+
+  HandlerCount() : count_(std::make_shared<std::atomic<size_t>>(0)) {}
+
+  HandlerCount(const HandlerCount&) = delete;
+  HandlerCount& operator=(const HandlerCount&) = delete;
+
+  /** \brief Returns a token that a handler should capture. */
+  [[nodiscard]] Token Acquire() const {
+    count_->fetch_add(1);
+    return {nullptr, [count = count_](void*) {
+              if (count->fetch_sub(1) == 1) {
+                count->notify_all();
+              }
+            }};
+  }
+
+  /** \brief Returns number of handlers that still holds a token. */
+  [[nodiscard]] size_t Count() const { return count_->load(); }
+
+  /** \brief Waits until all tokens are released.
+   *
+   * Must not be called by a handler that holds a token.
+   */
+  void Wait() const {
+    for (auto count = count_->load(); count > 0; count = count_->load()) {
+      count_->wait(count);
+    }
+  }
+
+ private:
+  std::shared_ptr<std::atomic<size_t>> count_;
+};
+
+/** \brief Calls a function on a strand and waits for the call.
+ *
+ * Used when an object on a shared context closes its sockets and timers.
+ * The function is called directly if the context is stopped.
+ * @param context Context that runs the strand.
+ * @param strand Strand of the object.
+ * @param func Function to call.
+ */
+template <typename Strand, typename Func>
+void RunOnStrand(boost::asio::io_context& context, const Strand& strand,
+                 Func&& func) {
+  if (context.stopped()) {
+    func();
+    return;
+  }
+  std::promise<void> done;
+  boost::asio::post(strand, [&] {
+    func();
+    done.set_value();
+  });
+  done.get_future().wait();
+}
+
+}  // namespace util
@@ -4,27 +4,142 @@
  */
 #include "util/ilisten.h"
 
+#include <algorithm>
+#include <array>
 #include <cstdarg>
 #include <cstdio>
-#include <iomanip>
-#include <sstream>
 
 #include "listenproxy.h"
 #include "listenserver.h"
 #include "util/stringutil.h"
 #include "util/timestamp.h"
+
+#if defined(__SSSE3__) || defined(__AVX__)
+#include <tmmintrin.h>
+#define UTIL_HEX_SIMD 1
+#else
+#define UTIL_HEX_SIMD 0
+#endif
+
+namespace {
+
+constexpr std::array<char, 16> kHexTable = {'0', '1', '2', '3', '4', '5',
+                                            '6', '7', '8', '9', 'a', 'b',
+                                            'c', 'd', 'e', 'f'};
+
+#if UTIL_HEX_SIMD
+// 16 bytes gives 48 characters, 'hh hh ...', stored as 3 x 16 characters.
+// Each output block is shuffled from the character pairs of byte 0-7 and
+// byte 8-15. Index 0x80 clears the character, which then is OR:ed with the
+// space mask.
+constexpr std::array<int8_t, 6 * 16> MakeSimdShuffle() {
+  std::array<int8_t, 6 * 16> list = {};
+  for (size_t block = 0; block < 3; ++block) {
+    for (size_t half = 0; half < 2; ++half) {
+      for (size_t index = 0; index < 16; ++index) {
+        const size_t pos = (16 * block) + index;
+        const size_t byte = pos / 3;
+        const size_t offset = pos % 3;
+        const bool use = offset < 2 && byte / 8 == half;
+        list[(32 * block) + (16 * half) + index] =
+            use ? static_cast<int8_t>((2 * (byte % 8)) + offset)
+                : static_cast<int8_t>(0x80);
+      }
+    }
+  }
+  return list;
+}
+
+constexpr std::array<char, 3 * 16> MakeSimdSpaces() {
+  std::array<char, 3 * 16> list = {};
+  for (size_t pos = 0; pos < list.size(); ++pos) {
+    list[pos] = pos % 3 == 2 ? ' ' : '\0';
+  }
+  return list;
+}
+
+alignas(16) constexpr auto kSimdShuffle = MakeSimdShuffle();
+alignas(16) constexpr auto kSimdSpaces = MakeSimdSpaces();
+#endif
+
+// Most texts fit into the stack buffer. Longer texts are formatted a second
+// time into a string with the exact size.
+std::string FormatVaList(const char *format_text, va_list arg_list) {
+  if (format_text == nullptr) {
+    return {};
+  }
+  std::array<char, 256> buffer{};
+  va_list copy_list{};
+  va_copy(copy_list, arg_list);
+  const int length =
+      vsnprintf(buffer.data(), buffer.size(), format_text, copy_list);
+  va_end(copy_list);
+  if (length <= 0) {
+    return {};
+  }
+  if (static_cast<size_t>(length) < buffer.size()) {
+    return {buffer.data(), static_cast<size_t>(length)};
+  }
+  std::string text(static_cast<size_t>(length), '\0');
+  vsnprintf(text.data(), text.size() + 1, format_text, arg_list);
+  return text;
+}
+
+}  // namespace
+
 namespace util::log {
 
 std::string IListen::ParseHex(const std::vector<uint8_t> &buffer) {
-  std::ostringstream temp;
-  for (uint8_t byte : buffer) {
-    if (!temp.str().empty()) {
-      temp << " ";
+  std::string temp(HexSize(buffer.size()), '\0');
+  ParseHex(buffer.data(), buffer.size(), temp.data(), temp.size());
+  return temp;
+}
+
+size_t IListen::ParseHex(const uint8_t *data, size_t size, char *dest,
+                         size_t dest_size) {
+  if (data == nullptr || dest == nullptr) {
+    return 0;
+  }
+  // Number of bytes that fits. The last byte doesn't need a space.
+  const size_t nof_bytes = std::min(size, (dest_size + 1) / 3);
+  size_t index = 0;
+  char *out = dest;
+#if UTIL_HEX_SIMD
+  // The SIMD block writes a trailing space, so it cannot handle the last byte
+  const __m128i table =
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(kHexTable.data()));
+  const __m128i nibble_mask = _mm_set1_epi8(0x0F);
+  const auto *masks = reinterpret_cast<const __m128i *>(kSimdShuffle.data());
+  const auto *spaces = reinterpret_cast<const __m128i *>(kSimdSpaces.data());
+  for (; index + 16 < nof_bytes; index += 16, out += 48) {
+    const __m128i bytes =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + index));
+    const __m128i high = _mm_shuffle_epi8(
+        table, _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble_mask));
+    const __m128i low =
+        _mm_shuffle_epi8(table, _mm_and_si128(bytes, nibble_mask));
+    // Character pairs for byte 0-7 and 8-15
+    const __m128i first = _mm_unpacklo_epi8(high, low);
+    const __m128i second = _mm_unpackhi_epi8(high, low);
+    for (size_t block = 0; block < 3; ++block) {
+      const __m128i chars =
+          _mm_or_si128(_mm_shuffle_epi8(first, _mm_load_si128(masks + 2 * block)),
+                       _mm_shuffle_epi8(second,
+                                        _mm_load_si128(masks + 2 * block + 1)));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 16 * block),
+                       _mm_or_si128(chars, _mm_load_si128(spaces + block)));
     }
-    temp << std::setw(2) << std::setfill('0') << std::hex
-         << static_cast<uint16_t>(byte);
   }
-  return temp.str();
+#endif
+  for (; index < nof_bytes; ++index) {
+    const uint8_t byte = data[index];
+    *out++ = kHexTable[byte >> 4];
+    *out++ = kHexTable[byte & 0x0F];
+    if (index + 1 < nof_bytes) {
+      *out++ = ' ';
+    }
+  }
+  return static_cast<size_t>(out - dest);
 }
 
 void IListen::SetLogLevelText(uint64_t level, const std::string &menu_text) {
@@ -47,14 +162,30 @@ void IListen::ListenText(const char *format_text, ...) {
     return;
   }
 
-  std::string temp(2000, '\0');
-  va_list lsArg{};
-  va_start(lsArg, format_text);
-  vsnprintf(temp.data(), temp.size(), format_text, lsArg);
-  temp.back() = '\0';
-  va_end(lsArg);
-  std::string trimmed = temp.c_str();  // NOLINT
-  AddMessage(time::TimeStampToNs(), pre_text_, trimmed);
+  va_list arg_list{};
+  va_start(arg_list, format_text);
+  const std::string text = FormatVaList(format_text, arg_list);
+  va_end(arg_list);
+  AddMessage(time::TimeStampToNs(), pre_text_, text);
+}
+
+void IListen::ListenString(size_t level, const std::string &text) {
+  if (!IsEnabled(level)) {
+    return;
+  }
+  AddMessage(time::TimeStampToNs(), pre_text_, text);
+}
+
+void IListen::ListenText(size_t level, const char *format_text, ...) {
+  if (!IsEnabled(level)) {
+    return;
+  }
+
+  va_list arg_list{};
+  va_start(arg_list, format_text);
+  const std::string text = FormatVaList(format_text, arg_list);
+  va_end(arg_list);
+  AddMessage(time::TimeStampToNs(), pre_text_, text);
 }
 
 void IListen::ListenTextEx(uint64_t ns1970, const std::string &pre_text,
@@ -63,14 +194,22 @@ void IListen::ListenTextEx(uint64_t ns1970, const std::string &pre_text,
     return;
   }
 
-  std::string temp(2000, '0');
-  va_list lsArg{};
-  va_start(lsArg, format_text);
-  vsnprintf(temp.data(), temp.size(), format_text, lsArg);
-  temp.back() = '\0';
-  va_end(lsArg);
-  std::string trimmed = temp.c_str();  // NOLINT
-  AddMessage(ns1970, pre_text, trimmed);
+  va_list arg_list{};
+  va_start(arg_list, format_text);
+  const std::string text = FormatVaList(format_text, arg_list);
+  va_end(arg_list);
+  AddMessage(ns1970, pre_text, text);
+}
+
+std::string IListen::FormatArgList(std::string_view format,
+                                   const detail::ListenFormatArg *arg_list,
+                                   size_t nof_args) {
+  // The stream is reused by the thread as it is expensive to create
+  thread_local std::ostringstream stream;
+  stream.str({});
+  stream.clear();
+  util::string::WriteFormat(stream, format, arg_list, nof_args);
+  return stream.str();
 }
 
 void IListen::ListenTransmit(uint64_t ns1970, const std::string &pre_text,
@@ -103,4 +242,8 @@ ListenStream IListen::ListenOut() { return ListenStream(*this); }
 
 size_t IListen::NofConnections() const { return 0; }
 
+uint64_t IListen::NofDroppedMessages() const { return 0; }
+
+IListen *IListen::AddChannel(const std::string &) { return nullptr; }
+
 }  // end namespace util::log
\ No newline at end of file
@@ -10,4 +10,8 @@ namespace util::log {
 IListenClient::IListenClient(const std::string& host_name, uint16_t port)
     : host_name_(host_name), port_(port) {}
 
+void IListenClient::SendLogLevel(uint32_t, uint64_t) {}
+
+void IListenClient::Subscribe(const std::vector<std::string>&) {}
+
 }  // namespace util::log
\ No newline at end of file
@@ -7,14 +7,25 @@
 
 namespace util::log {
 
+ILogger::~ILogger() { AttachSeverityCount(nullptr); }
+
 bool ILogger::HasLogFile() const { return false; }
 
 std::string ILogger::Filename() const { return {}; }
 
 void ILogger::EnableSeverityLevel(LogSeverity severity, bool enable) {
   const auto level = static_cast<uint8_t>(severity);
-  if (level < severity_filter_.size()) {
-    severity_filter_[level] = enable;
+  if (level >= severity_filter_.size()) {
+    return;
+  }
+  std::lock_guard lock(severity_lock_);
+  const bool enabled = severity_filter_[level].exchange(enable);
+  if (severity_count_ != nullptr && enabled != enable) {
+    if (enable) {
+      ++(*severity_count_)[level];
+    } else {
+      --(*severity_count_)[level];
+    }
   }
 }
 
@@ -24,6 +35,32 @@ bool ILogger::IsSeverityLevelEnabled(LogSeverity severity) const {
                                          : false;
 }
 
+void ILogger::AttachSeverityCount(SeverityCount *count) {
+  std::lock_guard lock(severity_lock_);
+  if (count == severity_count_) {
+    return;
+  }
+  for (size_t level = 0; level < severity_filter_.size(); ++level) {
+    if (!severity_filter_[level]) {
+      continue;
+    }
+    if (severity_count_ != nullptr) {
+      --(*severity_count_)[level];
+    }
+    if (count != nullptr) {
+      ++(*count)[level];
+    }
+  }
+  severity_count_ = count;
+}
+
 void ILogger::Stop() {}
 
+void ILogger::AddSharedMessage(
+    const std::shared_ptr<const LogMessage> &message) {
+  if (message) {
+    AddLogMessage(*message);
+  }
+}
+
 }  // namespace util::log
\ No newline at end of file
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2025 Ingemar Hedvall
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "util/iocontextpool.h"
+
+#include <algorithm>
+#include <boost/asio.hpp>
+
+#include "util/logstream.h"
+
+using namespace boost::asio;
+using namespace util::log;
+
+namespace util {
+
+IoContextPool::IoContextPool(size_t nof_threads)
+    : context_(std::make_unique<io_context>()) {
+  work_ = std::make_shared<executor_work_guard<io_context::executor_type>>(
+      make_work_guard(*context_));
+  const auto threads = std::max(nof_threads, size_t{1});
+  for (size_t thread = 0; thread < threads; ++thread) {
+    worker_list_.emplace_back(&IoContextPool::WorkerTask, this);
+  }
+}
+
+IoContextPool::~IoContextPool() {
+  // The components keeps the pool alive, so no handlers should be pending.
+  work_.reset();
+  context_->stop();
+  for (auto& worker : worker_list_) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+  worker_list_.clear();
+}
+
+io_context& IoContextPool::Context() { return *context_; }
+
+void IoContextPool::WorkerTask() {
+  // A handler that throws shall not stop the thread.
+  while (!context_->stopped()) {
+    try {
+      context_->run();
+    } catch (const std::exception& error) {
+      LOG_ERROR() << "Context pool error. Error: " << error.what();
+    }
+  }
+}
+
+}  // namespace util
@@ -10,22 +10,25 @@ namespace util::syslog {
 void ISyslogServer::Address(const std::string &address) { address_ = address; }
 
 void ISyslogServer::Start() {
-  msg_queue_ = std::make_unique<log::ThreadSafeQueue<SyslogMessage>>();
+  msg_queue_ = std::make_unique<log::RingQueue<SyslogMessage>>();
+  msg_queue_->MaxSize(max_messages_);
 }
 
 void ISyslogServer::Stop() { msg_queue_.reset(); }
 
 void ISyslogServer::AddMsg(const SyslogMessage &msg) {
   if (msg_queue_) {
-    auto temp = std::make_unique<SyslogMessage>(msg);
-    msg_queue_->Put(temp);
+    msg_queue_->Put(msg);  // Copied into a recycled slot
   }
 }
 
 std::optional<SyslogMessage> ISyslogServer::GetMsg(bool block) {
-  std::unique_ptr<SyslogMessage> msg;
-  const auto get = msg_queue_ ? msg_queue_->Get(msg, block) : false;
-  return get && msg ? *msg : std::optional<SyslogMessage>();
+  SyslogMessage msg;
+  return GetMsg(msg, block) ? std::move(msg) : std::optional<SyslogMessage>();
+}
+
+bool ISyslogServer::GetMsg(SyslogMessage& msg, bool block) {
+  return msg_queue_ ? msg_queue_->Get(msg, block) : false;
 }
 
 size_t ISyslogServer::NofConnections() const { return 0; }
@@ -17,19 +17,48 @@ namespace util::log::detail {
 
 ListenClient::ListenClient(const std::string &host_name, uint16_t port)
     : IListenClient(host_name, port),
-      retry_timer_(context_),
-      lookup_(context_) {
+      own_context_(std::make_unique<io_context>()),
+      context_(*own_context_),
+      strand_(make_strand(context_)),
+      lookup_(context_),
+      retry_timer_(context_) {
   worker_thread_ = std::thread(&ListenClient::WorkerTask, this);
 }
 
+ListenClient::ListenClient(const std::string &host_name, uint16_t port,
+                           std::shared_ptr<IoContextPool> pool)
+    : IListenClient(host_name, port),
+      pool_(std::move(pool)),
+      context_(pool_->Context()),
+      strand_(make_strand(context_)),
+      lookup_(context_),
+      retry_timer_(context_) {
+  post(strand_, [this, token = handlers_.Acquire()] { DoLookup(); });
+}
+
 ListenClient::~ListenClient() {
-  Close();
-  if (!context_.stopped()) {
-    context_.stop();
-  }
-  if (worker_thread_.joinable()) {
-    worker_thread_.join();
+  stop_ = true;
+  if (own_context_) {
+    Close();
+    if (!context_.stopped()) {
+      context_.stop();
+    }
+    if (worker_thread_.joinable()) {
+      worker_thread_.join();
+    }
+    return;
   }
+  // The context is shared, so the pending operations are cancelled instead
+  util::RunOnStrand(context_, strand_, [&] {
+    lookup_.cancel();
+    retry_timer_.cancel();
+    if (socket_) {
+      error_code dummy;
+      socket_->shutdown(ip::tcp::socket::shutdown_both, dummy);
+      socket_->close(dummy);
+    }
+  });
+  handlers_.Wait();
 }
 
 void ListenClient::WorkerTask() {
@@ -44,9 +73,14 @@ void ListenClient::WorkerTask() {
 
 void ListenClient::DoLookup() {
   connected_ = false;
+  if (stop_) {
+    return;
+  }
   lookup_.async_resolve(
       ip::tcp::v4(), HostName(), std::to_string(Port()),
-      [&](const error_code &error, ip::tcp::resolver::results_type result) {
+      bind_executor(strand_, [this, token = handlers_.Acquire()](
+                                 const error_code &error,
+                                 ip::tcp::resolver::results_type result) {
         if (error) {
           LOG_DEBUG() << "Lookup error. Host: " << HostName() << ":" << Port()
                       << ",Error: (" << error << ") " << error.message();
@@ -61,30 +95,36 @@ void ListenClient::DoLookup() {
             DoConnect();
           }
         }
-      });
+      }));
 }
 
 void ListenClient::DoRetryWait() {
 
   connected_ = false;
+  if (stop_) {
+    Close();
+    return;
+  }
   retry_timer_.expires_after(5s);
-  retry_timer_.async_wait([&](const error_code error) {
-    if (error) {
-      LOG_ERROR() << "Retry timer error. Error: " << error.message();
-    }
-    DoLookup();
-  });
+  retry_timer_.async_wait(bind_executor(
+      strand_, [this, token = handlers_.Acquire()](const error_code error) {
+        if (error) {
+          LOG_ERROR() << "Retry timer error. Error: " << error.message();
+        }
+        DoLookup();
+      }));
   Close();
 }
 
 void ListenClient::DoConnect() {
-  bool connected = false;
   if (current_endpoint_ == endpoints_.cend()) {
     DoRetryWait();
     return;
   }
 
-  socket_->async_connect(*current_endpoint_, [&](const error_code error) {
+  socket_->async_connect(*current_endpoint_, bind_executor(
+      strand_, [this, token = handlers_.Acquire()](const error_code error) {
+    bool connected = false;
     if (error.failed() || !socket_->is_open()) {
       LOG_ERROR() << "Connect error. Error: " << error.message();
       connected = false;
@@ -94,9 +134,15 @@ void ListenClient::DoConnect() {
     if (!connected) {
       DoRetryWait();
     } else {
+      // A new connection starts without any base time or channel
+      last_ns1970_ = 0;
+      channel_ = 0;
+      channel_ns1970_list_.clear();
+      SendVersion();
+      SendSubscribe();
       DoReadHeader();
     }
-  });
+  }));
 
 }
 
@@ -107,7 +153,8 @@ void ListenClient::DoReadHeader() {  // NOLINT
   }
   connected_ = true;
   async_read(*socket_, buffer(header_data_),
-             [&](const error_code &error, size_t bytes) {  // NOLINT
+             bind_executor(strand_, [this, token = handlers_.Acquire()](
+                 const error_code &error, size_t bytes) {  // NOLINT
                if (error && error == error::eof) {
                  LOG_INFO() << "Connection closed by remote";
                  DoRetryWait();
@@ -130,7 +177,7 @@ void ListenClient::DoReadHeader() {  // NOLINT
                    DoReadHeader();
                  }
                }
-             });
+             }));
 }
 
 void ListenClient::DoReadBody() {  // NOLINT
@@ -139,7 +186,8 @@ void ListenClient::DoReadBody() {  // NOLINT
     return;
   }
   async_read(*socket_, buffer(body_data_),
-             [&](const error_code &error, size_t bytes) {  // NOLINT
+             bind_executor(strand_, [this, token = handlers_.Acquire()](
+                 const error_code &error, size_t bytes) {  // NOLINT
                if (error) {
                  LOG_ERROR() << "Listen body error. Error: " << error.message();
                  DoRetryWait();
@@ -151,7 +199,7 @@ void ListenClient::DoReadBody() {  // NOLINT
                  HandleMessage();
                  DoReadHeader();
                }
-             });
+             }));
 }
 
 void ListenClient::HandleMessage() {
@@ -170,11 +218,38 @@ void ListenClient::HandleMessage() {
     case ListenMessageType::TextMessage: {
       auto msg = std::make_unique<ListenTextMessage>();
       msg->FromHeaderBuffer(header_data_);
-      msg->FromBodyBuffer(body_data_);
+      if (msg->version_ >= ListenMessage::kCompactVersion) {
+        if (!msg->FromCompactBuffer(body_data_, last_ns1970_)) {
+          LOG_ERROR() << "Invalid compact text message.";
+          break;
+        }
+      } else {
+        msg->FromBodyBuffer(body_data_);
+      }
+      last_ns1970_ = msg->ns1970_;
       message = std::move(msg);
       break;
     }
 
+    case ListenMessageType::TextBatch: {
+      // Unpacks the batch into normal text messages
+      ListenBatchMessage batch;
+      batch.FromHeaderBuffer(header_data_);
+      if (!batch.FromBodyBuffer(body_data_)) {
+        LOG_ERROR() << "Invalid text batch message.";
+        break;
+      }
+      std::vector<std::unique_ptr<ListenMessage>> text_list;
+      text_list.reserve(batch.text_list_.size());
+      for (auto& text : batch.text_list_) {
+        last_ns1970_ = text->ns1970_;
+        text->channel_ = channel_;
+        text_list.push_back(std::move(text));
+      }
+      msg_queue_.PutMany(text_list);  // One lock for the whole batch
+      break;
+    }
+
     case ListenMessageType::LogLevel: {
       auto msg = std::make_unique<LogLevelMessage>();
       msg->FromHeaderBuffer(header_data_);
@@ -182,6 +257,28 @@ void ListenClient::HandleMessage() {
       message = std::move(msg);
       break;
     }
+
+    case ListenMessageType::Channel: {
+      ListenChannelMessage msg;
+      if (msg.FromBodyBuffer(body_data_)) {
+        SelectChannel(msg.channel_);
+      } else {
+        LOG_ERROR() << "Invalid channel message.";
+      }
+      break;
+    }
+
+    case ListenMessageType::Subscribe: {
+      auto msg = std::make_unique<ListenSubscribeMessage>();
+      msg->FromHeaderBuffer(header_data_);
+      if (msg->FromBodyBuffer(body_data_)) {
+        message = std::move(msg);
+      } else {
+        LOG_ERROR() << "Invalid subscribe message.";
+      }
+      break;
+    }
+
     default: {
       LOG_DEBUG() << "Unknown message type. Type: "
                   << static_cast<int>(header.type_);
@@ -189,10 +286,21 @@ void ListenClient::HandleMessage() {
     }
   }
   if (message) {
+    message->channel_ = channel_;
     msg_queue_.Put(message);
   }
 }
 
+void ListenClient::SelectChannel(uint32_t channel) {
+  if (channel == channel_) {
+    return;
+  }
+  channel_ns1970_list_[channel_] = last_ns1970_;
+  channel_ = channel;
+  const auto itr = channel_ns1970_list_.find(channel);
+  last_ns1970_ = itr != channel_ns1970_list_.cend() ? itr->second : 0;
+}
+
 void ListenClient::Close() {
   if (socket_ && socket_->is_open() && connected_) {
     error_code shutdown_error;
@@ -215,6 +323,71 @@ void ListenClient::SendLogLevel(uint64_t level) {
   write(*socket_, boost::asio::buffer(data), error);
 }
 
+void ListenClient::SendLogLevel(uint32_t channel, uint64_t level) {
+  // One write so the channel and log level messages are not separated
+  ListenChannelMessage select;
+  select.channel_ = channel;
+  std::vector<uint8_t> data;
+  select.ToBuffer(data);
+
+  LogLevelMessage msg;
+  msg.log_level_ = level;
+  std::vector<uint8_t> level_data;
+  msg.ToBuffer(level_data);
+  data.insert(data.end(), level_data.cbegin(), level_data.cend());
+
+  // The socket is only used on the strand
+  post(strand_, [this, token = handlers_.Acquire(), data = std::move(data)] {
+    if (!socket_ || !socket_->is_open() || !connected_) {
+      return;
+    }
+    boost::system::error_code error;
+    write(*socket_, boost::asio::buffer(data), error);
+  });
+}
+
+void ListenClient::Subscribe(const std::vector<std::string> &share_names) {
+  {
+    std::lock_guard lock(subscribe_lock_);
+    subscribe_ = true;
+    subscribe_list_ = share_names;
+  }
+  // If not connected, the subscription is sent when connected. The server
+  // ignores a repeated subscription.
+  post(strand_, [this, token = handlers_.Acquire()] {
+    if (socket_ && socket_->is_open() && connected_) {
+      SendSubscribe();
+    }
+  });
+}
+
+void ListenClient::SendSubscribe() {
+  ListenSubscribeMessage msg;
+  {
+    std::lock_guard lock(subscribe_lock_);
+    if (!subscribe_) {
+      return;
+    }
+    for (const auto &share_name : subscribe_list_) {
+      msg.channel_list_.emplace(share_name, 0);
+    }
+  }
+  std::vector<uint8_t> data;
+  msg.ToBuffer(data);
+  boost::system::error_code error;
+  write(*socket_, boost::asio::buffer(data), error);
+}
+
+void ListenClient::SendVersion() {
+  // Older servers ignore log level text messages from a client.
+  LogLevelTextMessage msg;
+  msg.version_ = ListenMessage::kChannelVersion;
+  std::vector<uint8_t> data;
+  msg.ToBuffer(data);
+  boost::system::error_code error;
+  write(*socket_, boost::asio::buffer(data), error);
+}
+
 bool ListenClient::GetMsg(std::unique_ptr<ListenMessage> &message) {
   return msg_queue_.Get(message, false);
 }
@@ -3,14 +3,19 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <boost/asio.hpp>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <vector>
 
+#include "handlercount.h"
 #include "listenmessage.h"
 #include "util/ilistenclient.h"
+#include "util/iocontextpool.h"
 
 namespace util::log::detail {
 
@@ -18,6 +23,15 @@ class ListenClient : public IListenClient {
  public:
   ListenClient(const std::string &host_name, uint16_t port);
 
+  /** \brief Creates a client that runs on a shared context.
+   *
+   * @param host_name Host name of the server.
+   * @param port Server port.
+   * @param pool Shared context pool.
+   */
+  ListenClient(const std::string &host_name, uint16_t port,
+               std::shared_ptr<IoContextPool> pool);
+
   ~ListenClient() override;
 
   ListenClient() = delete;
@@ -29,9 +43,17 @@ class ListenClient : public IListenClient {
   [[nodiscard]] bool GetMsg(std::unique_ptr<ListenMessage> &message) override;
 
   void SendLogLevel(uint64_t level) override;
+  void SendLogLevel(uint32_t channel, uint64_t level) override;
+  void Subscribe(const std::vector<std::string> &share_names) override;
 
  private:
-  boost::asio::io_context context_;
+  util::HandlerCount handlers_;
+  std::shared_ptr<IoContextPool> pool_;  ///< Shared context pool or null.
+  std::unique_ptr<boost::asio::io_context> own_context_;
+  boost::asio::io_context &context_;
+  /// Serializes the handlers if the context is run by more than one thread.
+  boost::asio::strand<boost::asio::io_context::executor_type> strand_;
+  std::atomic<bool> stop_ = false;
   boost::asio::ip::tcp::resolver lookup_;
   boost::asio::steady_timer retry_timer_;
   std::unique_ptr<boost::asio::ip::tcp::socket> socket_;
@@ -43,6 +65,14 @@ class ListenClient : public IListenClient {
   ThreadSafeQueue<ListenMessage> msg_queue_;
 
   std::thread worker_thread_;
+  uint64_t last_ns1970_ = 0;  ///< Base time for compact text messages.
+
+  std::mutex subscribe_lock_;
+  bool subscribe_ = false;  ///< True if connected to a multiplexed server.
+  std::vector<std::string> subscribe_list_;  ///< Subscribed share names.
+  uint32_t channel_ = 0;  ///< Channel of the received messages.
+  /// Base time of the channels that are not current.
+  std::map<uint32_t, uint64_t> channel_ns1970_list_;
 
   void WorkerTask();
 
@@ -59,6 +89,25 @@ class ListenClient : public IListenClient {
   void DoReadBody();
 
   void HandleMessage();
+
+  /** \brief Tells the server which protocol version the client supports.
+   *
+   * Sends an empty log level text message with the batch version number.
+   */
+  void SendVersion();
+
+  /** \brief Sends the subscribed share names.
+   *
+   * Only sent if Subscribe() has been called.
+   */
+  void SendSubscribe();
+
+  /** \brief Changes the channel of the received messages.
+   *
+   * Keeps the base time of the compact text messages for each channel.
+   * @param channel New channel number.
+   */
+  void SelectChannel(uint32_t channel);
 };
 
 }  // namespace util::log::detail
@@ -44,11 +44,11 @@ bool ListenConsole::Stop() {
 }
 
 void ListenConsole::WorkerTask() {
-  SharedListenMessage msg;
+  ListenTextMessage msg;
   while (!stop_thread_) {
     const auto get = share_mem_queue_->Get(msg, true);
     if (get) {
-      AddMessage(msg.ns1970, msg.pre_text, msg.text);
+      AddMessage(msg.ns1970_, msg.pre_text_, msg.text_);
     }
   }
 
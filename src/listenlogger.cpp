@@ -11,13 +11,9 @@ namespace util::log::detail {
 ListenLogger::ListenLogger() : listen_proxy_("LISLOG") { ShowLocation(false); }
 
 void ListenLogger::AddLogMessage(const LogMessage &message) {
-  if (!listen_proxy_.IsActive() || !IsSeverityLevelEnabled(message.severity)) {
-    return;
-  }
   // Log Level 0 = Show all, 1 = Show Debug.., 2 = Show Info..
-  const auto log_level = listen_proxy_.LogLevel();
-  const auto severity = static_cast<size_t>(message.severity);
-  if (log_level > severity) {
+  if (!IsSeverityLevelEnabled(message.severity) ||
+      !listen_proxy_.IsEnabled(static_cast<size_t>(message.severity))) {
     return;
   }
   const auto time = util::time::TimeStampToNs(message.timestamp);
@@ -5,13 +5,150 @@
 #include "listenmessage.h"
 
 #include <boost/endian/buffers.hpp>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <zlib.h>
 
 using namespace boost::endian;
 
+namespace {
+
+void PutVarInt(std::vector<uint8_t> &dest, uint64_t value) {
+  while (value >= 0x80) {
+    dest.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  dest.push_back(static_cast<uint8_t>(value));
+}
+
+bool GetVarInt(const std::vector<uint8_t> &source, size_t &index,
+               uint64_t &value) {
+  value = 0;
+  for (int shift = 0; shift < 64 && index < source.size(); shift += 7) {
+    const uint8_t byte = source[index++];
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Zig-zag encoding so small negative deltas also becomes short varints.
+uint64_t ZigZag(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+int64_t UnZigZag(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+bool GetString(const std::vector<uint8_t> &source, size_t &index,
+               std::string &dest) {
+  uint64_t size = 0;
+  if (!GetVarInt(source, index, size) || size > source.size() - index) {
+    return false;
+  }
+  dest.assign(reinterpret_cast<const char *>(source.data()) + index, size);
+  index += size;
+  return true;
+}
+
+enum class BatchCompression : uint8_t {
+  None = 0,
+  Zlib = 1
+};
+
+}  // namespace
+
 namespace util::log::detail {
 
+// The original layout is shared with older processes.
+static_assert(offsetof(SharedListenQueue, locker) == 0);
+static_assert(offsetof(SharedListenQueue, message_semaphore) ==
+              sizeof(boost::interprocess::interprocess_recursive_mutex));
+static_assert(offsetof(SharedListenQueue, active) ==
+              offsetof(SharedListenQueue, message_semaphore) +
+                  sizeof(boost::interprocess::interprocess_semaphore));
+static_assert(offsetof(SharedListenQueue, log_level) ==
+              offsetof(SharedListenQueue, active) + 1);
+static_assert(offsetof(SharedListenQueue, nof_messages) ==
+              offsetof(SharedListenQueue, active) + 2);
+static_assert(offsetof(SharedListenQueue, queue_in) ==
+              offsetof(SharedListenQueue, active) + 4);
+static_assert(offsetof(SharedListenQueue, queue_out) ==
+              offsetof(SharedListenQueue, active) + 5);
+static_assert(offsetof(SharedListenQueue, queue) ==
+              offsetof(SharedListenQueue, active) + 8);
+static_assert(sizeof(SharedListenMessage) == 320);
+static_assert(offsetof(SharedQueueHeader, base) == 0);
+static_assert(offsetof(SharedQueueHeader, magic) == sizeof(SharedListenQueue));
+
 SharedListenQueue::SharedListenQueue() : message_semaphore(0) {}
 
+SharedQueueHeader *SharedQueueHeader::FromMemory(void *address, size_t size) {
+  if (address == nullptr || size < sizeof(SharedQueueHeader)) {
+    return nullptr;
+  }
+  auto *header = static_cast<SharedQueueHeader *>(address);
+  return header->magic == kMagic ? header : nullptr;
+}
+
+SharedListenRing::SharedListenRing(uint64_t nof_slots)
+    : capacity(RoundCapacity(nof_slots)), mask(capacity - 1) {
+  header.format = SharedQueueFormat::RingQueue;
+  auto *slots = Slots();
+  for (uint64_t index = 0; index < capacity; ++index) {
+    auto *slot = new (slots + index) SharedListenSlot;
+    slot->sequence = index;
+  }
+}
+
+SharedListenSlot *SharedListenRing::Slots() {
+  return reinterpret_cast<SharedListenSlot *>(this + 1);
+}
+
+size_t SharedListenRing::MemorySize(uint64_t nof_slots) {
+  return sizeof(SharedListenRing) +
+         (RoundCapacity(nof_slots) * sizeof(SharedListenSlot));
+}
+
+uint64_t SharedListenRing::RoundCapacity(uint64_t nof_slots) {
+  uint64_t capacity = 2;
+  while (capacity < nof_slots && capacity < (1ULL << 20)) {
+    capacity <<= 1;
+  }
+  return capacity;
+}
+
+SharedListenRecordRing::SharedListenRecordRing(uint64_t nof_bytes)
+    : capacity(RoundCapacity(nof_bytes)), mask(capacity - 1) {
+  header.format = SharedQueueFormat::RecordQueue;
+  memset(Buffer(), 0, capacity);
+}
+
+uint8_t *SharedListenRecordRing::Buffer() {
+  return reinterpret_cast<uint8_t *>(this + 1);
+}
+
+uint64_t SharedListenRecordRing::MaxRecordSize() const {
+  return capacity / 4;
+}
+
+size_t SharedListenRecordRing::MemorySize(uint64_t nof_bytes) {
+  return sizeof(SharedListenRecordRing) + RoundCapacity(nof_bytes);
+}
+
+uint64_t SharedListenRecordRing::RoundCapacity(uint64_t nof_bytes) {
+  uint64_t capacity = 64 * 1024;
+  while (capacity < nof_bytes && capacity < (1ULL << 30)) {
+    capacity <<= 1;
+  }
+  return capacity;
+}
+
 void ListenMessage::ToBuffer(std::vector<uint8_t> &dest) {
   if (dest.size() < 8 + body_size_) {
     dest.resize(8 + body_size_, 0);
@@ -25,6 +162,12 @@ void ListenMessage::ToBuffer(std::vector<uint8_t> &dest) {
   memcpy(dest.data() + 4, body_size.data(), 4);
 }
 
+ListenFrame ListenMessage::ToFrame() {
+  auto frame = std::make_shared<std::vector<uint8_t>>();
+  ToBuffer(*frame);
+  return frame;
+}
+
 void ListenMessage::FromHeaderBuffer(const std::array<uint8_t, 8> &source) {
   little_uint16_buf_at type;
   little_uint16_buf_at version;
@@ -122,6 +265,7 @@ ListenTextMessage::ListenTextMessage(const SharedListenMessage &msg)
 
 void ListenTextMessage::ToBuffer(std::vector<uint8_t> &dest) {
   uint32_t index = 8 + 8 + (8 + pre_text_.size()) + (8 + text_.size());
+  version_ = 0;
   body_size_ = index - 8;
   dest.resize(index, 0);
 
@@ -195,6 +339,49 @@ void ListenTextMessage::FromBodyBuffer(const std::vector<uint8_t> &source) {
   }
 }
 
+void ListenTextMessage::ToCompactBuffer(std::vector<uint8_t> &dest,
+                                        uint64_t base_ns1970) {
+  dest.resize(8);
+  dest.reserve(8 + 3 * 10 + pre_text_.size() + text_.size());
+  AppendCompactBody(dest, base_ns1970);
+
+  version_ = kCompactVersion;
+  body_size_ = static_cast<uint32_t>(dest.size() - 8);
+  ListenMessage::ToBuffer(dest);
+}
+
+void ListenTextMessage::AppendCompactBody(std::vector<uint8_t> &dest,
+                                          uint64_t base_ns1970) const {
+  PutVarInt(dest, ZigZag(static_cast<int64_t>(ns1970_ - base_ns1970)));
+  PutVarInt(dest, pre_text_.size());
+  dest.insert(dest.end(), pre_text_.cbegin(), pre_text_.cend());
+  PutVarInt(dest, text_.size());
+  dest.insert(dest.end(), text_.cbegin(), text_.cend());
+}
+
+bool ListenTextMessage::FromCompactBuffer(const std::vector<uint8_t> &source,
+                                          uint64_t base_ns1970) {
+  size_t index = 0;
+  return FromCompactBuffer(source, index, base_ns1970);
+}
+
+bool ListenTextMessage::FromCompactBuffer(const std::vector<uint8_t> &source,
+                                          size_t &index,
+                                          uint64_t base_ns1970) {
+  uint64_t delta = 0;
+  if (!GetVarInt(source, index, delta)) {
+    return false;
+  }
+  ns1970_ = base_ns1970 + static_cast<uint64_t>(UnZigZag(delta));
+  return GetString(source, index, pre_text_) && GetString(source, index, text_);
+}
+
+ListenFrame ListenTextMessage::ToCompactFrame(uint64_t base_ns1970) {
+  auto frame = std::make_shared<std::vector<uint8_t>>();
+  ToCompactBuffer(*frame, base_ns1970);
+  return frame;
+}
+
 LogLevelMessage::LogLevelMessage() { type_ = ListenMessageType::LogLevel; }
 
 void LogLevelMessage::ToBuffer(std::vector<uint8_t> &dest) {
@@ -218,4 +405,167 @@ void LogLevelMessage::FromBodyBuffer(const std::vector<uint8_t> &source) {
   log_level_ = level.value();
 }
 
+ListenBatchMessage::ListenBatchMessage() {
+  type_ = ListenMessageType::TextBatch;
+  version_ = kBatchVersion;
+}
+
+bool ListenBatchMessage::FitsInBatch(const ListenTextMessage &text) {
+  return text.pre_text_.size() + text.text_.size() <= kMaxTextSize;
+}
+
+void ListenBatchMessage::ToBuffer(std::vector<uint8_t> &dest) {
+  std::vector<uint8_t> block;
+  uint64_t base_ns1970 = 0;
+  size_t nof_texts = 0;
+  for (const auto &text : text_list_) {
+    if (text) {
+      text->AppendCompactBody(block, base_ns1970);
+      base_ns1970 = text->ns1970_;
+      ++nof_texts;
+    }
+  }
+
+  // Body: Nof texts, compression, block size and the (compressed) block.
+  dest.resize(8);
+  PutVarInt(dest, nof_texts);
+  const size_t compression_index = dest.size();
+  dest.push_back(static_cast<uint8_t>(BatchCompression::None));
+  PutVarInt(dest, block.size());
+
+  const size_t block_index = dest.size();
+  auto max_size = compressBound(static_cast<uLong>(block.size()));
+  dest.resize(block_index + max_size);
+  const int result =
+      compress2(dest.data() + block_index, &max_size, block.data(),
+                static_cast<uLong>(block.size()), Z_BEST_SPEED);
+  if (result == Z_OK && max_size < block.size()) {
+    dest[compression_index] = static_cast<uint8_t>(BatchCompression::Zlib);
+    dest.resize(block_index + max_size);
+  } else {
+    dest.resize(block_index);
+    dest.insert(dest.end(), block.cbegin(), block.cend());
+  }
+
+  version_ = kBatchVersion;
+  body_size_ = static_cast<uint32_t>(dest.size() - 8);
+  ListenMessage::ToBuffer(dest);
+}
+
+bool ListenBatchMessage::FromBodyBuffer(const std::vector<uint8_t> &source) {
+  size_t index = 0;
+  uint64_t nof_texts = 0;
+  uint64_t block_size = 0;
+  if (!GetVarInt(source, index, nof_texts) || nof_texts > kMaxTexts ||
+      index >= source.size()) {
+    return false;
+  }
+  const auto compression = static_cast<BatchCompression>(source[index++]);
+  if (!GetVarInt(source, index, block_size) || block_size > kMaxBlockSize) {
+    return false;
+  }
+
+  std::vector<uint8_t> block;
+  switch (compression) {
+    case BatchCompression::None:
+      block.assign(source.cbegin() + static_cast<std::ptrdiff_t>(index),
+                   source.cend());
+      break;
+
+    case BatchCompression::Zlib: {
+      // Sanity check. The zlib compression ratio is at most 1032:1.
+      if (block_size > (source.size() - index) * 1032 + 64) {
+        return false;
+      }
+      block.resize(block_size);
+      auto dest_size = static_cast<uLongf>(block_size);
+      const int result =
+          uncompress(block.data(), &dest_size, source.data() + index,
+                     static_cast<uLong>(source.size() - index));
+      if (result != Z_OK || dest_size != block_size) {
+        return false;
+      }
+      break;
+    }
+
+    default:
+      return false;
+  }
+
+  text_list_.clear();
+  size_t block_index = 0;
+  uint64_t base_ns1970 = 0;
+  for (uint64_t count = 0; count < nof_texts; ++count) {
+    auto text = std::make_unique<ListenTextMessage>();
+    if (!text->FromCompactBuffer(block, block_index, base_ns1970)) {
+      return false;
+    }
+    base_ns1970 = text->ns1970_;
+    text_list_.push_back(std::move(text));
+  }
+  return true;
+}
+
+ListenChannelMessage::ListenChannelMessage() {
+  type_ = ListenMessageType::Channel;
+  version_ = kChannelVersion;
+}
+
+void ListenChannelMessage::ToBuffer(std::vector<uint8_t> &dest) {
+  dest.resize(8);
+  PutVarInt(dest, channel_);
+  version_ = kChannelVersion;
+  body_size_ = static_cast<uint32_t>(dest.size() - 8);
+  ListenMessage::ToBuffer(dest);
+}
+
+bool ListenChannelMessage::FromBodyBuffer(const std::vector<uint8_t> &source) {
+  size_t index = 0;
+  uint64_t channel = 0;
+  if (!GetVarInt(source, index, channel) || channel > UINT32_MAX) {
+    return false;
+  }
+  channel_ = static_cast<uint32_t>(channel);
+  return true;
+}
+
+ListenSubscribeMessage::ListenSubscribeMessage() {
+  type_ = ListenMessageType::Subscribe;
+  version_ = kChannelVersion;
+}
+
+void ListenSubscribeMessage::ToBuffer(std::vector<uint8_t> &dest) {
+  // Body: Nof channels and for each channel, number and share name.
+  dest.resize(8);
+  PutVarInt(dest, channel_list_.size());
+  for (const auto &[share_name, channel] : channel_list_) {
+    PutVarInt(dest, channel);
+    PutVarInt(dest, share_name.size());
+    dest.insert(dest.end(), share_name.cbegin(), share_name.cend());
+  }
+  version_ = kChannelVersion;
+  body_size_ = static_cast<uint32_t>(dest.size() - 8);
+  ListenMessage::ToBuffer(dest);
+}
+
+bool ListenSubscribeMessage::FromBodyBuffer(
+    const std::vector<uint8_t> &source) {
+  size_t index = 0;
+  uint64_t nof_channels = 0;
+  if (!GetVarInt(source, index, nof_channels)) {
+    return false;
+  }
+  channel_list_.clear();
+  for (uint64_t count = 0; count < nof_channels; ++count) {
+    uint64_t channel = 0;
+    std::string share_name;
+    if (!GetVarInt(source, index, channel) || channel > UINT32_MAX ||
+        !GetString(source, index, share_name)) {
+      return false;
+    }
+    channel_list_.emplace(share_name, static_cast<uint32_t>(channel));
+  }
+  return true;
+}
+
 }  // namespace util::log::detail
@@ -11,6 +11,7 @@
 #include <boost/interprocess/sync/interprocess_semaphore.hpp>
 #include <cstdint>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -23,6 +24,23 @@ struct SharedListenMessage {
   char text[300]{};
 };
 
+/** \brief Layout of the shared memory listen queue.
+ *
+ * The master selects the format when it creates the shared memory. The
+ * clients read the format from the header.
+ */
+enum class SharedQueueFormat : uint32_t {
+  MutexQueue = 0,  ///< Fixed 256 slots guarded by an interprocess mutex.
+  RingQueue = 1,   ///< Lock-free ring buffer with a configurable capacity.
+  RecordQueue = 2  ///< Lock-free byte ring with variable length records.
+};
+
+/** \brief Original layout of the shared memory listen queue.
+ *
+ * Processes built before the queue formats existed, maps exactly this
+ * layout. It must not be changed. The struct starts all queue formats and
+ * the new fields follow in the SharedQueueHeader.
+ */
 struct SharedListenQueue {
   boost::interprocess::interprocess_recursive_mutex
       locker;  ///< Mutex that locks the queue
@@ -38,25 +56,152 @@ struct SharedListenQueue {
   SharedListenMessage queue[256]{};        ///< Message queue
 
   SharedListenQueue();
-  ;
+};
+
+/** \brief Control block that starts all shared memory queue formats.
+ *
+ * The original mutex queue comes first, so older processes still find the
+ * mutex and the semaphore at their original offsets. The new fields are
+ * appended after the mutex queue. A memory that is smaller than this
+ * header or without the magic number, is created by an older master that
+ * only supports the mutex queue.
+ *
+ * The ring formats don't use the mutex queue and keep its active flag
+ * false, so older clients never send any messages to them.
+ */
+struct SharedQueueHeader {
+  static constexpr uint32_t kMagic = 0x5551'4C55;  ///< Header is present.
+
+  SharedListenQueue base;  ///< Original layout. Must be the first member.
+  uint32_t magic = kMagic;  ///< Tells that the header is present.
+  SharedQueueFormat format = SharedQueueFormat::MutexQueue;  ///< Layout
+  std::atomic<bool> active =
+      false;  ///< If false, no messages should be handled.
+  std::atomic<uint8_t> log_level = 0;    ///< Store the current log level.
+  std::atomic<uint64_t> generation = 0;  ///< Unique per master. 0 = closed.
+  alignas(64) std::atomic<bool> consumer_waiting =
+      false;  ///< True if the master waits on the semaphore (ring formats).
+
+  /** \brief Returns the header if the memory has one.
+   *
+   * @param address Start of the mapped memory.
+   * @param size Size of the mapped memory.
+   * @return The header or nullptr if an older master created the memory.
+   */
+  [[nodiscard]] static SharedQueueHeader *FromMemory(void *address,
+                                                     size_t size);
+};
+
+/** \brief One slot in the lock-free ring.
+ *
+ * The sequence number tells if the slot is free for a producer or holds a
+ * message for the consumer.
+ */
+struct alignas(64) SharedListenSlot {
+  std::atomic<uint64_t> sequence = 0;  ///< Slot sequence number.
+  SharedListenMessage msg;             ///< Message
+};
+
+/** \brief Lock-free multiple producer/single consumer ring buffer.
+ *
+ * The ring header is followed by 'capacity' slots in the shared memory.
+ * Producers claim a slot by a compare-and-swap on the tail index while the
+ * master is the only consumer. The indexes are padded to separate cache lines
+ * so producers and the consumer don't share cache lines. The semaphore is
+ * only posted when the master is waiting for a message.
+ */
+struct SharedListenRing {
+  SharedQueueHeader header;  ///< Must be the first member.
+  uint64_t capacity = 0;     ///< Number of slots. Always a power of two.
+  uint64_t mask = 0;         ///< Capacity - 1.
+  alignas(64) std::atomic<uint64_t> tail = 0;  ///< Next producer position.
+  alignas(64) std::atomic<uint64_t> head = 0;  ///< Next consumer position.
+
+  explicit SharedListenRing(uint64_t nof_slots);
+  [[nodiscard]] SharedListenSlot *Slots();
+  [[nodiscard]] static size_t MemorySize(uint64_t nof_slots);
+  [[nodiscard]] static uint64_t RoundCapacity(uint64_t nof_slots);
+};
+
+/** \brief Header of a variable length record in the record ring.
+ *
+ * The header is followed by the pre-text and text bytes. Records are
+ * 8-byte aligned. The size is stored last by the producer, so a zero size
+ * means that the record isn't committed yet. A size with the padding flag
+ * set, tells the consumer to skip to the start of the buffer.
+ */
+struct SharedListenRecord {
+  static constexpr uint32_t kPaddingFlag = 0x8000'0000;  ///< Skip record
+  std::atomic<uint32_t> size = 0;  ///< Record size including the header.
+  uint32_t text_size = 0;          ///< Number of text bytes.
+  uint64_t ns1970 = 0;             ///< Time stamp nanoseconds since 1970.
+  uint32_t pre_text_size = 0;      ///< Number of pre-text bytes.
+  uint32_t reserved = 0;           ///< Reserved for future use.
+};
+
+/** \brief Lock-free byte ring with length-prefixed records.
+ *
+ * Messages only use the bytes they need, so short messages are cheap and
+ * long messages are sent as one record. Producers reserve bytes by a
+ * compare-and-swap on the tail. The consumer zeroes consumed bytes, so
+ * uncommitted records always have a zero size. The byte buffer follows the
+ * header in the shared memory.
+ */
+struct SharedListenRecordRing {
+  SharedQueueHeader header;  ///< Must be the first member.
+  uint64_t capacity = 0;     ///< Number of bytes. Always a power of two.
+  uint64_t mask = 0;         ///< Capacity - 1.
+  alignas(64) std::atomic<uint64_t> tail = 0;       ///< Reserved bytes.
+  std::atomic<uint64_t> nof_committed = 0;          ///< Committed records.
+  alignas(64) std::atomic<uint64_t> head = 0;       ///< Consumed bytes.
+  std::atomic<uint64_t> nof_consumed = 0;           ///< Consumed records.
+
+  explicit SharedListenRecordRing(uint64_t nof_bytes);
+  [[nodiscard]] uint8_t *Buffer();
+  [[nodiscard]] uint64_t MaxRecordSize() const;
+  [[nodiscard]] static size_t MemorySize(uint64_t nof_bytes);
+  [[nodiscard]] static uint64_t RoundCapacity(uint64_t nof_bytes);
 };
 
 enum class ListenMessageType : uint16_t {
   LogLevelText = 0,
   TextMessage,
-  LogLevel
+  LogLevel,
+  TextBatch, ///< Compressed block of text messages (version 3).
+  Channel, ///< Selects the channel of the following messages (version 4).
+  Subscribe ///< Subscribes to channels on a multiplexed server (version 4).
 };
 
+/** \brief Encoded message (header and body) that is ready to send.
+ *
+ * The frame is immutable, so it can be shared between many connections.
+ */
+using ListenFrame = std::shared_ptr<const std::vector<uint8_t>>;
+
 class ListenMessage {
  public:
   ListenMessage() = default;
   virtual ~ListenMessage() = default;
 
+  /// Protocol version that uses varint lengths and delta time stamps.
+  static constexpr uint16_t kCompactVersion = 2;
+  /// Protocol version that also supports compressed batches of texts.
+  static constexpr uint16_t kBatchVersion = 3;
+  /// Protocol version that also supports multiplexed channels.
+  static constexpr uint16_t kChannelVersion = 4;
+
   ListenMessageType type_ = ListenMessageType::LogLevel;
   uint16_t version_ = 0;
   uint32_t body_size_ = 0;
+  uint32_t channel_ = 0; ///< Channel on a multiplexed server. Not in header.
   virtual void ToBuffer(std::vector<uint8_t> &dest);
   void FromHeaderBuffer(const std::array<uint8_t, 8> &source);
+
+  /** \brief Encodes the message into a shareable frame.
+   *
+   * @return Encoded message.
+   */
+  [[nodiscard]] ListenFrame ToFrame();
 };
 
 class LogLevelTextMessage : public ListenMessage {
@@ -84,6 +229,100 @@ class ListenTextMessage : public ListenMessage {
   explicit ListenTextMessage(const SharedListenMessage &msg);
   void ToBuffer(std::vector<uint8_t> &dest) override;
   void FromBodyBuffer(const std::vector<uint8_t> &source);
+
+  /** \brief Encodes the message with the compact framing (version 2).
+   *
+   * The compact body uses varint lengths and stores the time stamp as a
+   * delta against the previous text message.
+   * @param dest Destination buffer (header and body).
+   * @param base_ns1970 Time stamp of the previous text message.
+   */
+  void ToCompactBuffer(std::vector<uint8_t> &dest, uint64_t base_ns1970);
+
+  /** \brief Decodes a compact (version 2) body.
+   *
+   * @param source Body buffer.
+   * @param base_ns1970 Time stamp of the previous text message.
+   * @return False if the body is corrupt.
+   */
+  bool FromCompactBuffer(const std::vector<uint8_t> &source,
+                         uint64_t base_ns1970);
+  bool FromCompactBuffer(const std::vector<uint8_t> &source, size_t &index,
+                         uint64_t base_ns1970);
+  void AppendCompactBody(std::vector<uint8_t> &dest,
+                         uint64_t base_ns1970) const;
+
+  [[nodiscard]] ListenFrame ToCompactFrame(uint64_t base_ns1970);
+};
+
+/** \brief Block of text messages that is sent as one compressed message.
+ *
+ * The texts are stored as compact text bodies where the time stamps are
+ * relative to the previous text in the block. The first text has an absolute
+ * time stamp. The block is compressed with zlib if that reduces the size.
+ */
+class ListenBatchMessage : public ListenMessage {
+ public:
+  /// Maximum number of texts in one batch.
+  static constexpr size_t kMaxTexts = 256;
+  /// Maximum pre-text and text size in a batch. Longer texts are sent alone.
+  static constexpr size_t kMaxTextSize = 64 * 1024;
+  /// Maximum size of the uncompressed block including the varints.
+  static constexpr size_t kMaxBlockSize = kMaxTexts * (kMaxTextSize + 32);
+
+  std::vector<std::unique_ptr<ListenTextMessage>> text_list_;
+  ListenBatchMessage();
+
+  /** \brief Returns true if the text may be added to a batch.
+   *
+   * @param text Text message.
+   * @return False if the text is too long for a batch.
+   */
+  [[nodiscard]] static bool FitsInBatch(const ListenTextMessage &text);
+  void ToBuffer(std::vector<uint8_t> &dest) override;
+  bool FromBodyBuffer(const std::vector<uint8_t> &source);
+};
+
+/** \brief Selects the channel on a multiplexed connection.
+ *
+ * All messages that follow the channel message belongs to the channel
+ * until the next channel message. The channel is stored as a varint.
+ */
+class ListenChannelMessage : public ListenMessage {
+ public:
+  ListenChannelMessage();
+  void ToBuffer(std::vector<uint8_t> &dest) override;
+  bool FromBodyBuffer(const std::vector<uint8_t> &source);
+};
+
+/** \brief Subscribes to channels on a multiplexed server.
+ *
+ * The client sends the share names it wants to listen to. An empty list
+ * subscribes to all channels. The server replies with the same message where
+ * each share name has its channel number.
+ */
+class ListenSubscribeMessage : public ListenMessage {
+ public:
+  std::map<std::string, uint32_t> channel_list_; ///< Share name to channel.
+  ListenSubscribeMessage();
+  void ToBuffer(std::vector<uint8_t> &dest) override;
+  bool FromBodyBuffer(const std::vector<uint8_t> &source);
+};
+
+/** \brief Encoded message in all protocol versions.
+ *
+ * The compact frame stores the time stamp as a delta against base_ns1970.
+ * A connection only sends the compact frame if the previous text message it
+ * sent had that time stamp. Otherwise, it sends the version 0 frame that has
+ * an absolute time stamp.
+ */
+struct ListenFrameSet {
+  ListenMessageType type = ListenMessageType::TextMessage;
+  ListenFrame frame;  ///< Version 0 frame.
+  ListenFrame compact_frame;  ///< Version 2 frame. Only text messages.
+  uint64_t ns1970 = 0;  ///< Time stamp of a text message.
+  uint64_t base_ns1970 = 0;  ///< Time stamp the compact frame relates to.
+  uint32_t channel = 0;  ///< Channel on a multiplexed connection.
 };
 
 }  // end namespace util::log::detail
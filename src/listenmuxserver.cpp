@@ -0,0 +1,282 @@
+/*
+ * Copyright 2025 Ingemar Hedvall
+ * SPDX-License-Identifier: MIT
+ */
+#include "listenmuxserver.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "util/listenconfig.h"
+#include "util/logstream.h"
+#include "util/stringutil.h"
+
+using namespace util::log;
+using namespace util::string;
+using namespace boost::asio;
+using namespace std::chrono_literals;
+
+namespace util::log::detail {
+
+ListenMuxServer::ListenMuxServer(size_t nof_threads)
+    : own_context_(std::make_unique<io_context>()),
+      context_(*own_context_),
+      strand_(make_strand(context_)),
+      cleanup_timer_(context_),
+      nof_threads_(std::max(nof_threads, size_t{1})) {
+  Name("Listen");
+}
+
+ListenMuxServer::ListenMuxServer(std::shared_ptr<IoContextPool> pool)
+    : pool_(std::move(pool)),
+      context_(pool_->Context()),
+      strand_(make_strand(context_)),
+      cleanup_timer_(context_),
+      nof_threads_(0) {
+  Name("Listen");
+}
+
+ListenMuxServer::~ListenMuxServer() { ListenMuxServer::Stop(); }
+
+io_context& ListenMuxServer::Context() { return context_; }
+
+IListen* ListenMuxServer::AddChannel(const std::string& share_name) {
+  const auto exist = std::any_of(
+      channel_list_.cbegin(), channel_list_.cend(),
+      [&](const auto& channel) { return channel->ShareName() == share_name; });
+  if (share_name.empty() || exist) {
+    LOG_ERROR() << "Invalid or duplicate channel. Share Name: " << share_name;
+    return nullptr;
+  }
+  const auto channel = static_cast<uint32_t>(channel_list_.size());
+  auto server = std::make_unique<ListenServer>(context_, share_name, channel);
+  server->Name(share_name);
+
+  ListenChannelMessage select;
+  select.channel_ = channel;
+  select_list_.push_back(select.ToFrame());
+
+  channel_list_.push_back(std::move(server));
+  return channel_list_.back().get();
+}
+
+ListenServer* ListenMuxServer::Channel(uint32_t channel) const {
+  return channel < channel_list_.size() ? channel_list_[channel].get()
+                                        : nullptr;
+}
+
+ListenFrame ListenMuxServer::SelectFrame(uint32_t channel) const {
+  return channel < select_list_.size() ? select_list_[channel] : ListenFrame();
+}
+
+void ListenMuxServer::Subscribe(
+    const std::shared_ptr<ListenServerConnection>& connection,
+    const ListenSubscribeMessage& request) {
+  if (!connection) {
+    return;
+  }
+  ListenSubscribeMessage reply;
+  std::vector<ListenServer*> subscribe_list;
+  for (const auto& channel : channel_list_) {
+    const auto& share_name = channel->ShareName();
+    if (request.channel_list_.empty() ||
+        request.channel_list_.find(share_name) !=
+            request.channel_list_.cend()) {
+      reply.channel_list_.emplace(share_name, channel->Channel());
+      subscribe_list.push_back(channel.get());
+    }
+  }
+  // The reply is sent before any channel frame
+  connection->InFrame(reply.ToFrame());
+  for (auto* channel : subscribe_list) {
+    channel->Attach(connection);
+  }
+  active_ = true;
+}
+
+void ListenMuxServer::WorkerTask() {
+  try {
+    const auto& count = context_.run();
+    LOG_TRACE() << "Stopped multiplexed worker thread. Name: " << Name()
+                << ", Count: " << count;
+  } catch (const std::exception& error) {
+    LOG_ERROR() << "Context error. Name: " << Name()
+                << ", Error: " << error.what();
+  }
+}
+
+bool ListenMuxServer::IsActive() const { return active_; }
+
+bool ListenMuxServer::Start() {
+  bool start = false;
+  active_ = false;
+
+  ListenPortConfig config;
+  config.port = Port();
+  config.name = Name();
+  config.description = Description();
+  AddListenConfig(config);
+
+  try {
+    if (own_context_ && context_.stopped()) {
+      context_.restart();
+    }
+    if (HostName().empty() || IEquals(HostName(), "0.0.0.0")) {
+      const auto address = ip::address_v4::any();
+      const ip::tcp::endpoint endpoint(address, Port());
+      acceptor_ = std::make_unique<ip::tcp::acceptor>(context_, endpoint);
+    } else {
+      const auto address = ip::make_address("127.0.0.1");
+      const ip::tcp::endpoint endpoint(address, Port());
+      acceptor_ = std::make_unique<ip::tcp::acceptor>(context_, endpoint);
+    }
+    for (auto& channel : channel_list_) {
+      channel->Start();
+    }
+    DoAccept();
+    DoCleanup();
+    for (size_t thread = 0; thread < nof_threads_; ++thread) {
+      worker_list_.emplace_back(&ListenMuxServer::WorkerTask, this);
+    }
+    start = true;
+  } catch (const std::exception& error) {
+    LOG_ERROR() << "Failed to start the server. Name: " << Name()
+                << ", Error: " << error.what();
+  }
+  return start;
+}
+
+bool ListenMuxServer::Stop() {
+  bool stop = false;
+  active_ = false;
+  DeleteListenConfig(Port());
+  try {
+    if (own_context_) {
+      if (!context_.stopped()) {
+        context_.stop();
+      }
+      for (auto& worker : worker_list_) {
+        if (worker.joinable()) {
+          worker.join();
+        }
+      }
+      worker_list_.clear();
+    } else {
+      // The context is shared. The connection handlers shall be done before
+      // the channels are stopped, as they may forward messages to them.
+      util::RunOnStrand(context_, strand_, [&] {
+        boost::system::error_code dummy;
+        if (acceptor_) {
+          acceptor_->close(dummy);
+        }
+        cleanup_timer_.cancel();
+        std::lock_guard lock(connection_list_lock_);
+        for (auto& connection : connection_list_) {
+          if (connection) {
+            connection->Shutdown();
+          }
+        }
+      });
+      handlers_.Wait();
+    }
+    for (auto& channel : channel_list_) {
+      channel->Stop();
+    }
+    acceptor_.reset();
+    std::lock_guard lock(connection_list_lock_);
+    connection_list_.clear();
+    stop = true;
+  } catch (const std::exception& error) {
+    LOG_ERROR() << "Failed to stop the server. Name: " << Name()
+                << ", Error: " << error.what();
+  }
+  return stop;
+}
+
+size_t ListenMuxServer::LogLevel() { return 0; }
+
+void ListenMuxServer::AddMessage(uint64_t, const std::string&,
+                                 const std::string&) {
+  // The text lines are generated by the channels.
+}
+
+void ListenMuxServer::DoAccept() {
+  connection_socket_ = std::make_unique<ip::tcp::socket>(context_);
+  acceptor_->async_accept(
+      *connection_socket_,
+      bind_executor(strand_, [this, token = handlers_.Acquire()](
+                                 const boost::system::error_code& error) {
+        if (error == error::operation_aborted) {
+          connection_socket_.reset();
+        } else if (error) {
+          connection_socket_.reset();
+          LOG_ERROR() << "Accept error. Name: " << Name()
+                      << ", Error: " << error.message();
+        } else {
+          // The connection is attached to the channels when the client
+          // subscribes.
+          auto connection = std::make_shared<ListenServerConnection>(
+              *this, connection_socket_);
+          connection->Start();
+          std::lock_guard lock(connection_list_lock_);
+          connection_list_.push_back(std::move(connection));
+          DoAccept();
+        }
+      }));
+}
+
+void ListenMuxServer::DoCleanup() {
+  cleanup_timer_.expires_after(2s);
+  cleanup_timer_.async_wait(bind_executor(
+      strand_, [this, token = handlers_.Acquire()](
+                   const boost::system::error_code& error) {
+    if (error == error::operation_aborted) {
+      return;
+    }
+    if (error) {
+      LOG_ERROR() << "Cleanup timer error. Name: " << Name()
+                  << ", Error: " << error.message();
+      return;
+    }
+    std::lock_guard lock(connection_list_lock_);
+    for (auto itr = connection_list_.begin(); itr != connection_list_.end();
+         /* No ++itr here */) {
+      auto& connection = *itr;
+      if (!connection || connection->Cleanup()) {
+        if (connection) {
+          for (auto& channel : channel_list_) {
+            channel->Detach(connection.get());
+          }
+          closed_dropped_ += connection->NofDroppedMessages();
+        }
+        itr = connection_list_.erase(itr);
+      } else {
+        ++itr;
+      }
+    }
+    active_ = !connection_list_.empty();
+    DoCleanup();
+  }));
+}
+
+size_t ListenMuxServer::NofConnections() const {
+  std::lock_guard lock(connection_list_lock_);
+  return connection_list_.size();
+}
+
+uint64_t ListenMuxServer::NofDroppedMessages() const {
+  std::lock_guard lock(connection_list_lock_);
+  uint64_t nof_dropped = closed_dropped_;
+  for (const auto& connection : connection_list_) {
+    if (connection) {
+      nof_dropped += connection->NofDroppedMessages();
+    }
+  }
+  // Messages that never reached any connection
+  for (const auto& channel : channel_list_) {
+    nof_dropped += channel->NofInputDropped();
+  }
+  return nof_dropped;
+}
+
+}  // namespace util::log::detail
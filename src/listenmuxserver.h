@@ -0,0 +1,131 @@
+/*
+ * Copyright 2025 Ingemar Hedvall
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <boost/asio.hpp>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "handlercount.h"
+#include "listenmessage.h"
+#include "listenserver.h"
+#include "listenserverconnection.h"
+#include "util/ilisten.h"
+#include "util/iocontextpool.h"
+
+namespace util::log::detail {
+
+/** \brief Listen server that multiplex many channels over one TCP port.
+ *
+ * The server has one acceptor and one context that is run by a small pool
+ * of threads. Each channel is a listen server with its own shared memory
+ * that doesn't have any acceptor or worker thread. A client subscribes to a
+ * set of share names and the frames are tagged with a channel message when
+ * the channel changes.
+ *
+ * The server itself doesn't generate any text lines. Use the channel
+ * objects for that.
+ */
+class ListenMuxServer : public IListen {
+ public:
+  /** \brief Constructor.
+   *
+   * @param nof_threads Number of threads that runs the context.
+   */
+  explicit ListenMuxServer(size_t nof_threads = 2);
+
+  /** \brief Creates a server that runs on a shared context.
+   *
+   * The server and its channels use the threads of the pool.
+   * @param pool Shared context pool.
+   */
+  explicit ListenMuxServer(std::shared_ptr<IoContextPool> pool);
+  ~ListenMuxServer() override;
+
+  ListenMuxServer(const ListenMuxServer &) = delete;
+  ListenMuxServer &operator=(const ListenMuxServer &) = delete;
+
+  boost::asio::io_context &Context();
+
+  /** \brief Counts the handlers of the server and its connections. */
+  [[nodiscard]] const util::HandlerCount &Handlers() const {
+    return handlers_;
+  }
+
+  /** \brief Adds a channel.
+   *
+   * Channels should be added before the server is started. The channel
+   * number is the index of the channel.
+   * @param share_name Shared memory name.
+   * @return The channel object or nullptr if the channel already exist.
+   */
+  IListen *AddChannel(const std::string &share_name) override;
+
+  /** \brief Returns a channel by its number.
+   *
+   * @param channel Channel number.
+   * @return Channel object or nullptr if it doesn't exist.
+   */
+  [[nodiscard]] ListenServer *Channel(uint32_t channel) const;
+
+  /** \brief Returns the encoded channel message.
+   *
+   * The channel messages are encoded once when the channel is added.
+   * @param channel Channel number.
+   * @return Encoded channel message or empty if the channel doesn't exist.
+   */
+  [[nodiscard]] ListenFrame SelectFrame(uint32_t channel) const;
+
+  /** \brief Attaches a connection to the requested channels.
+   *
+   * Replies with the subscribed share names and their channel numbers.
+   * @param connection Client connection.
+   * @param request Requested share names. Empty list means all channels.
+   */
+  void Subscribe(const std::shared_ptr<ListenServerConnection> &connection,
+                 const ListenSubscribeMessage &request);
+
+  [[nodiscard]] bool IsActive() const override;
+  bool Start() override;
+  bool Stop() override;
+  [[nodiscard]] size_t LogLevel() override;
+  [[nodiscard]] size_t NofConnections() const override;
+  [[nodiscard]] uint64_t NofDroppedMessages() const override;
+
+ protected:
+  void AddMessage(uint64_t nano_sec_1970, const std::string &pre_text,
+                  const std::string &text) override;
+
+ private:
+  util::HandlerCount handlers_;
+  std::shared_ptr<IoContextPool> pool_;  ///< Shared context pool or null.
+  std::unique_ptr<boost::asio::io_context> own_context_;
+  boost::asio::io_context &context_;
+  boost::asio::strand<boost::asio::io_context::executor_type> strand_;
+  boost::asio::steady_timer cleanup_timer_;
+  std::unique_ptr<boost::asio::ip::tcp::acceptor> acceptor_;
+  std::unique_ptr<boost::asio::ip::tcp::socket> connection_socket_;
+  size_t nof_threads_ = 2;  ///< Number of threads if not using a pool.
+  std::vector<std::thread> worker_list_;
+
+  std::vector<std::unique_ptr<ListenServer>> channel_list_;
+  std::vector<ListenFrame> select_list_;  ///< Channel message per channel.
+
+  mutable std::mutex connection_list_lock_;
+  std::deque<std::shared_ptr<ListenServerConnection>> connection_list_;
+  uint64_t closed_dropped_ = 0;  ///< Dropped messages by closed connections.
+  std::atomic<bool> active_ = false;
+
+  void WorkerTask();
+  void DoAccept();
+  void DoCleanup();
+};
+
+}  // namespace util::log::detail
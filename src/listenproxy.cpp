@@ -8,7 +8,7 @@
 namespace util::log::detail {
 
 ListenProxy::ListenProxy(const std::string &share_name)
-    : IListen(), queue_(false, share_name) {}
+    : IListen(), queue_(false, share_name, true) {}
 
 ListenProxy::~ListenProxy() { queue_.Stop(); }
 
@@ -22,6 +22,11 @@ void ListenProxy::AddMessage(uint64_t nano_sec_1970,
   if (!IsActive()) {
     return;
   }
+  // The record queue format doesn't need any splitting of the text.
+  if (queue_.AddText(nano_sec_1970, pre_text, text)) {
+    IncrementNumberOfMessages();
+    return;
+  }
 
   // Need to adjust pre_text and text so the fit into the shared memory messages
   std::string temp = pre_text;
@@ -4,6 +4,7 @@
  */
 #include "listenserver.h"
 
+#include <algorithm>
 #include <boost/asio.hpp>
 #include <chrono>
 
@@ -17,10 +18,32 @@ using namespace util::string;
 using namespace boost::asio;
 using namespace std::chrono_literals;
 
+namespace {
+util::log::detail::SharedQueueFormat ToSharedQueueFormat(
+    ListenQueueFormat format) {
+  using util::log::detail::SharedQueueFormat;
+  switch (format) {
+    case ListenQueueFormat::RingQueue:
+      return SharedQueueFormat::RingQueue;
+
+    case ListenQueueFormat::RecordQueue:
+      return SharedQueueFormat::RecordQueue;
+
+    case ListenQueueFormat::MutexQueue:
+    default:
+      break;
+  }
+  return SharedQueueFormat::MutexQueue;
+}
+}  // namespace
+
 namespace util::log::detail {
 
 ListenServer::ListenServer()
-    : cleanup_timer_(context_), queue_timer_(context_) {
+    : own_context_(std::make_unique<io_context>()),
+      context_(*own_context_),
+      strand_(make_strand(context_)),
+      cleanup_timer_(context_) {
   Name("Listen");
 }
 
@@ -28,6 +51,26 @@ ListenServer::ListenServer(const std::string& share_name) : ListenServer() {
   ShareName(share_name);
 }
 
+ListenServer::ListenServer(std::shared_ptr<IoContextPool> pool,
+                           const std::string& share_name)
+    : pool_(std::move(pool)),
+      context_(pool_->Context()),
+      strand_(make_strand(context_)),
+      cleanup_timer_(context_) {
+  Name("Listen");
+  ShareName(share_name);
+}
+
+ListenServer::ListenServer(io_context& context, const std::string& share_name,
+                           uint32_t channel)
+    : context_(context),
+      strand_(make_strand(context_)),
+      cleanup_timer_(context_),
+      channel_(channel) {
+  Name("Listen");
+  ShareName(share_name);
+}
+
 ListenServer::~ListenServer() {
   ListenServer::Stop();
 }
@@ -51,6 +94,21 @@ bool ListenServer::Start() {
   if (share_mem_queue_) {
     share_mem_queue_->SetActive(false);
   }
+  // The input queue has the same limit as the client queues.
+  msg_queue_.MaxSize(QueueLimit());
+
+  if (IsChannel()) {
+    // A channel of a multiplexed server. The server accepts the connections
+    DoCleanup();
+    if (IsShareMemQueueOutdated()) {
+      ShareName(share_name_);
+    }
+    StartShareMemTask();
+    if (!msg_queue_.Empty() && !queue_posted_.exchange(true)) {
+      post(strand_, [this, token = handlers_.Acquire()] { DoMessageQueue(); });
+    }
+    return true;
+  }
 
   ListenPortConfig config;
   config.port = Port();
@@ -71,8 +129,19 @@ bool ListenServer::Start() {
     }
     DoAccept();
     DoCleanup();
-    DoMessageQueue();
-    worker_thread_ = std::thread(&ListenServer::WorkerTask, this);
+    if (IsShareMemQueueOutdated()) {
+      ShareName(share_name_);  // Restart after a previous stop
+    }
+    if (own_context_) {
+      if (context_.stopped()) {
+        context_.restart();
+      }
+      worker_thread_ = std::thread(&ListenServer::WorkerTask, this);
+    }
+    StartShareMemTask();
+    if (!msg_queue_.Empty() && !queue_posted_.exchange(true)) {
+      post(strand_, [this, token = handlers_.Acquire()] { DoMessageQueue(); });
+    }
     start = true;
   } catch (const std::exception& error) {
     LOG_ERROR() << "Failed to start the server. Name: " << Name()
@@ -84,20 +153,28 @@ bool ListenServer::Start() {
 bool ListenServer::Stop() {
   bool stop = false;
   active_ = false;
-  DeleteListenConfig(Port());
+  if (!IsChannel()) {
+    DeleteListenConfig(Port());
+  }
 
   if (share_mem_queue_) {
     share_mem_queue_->SetActive(false);
   }
+  StopShareMemTask();
   try {
-    if (!context_.stopped()) {
-      context_.stop();
-    }
-    if (worker_thread_.joinable()) {
-      worker_thread_.join();
+    if (own_context_) {
+      if (!context_.stopped()) {
+        context_.stop();
+      }
+      if (worker_thread_.joinable()) {
+        worker_thread_.join();
+      }
+      std::lock_guard lock(connection_list_lock_);
+      connection_list_.clear();
+    } else {
+      // The context is shared and cannot be stopped
+      Shutdown();
     }
-    std::lock_guard lock(connection_list_lock_);
-    connection_list_.clear();
     stop = true;
   } catch (const std::exception& error) {
     LOG_ERROR() << "Failed to stop the server. Name: " << Name()
@@ -121,16 +198,21 @@ void ListenServer::AddMessage(uint64_t nano_sec_1970,
 void ListenServer::DoAccept() {
   connection_socket_ = std::make_unique<ip::tcp::socket>(context_);
   acceptor_->async_accept(
-      *connection_socket_, [&](const boost::system::error_code& error) {
-        if (error) {
+      *connection_socket_,
+      bind_executor(strand_, [this, token = handlers_.Acquire()](
+                                 const boost::system::error_code& error) {
+        if (error == error::operation_aborted) {
+          connection_socket_.reset();
+        } else if (error) {
           connection_socket_.reset();
           LOG_ERROR() << "Accept error. Name: " << Name()
                       << ", Error: " << error.message();
         } else {
 
           {
-            auto connection = std::make_unique<ListenServerConnection>(
+            auto connection = std::make_shared<ListenServerConnection>(
               *this, connection_socket_);
+            connection->Start();
             std::lock_guard lock(connection_list_lock_);
             connection_list_.push_back(std::move(connection));
           }
@@ -140,13 +222,17 @@ void ListenServer::DoAccept() {
           }
           DoAccept();
         }
-      });
+      }));
 }
 
 void ListenServer::DoCleanup() {
   cleanup_timer_.expires_after(2s);
-  cleanup_timer_.async_wait(
-      [&](const boost::system::error_code& error) -> void {
+  cleanup_timer_.async_wait(bind_executor(
+      strand_, [this, token = handlers_.Acquire()](
+                   const boost::system::error_code& error) -> void {
+    if (error == error::operation_aborted) {
+      return;
+    }
     if (error) {
       LOG_ERROR() << "Cleanup timer error. Name: " << Name()
                   << ", Error: " << error.message();
@@ -156,6 +242,9 @@ void ListenServer::DoCleanup() {
            /* No ++itr here */) {
         auto& connection = *itr;
         if (!connection || connection->Cleanup()) {
+          if (connection) {
+            closed_dropped_ += connection->NofDroppedMessages(channel_);
+          }
           itr = connection_list_.erase(itr);
         } else {
           ++itr;
@@ -167,73 +256,174 @@ void ListenServer::DoCleanup() {
       }
       DoCleanup();
     }
+  }));
+}
+
+void ListenServer::Shutdown() {
+  util::RunOnStrand(context_, strand_, [&] {
+    boost::system::error_code dummy;
+    if (acceptor_) {
+      acceptor_->close(dummy);
+    }
+    cleanup_timer_.cancel();
+    std::lock_guard lock(connection_list_lock_);
+    if (!IsChannel()) {
+      // Connections of a multiplexed server are closed by that server
+      for (auto& connection : connection_list_) {
+        if (connection) {
+          connection->Shutdown();
+        }
+      }
+    }
   });
+  {
+    std::lock_guard lock(connection_list_lock_);
+    connection_list_.clear();
+  }
+  if (!context_.stopped()) {
+    handlers_.Wait();
+  }
+  acceptor_.reset();
 }
 
 void ListenServer::DoMessageQueue() {
-  queue_timer_.expires_after(50ms);
-  queue_timer_.async_wait([&](
-    const boost::system::error_code& error) -> void {
-    if (error) {
-      LOG_ERROR() << "Message queue timer error. Name: " << Name()
-                  << ", Error: " << error.message();
-    } else {
-      if (share_mem_queue_) {
-        SharedListenMessage share_msg;
-        for (bool share = share_mem_queue_->Get(share_msg, false); share;
-             share = share_mem_queue_->Get(share_msg, false)) {
-          auto text = std::make_unique<ListenTextMessage>(share_msg);
-          InMessage(std::move(text));
+  // Reset the flag before the queue is emptied, so any message added while
+  // handling the queue posts a new call.
+  queue_posted_ = false;
+  ListenBatchMessage batch;
+  // The queue is emptied with one lock
+  std::vector<std::unique_ptr<ListenMessage>> msg_list;
+  for (bool message = msg_queue_.GetAll(msg_list, false); message;
+       message = msg_queue_.GetAll(msg_list, false)) {
+    for (auto& msg : msg_list) {
+      auto* text =
+          BatchMessages() && msg->type_ == ListenMessageType::TextMessage
+              ? dynamic_cast<ListenTextMessage*>(msg.get())
+              : nullptr;
+      if (text != nullptr && ListenBatchMessage::FitsInBatch(*text)) {
+        msg.release();  // NOLINT
+        batch.text_list_.emplace_back(text);
+        if (batch.text_list_.size() >= ListenBatchMessage::kMaxTexts) {
+          ForwardBatch(batch);
         }
+        continue;
       }
-      std::unique_ptr<ListenMessage> msg;
-      for (bool message = msg_queue_.Get(msg, false); message;
-           message = msg_queue_.Get(msg, false)) {
-        HandleMessage(msg.get());
-        msg.reset();
+      ForwardBatch(batch);  // Keeps the message order
+      HandleMessage(msg.get());
+      msg.reset();
+    }
+    msg_list.clear();
+  }
+  ForwardBatch(batch);
+}
+
+void ListenServer::ShareMemTask() {
+  while (share_mem_queue_ && !share_mem_queue_->IsStopped()) {
+    auto text = std::make_unique<ListenTextMessage>();
+    if (!share_mem_queue_->Get(*text, true)) {
+      continue;
+    }
+    // Back-pressure on a full input queue. The producers fill up the shared
+    // memory queue instead of this server's memory.
+    std::unique_ptr<ListenMessage> msg = std::move(text);
+    while (!msg_queue_.Put(msg, 100ms)) {
+      if (share_mem_queue_->IsStopped()) {
+        return;
       }
-      DoMessageQueue();
     }
-  });
+    PostMessageQueue();
+  }
+}
+
+void ListenServer::StartShareMemTask() {
+  if (share_mem_queue_ && !share_mem_thread_.joinable()) {
+    share_mem_thread_ = std::thread(&ListenServer::ShareMemTask, this);
+  }
+}
+
+void ListenServer::StopShareMemTask() {
+  if (share_mem_queue_) {
+    share_mem_queue_->Stop();  // Releases the blocking Get()
+  }
+  if (share_mem_thread_.joinable()) {
+    share_mem_thread_.join();
+  }
 }
 
 boost::asio::io_context& ListenServer::Context() { return context_; }
 
 void ListenServer::InMessage(std::unique_ptr<ListenMessage> msg) {
-  msg_queue_.Put(msg);
+  if (!msg) {
+    return;
+  }
+  if (msg->type_ != ListenMessageType::TextMessage) {
+    // Control messages from the viewers are never dropped by the queue limit
+    post(strand_, [this, token = handlers_.Acquire(),
+                   control = std::shared_ptr<ListenMessage>(std::move(msg))] {
+      HandleMessage(control.get());
+    });
+    return;
+  }
+  if (!msg_queue_.TryPut(msg)) {
+    return;  // Dropped on a full queue
+  }
+  PostMessageQueue();
+}
+
+void ListenServer::PostMessageQueue() {
+  // Only one queued call is needed as it handles all messages in the queue
+  if (!queue_posted_.exchange(true)) {
+    post(strand_, [this, token = handlers_.Acquire()] { DoMessageQueue(); });
+  }
 }
 
 size_t ListenServer::LogLevel() { return log_level_; }
 
 void ListenServer::ShareName(const std::string& share_name) {
+  const bool running = share_mem_thread_.joinable();
+  StopShareMemTask();
   share_name_ = share_name;
-  if (share_name_.empty()) {
-    share_mem_queue_.reset();
-  } else {
-    share_mem_queue_ = std::make_unique<MessageQueue>(true, share_name_);
+  share_mem_queue_.reset();
+  queue_format_ = ToSharedQueueFormat(ShareQueueFormat());
+  queue_capacity_ = ShareQueueCapacity();
+  if (!share_name_.empty()) {
+    share_mem_queue_ = std::make_unique<MessageQueue>(
+        share_name_, queue_format_, queue_capacity_);
+    share_mem_queue_->SetActive(active_);
+    share_mem_queue_->SetLogLevel(static_cast<uint8_t>(log_level_));
   }
+  if (running) {
+    StartShareMemTask();
+  }
+}
+
+bool ListenServer::IsShareMemQueueOutdated() const {
+  return share_mem_queue_ &&
+         (share_mem_queue_->IsStopped() ||
+          queue_format_ != ToSharedQueueFormat(ShareQueueFormat()) ||
+          queue_capacity_ != ShareQueueCapacity());
 }
 
 std::string ListenServer::ShareName() const { return share_name_; }
 
-void ListenServer::HandleMessage(const ListenMessage* msg) {
+void ListenServer::HandleMessage(ListenMessage* msg) {
   if (msg == nullptr) {
     return;
   }
   switch (msg->type_) {
     case ListenMessageType::LogLevel: {
       // Set new log level and send out to clients
-      const auto* log_level_msg = dynamic_cast<const LogLevelMessage*>(msg);
+      auto* log_level_msg = dynamic_cast<LogLevelMessage*>(msg);
       if (log_level_msg != nullptr) {
         log_level_ = log_level_msg->log_level_;
         if (share_mem_queue_) {
           LOG_TRACE() << "Setting Log level: " << log_level_;
           share_mem_queue_->SetLogLevel(log_level_);
         }
+        const auto frame = log_level_msg->ToFrame();
         std::lock_guard lock(connection_list_lock_);
         for (auto& connection : connection_list_) {
-          auto send_msg = std::make_unique<LogLevelMessage>(*log_level_msg);
-          connection->InMessage(std::move(send_msg));
+          connection->InFrame(frame, channel_);
         }
       }
       break;
@@ -241,12 +431,18 @@ void ListenServer::HandleMessage(const ListenMessage* msg) {
 
     case ListenMessageType::TextMessage: {
       // Send out to clients
-      const auto* text = dynamic_cast<const ListenTextMessage*>(msg);
+      // Encode the message once and share the frame with all connections
+      auto* text = dynamic_cast<ListenTextMessage*>(msg);
       if (text != nullptr) {
         std::lock_guard lock(connection_list_lock_);
+        if (connection_list_.empty()) {
+          break;
+        }
+        // The compact frame is only needed by newer clients
+        const auto frame_set =
+            MakeFrameSet(*text, HasVersion(ListenMessage::kCompactVersion));
         for (auto& connection : connection_list_) {
-          auto send_msg = std::make_unique<ListenTextMessage>(*text);
-          connection->InMessage(std::move(send_msg));
+          connection->InFrame(frame_set);
         }
       }
       break;
@@ -258,9 +454,120 @@ void ListenServer::HandleMessage(const ListenMessage* msg) {
   }
 }
 
+ListenFrameSet ListenServer::MakeFrameSet(ListenTextMessage& text,
+                                          bool compact) {
+  ListenFrameSet frame_set;
+  frame_set.frame = text.ToFrame();
+  frame_set.ns1970 = text.ns1970_;
+  frame_set.base_ns1970 = last_ns1970_;
+  frame_set.channel = channel_;
+  last_ns1970_ = text.ns1970_;
+  if (compact) {
+    frame_set.compact_frame = text.ToCompactFrame(frame_set.base_ns1970);
+  }
+  return frame_set;
+}
+
+bool ListenServer::HasVersion(uint16_t version) const {
+  return std::any_of(connection_list_.cbegin(), connection_list_.cend(),
+                     [&](const auto& connection) {
+                       return connection && connection->Version() >= version;
+                     });
+}
+
+void ListenServer::ForwardBatch(ListenBatchMessage& batch) {
+  auto& text_list = batch.text_list_;
+  if (text_list.empty()) {
+    return;
+  }
+  std::lock_guard lock(connection_list_lock_);
+  if (!connection_list_.empty()) {
+    ListenFrameSet batch_set;
+    if (text_list.size() > 1 && HasVersion(ListenMessage::kBatchVersion)) {
+      batch_set.type = ListenMessageType::TextBatch;
+      batch_set.frame = batch.ToFrame();
+      batch_set.ns1970 = text_list.back()->ns1970_;
+      batch_set.channel = channel_;
+    }
+
+    // Single frames are only needed by clients without batch support
+    const bool single = !batch_set.frame ||
+        std::any_of(connection_list_.cbegin(), connection_list_.cend(),
+                    [](const auto& connection) {
+                      return connection && connection->Version() <
+                                               ListenMessage::kBatchVersion;
+                    });
+    std::vector<ListenFrameSet> frame_list;
+    if (single) {
+      const bool compact = HasVersion(ListenMessage::kCompactVersion);
+      frame_list.reserve(text_list.size());
+      for (auto& text : text_list) {
+        frame_list.push_back(MakeFrameSet(*text, compact));
+      }
+    } else {
+      last_ns1970_ = batch_set.ns1970;
+    }
+
+    for (auto& connection : connection_list_) {
+      connection->InFrames(frame_list, batch_set);
+    }
+  }
+  text_list.clear();
+}
+
+void ListenServer::Attach(
+    const std::shared_ptr<ListenServerConnection>& connection) {
+  if (!connection) {
+    return;
+  }
+  {
+    std::lock_guard lock(connection_list_lock_);
+    const bool exist =
+        std::find(connection_list_.cbegin(), connection_list_.cend(),
+                  connection) != connection_list_.cend();
+    if (exist) {
+      return;
+    }
+    connection->SendLogLevels(*this, channel_);
+    connection_list_.push_back(connection);
+  }
+  active_ = true;
+  if (share_mem_queue_) {
+    share_mem_queue_->SetActive(active_);
+  }
+}
+
+void ListenServer::Detach(const ListenServerConnection* connection) {
+  std::lock_guard lock(connection_list_lock_);
+  const auto itr = std::find_if(connection_list_.begin(),
+                                connection_list_.end(),
+                                [&](const auto& item) {
+                                  return item.get() == connection;
+                                });
+  if (itr != connection_list_.end()) {
+    closed_dropped_ += (*itr)->NofDroppedMessages(channel_);
+    connection_list_.erase(itr);
+  }
+  active_ = !connection_list_.empty();
+  if (share_mem_queue_) {
+    share_mem_queue_->SetActive(active_);
+  }
+}
+
 size_t ListenServer::NofConnections() const {
   std::lock_guard lock(connection_list_lock_);
   return connection_list_.size();
 }
 
-}  // namespace util::log::detail
\ No newline at end of file
+uint64_t ListenServer::NofDroppedMessages() const {
+  std::lock_guard lock(connection_list_lock_);
+  uint64_t nof_dropped = closed_dropped_ + msg_queue_.NofDropped();
+  for (const auto& connection : connection_list_) {
+    if (connection) {
+      nof_dropped += connection->NofDroppedMessages(channel_);
+    }
+  }
+  return nof_dropped;
+}
+
+}  // namespace util::log::detail
@@ -13,10 +13,12 @@
 #include <thread>
 #include <vector>
 
+#include "handlercount.h"
 #include "listenmessage.h"
 #include "listenserverconnection.h"
 #include "messagequeue.h"
 #include "util/ilisten.h"
+#include "util/iocontextpool.h"
 #include "util/threadsafequeue.h"
 
 namespace util::log::detail {
@@ -27,10 +29,37 @@ class ListenServer : public IListen {
 
   explicit ListenServer(const std::string &share_name);
 
+  /** \brief Creates a server that runs on a shared context.
+   *
+   * The server uses the threads of the pool instead of an own worker
+   * thread.
+   * @param pool Shared context pool.
+   * @param share_name Shared memory name or empty string.
+   */
+  ListenServer(std::shared_ptr<IoContextPool> pool,
+               const std::string &share_name);
+
+  /** \brief Creates a channel of a multiplexed server.
+   *
+   * The channel uses the context of the multiplexed server and has no own
+   * acceptor or worker thread. The multiplexed server attaches the
+   * connections that subscribes to the channel.
+   * @param context Context of the multiplexed server.
+   * @param share_name Shared memory name.
+   * @param channel Channel number.
+   */
+  ListenServer(boost::asio::io_context &context, const std::string &share_name,
+               uint32_t channel);
+
   ~ListenServer() override;
 
   boost::asio::io_context &Context();
 
+  /** \brief Counts the handlers of the server and its connections. */
+  [[nodiscard]] const util::HandlerCount &Handlers() const {
+    return handlers_;
+  }
+
   [[nodiscard]] bool IsActive() const override;
 
   bool Start() override;
@@ -39,6 +68,25 @@ class ListenServer : public IListen {
 
   void InMessage(std::unique_ptr<ListenMessage> msg);
 
+  /** \brief Adds a connection that subscribes to the channel.
+   *
+   * Sends the log level texts and the log level to the connection.
+   * @param connection Multiplexed connection.
+   */
+  void Attach(const std::shared_ptr<ListenServerConnection> &connection);
+
+  /** \brief Removes a connection from the channel.
+   *
+   * @param connection Multiplexed connection.
+   */
+  void Detach(const ListenServerConnection *connection);
+
+  /** \brief Channel number on a multiplexed server.
+   *
+   * @return Channel number. Always 0 if not a channel.
+   */
+  [[nodiscard]] uint32_t Channel() const { return channel_; }
+
   void ShareName(const std::string &share_name);
 
   [[nodiscard]] std::string ShareName() const;
@@ -47,37 +95,117 @@ class ListenServer : public IListen {
 
   [[nodiscard]] size_t NofConnections() const override;
 
+  /** \brief Number of dropped messages from the channel.
+   *
+   * Includes the messages dropped by the input queue and the messages from
+   * this channel that the connections dropped.
+   * @return Number of dropped messages.
+   */
+  [[nodiscard]] uint64_t NofDroppedMessages() const override;
+
+  /** \brief Number of messages dropped by the input queue. */
+  [[nodiscard]] uint64_t NofInputDropped() const {
+    return msg_queue_.NofDropped();
+  }
+
  protected:
   void AddMessage(uint64_t nano_sec_1970, const std::string &pre_text,
                   const std::string &text) override;
 
  private:
-  boost::asio::io_context context_;
+  util::HandlerCount handlers_;
+  std::shared_ptr<IoContextPool> pool_;  ///< Shared context pool or null.
+  /// Own context. Channels use the context of the multiplexed server.
+  std::unique_ptr<boost::asio::io_context> own_context_;
+  boost::asio::io_context &context_;
+  /// Serializes the handlers if the context is run by more than one thread.
+  boost::asio::strand<boost::asio::io_context::executor_type> strand_;
   boost::asio::steady_timer cleanup_timer_;
+  uint32_t channel_ = 0;
   std::unique_ptr<boost::asio::ip::tcp::acceptor> acceptor_;
   std::unique_ptr<boost::asio::ip::tcp::socket> connection_socket_;
   std::thread worker_thread_;
 
   mutable std::mutex connection_list_lock_;
-  std::deque<std::unique_ptr<ListenServerConnection>> connection_list_;
+  std::deque<std::shared_ptr<ListenServerConnection>> connection_list_;
+  uint64_t closed_dropped_ = 0;  ///< Dropped messages by closed connections.
+  uint64_t last_ns1970_ = 0;  ///< Time of the last forwarded text message.
 
   ThreadSafeQueue<ListenMessage> msg_queue_;
-  boost::asio::steady_timer queue_timer_;
+  std::atomic<bool> queue_posted_ = false;
 
   std::atomic<uint64_t> log_level_ = 0;
   std::atomic<bool> active_ = false;
 
   std::unique_ptr<MessageQueue> share_mem_queue_;
+  /// Format and capacity of the created shared memory queue.
+  SharedQueueFormat queue_format_ = SharedQueueFormat::MutexQueue;
+  size_t queue_capacity_ = 256;
+  std::thread share_mem_thread_;
 
   void WorkerTask();
 
+  /** \brief Waits on the shared memory queue.
+   *
+   * The thread blocks on the shared memory semaphore and forwards each
+   * message to InMessage(). The thread ends when the shared memory queue is
+   * stopped.
+   */
+  void ShareMemTask();
+  /** \brief Posts a call that handles the input queue. */
+  void PostMessageQueue();
+  void StartShareMemTask();
+  void StopShareMemTask();
+  /** \brief Returns true if the shared memory queue needs to be recreated.
+   *
+   * The queue is recreated after a stop or if the format or the capacity
+   * has changed.
+   */
+  [[nodiscard]] bool IsShareMemQueueOutdated() const;
+
   void DoAccept();
 
   void DoCleanup();
 
   void DoMessageQueue();
 
-  void HandleMessage(const ListenMessage *msg);
+  /** \brief Closes the acceptor, the timer and the connections.
+   *
+   * Used on a shared context, where the context cannot be stopped. Waits
+   * until all handlers have been called.
+   */
+  void Shutdown();
+
+  /** \brief Returns true if the server is a channel of a multiplexed server.
+   */
+  [[nodiscard]] bool IsChannel() const { return !own_context_ && !pool_; }
+
+  void HandleMessage(ListenMessage *msg);
+
+  /** \brief Encodes a text message for all protocol versions.
+   *
+   * Should be called with the connection list locked.
+   * @param text Text message.
+   * @param compact True if the compact frame is needed.
+   * @return Encoded text message.
+   */
+  ListenFrameSet MakeFrameSet(ListenTextMessage &text, bool compact);
+
+  /** \brief Returns true if any connection supports the version.
+   *
+   * Should be called with the connection list locked.
+   * @param version Protocol version.
+   * @return True if any client supports the version.
+   */
+  [[nodiscard]] bool HasVersion(uint16_t version) const;
+
+  /** \brief Sends a batch of text messages to all connections.
+   *
+   * Clients that support batches get one compressed message while other
+   * clients get one message for each text. The batch is cleared.
+   * @param batch Text messages to send.
+   */
+  void ForwardBatch(ListenBatchMessage &batch);
 };
 
 }  // namespace util::log::detail
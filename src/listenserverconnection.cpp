@@ -4,36 +4,49 @@
  */
 #include "listenserverconnection.h"
 
+#include <algorithm>
 #include <boost/asio.hpp>
 #include <memory>
+#include <string>
 
 #include "listenmessage.h"
+#include "listenmuxserver.h"
 #include "listenserver.h"
 #include "util/logstream.h"
+#include "util/timestamp.h"
 
 using namespace util::log;
 using namespace boost::asio;
 using namespace std::chrono_literals;
 
+namespace {
+// Limits the number of frames that are gathered into one write.
+constexpr size_t kMaxFramesPerWrite = 256;
+}  // namespace
+
 namespace util::log::detail {
 
 ListenServerConnection::ListenServerConnection(
     ListenServer& server, std::unique_ptr<boost::asio::ip::tcp::socket>& socket)
-    : server_(server),
+    : owner_(server),
+      server_(&server),
+      handlers_(server.Handlers()),
       socket_(std::move(socket)),
-      queue_timer_(server.Context()) {
-  DoReadHeader();
-
-  auto msg1 = std::make_unique<LogLevelTextMessage>();
-  msg1->log_level_text_list_ = server.LogLevelList();
-  InMessage(std::move(msg1));
+      max_frames_(server.QueueLimit()),
+      overflow_policy_(server.OverflowPolicy()),
+      strand_(make_strand(server.Context())),
+      last_ns1970_list_(1, 0) {}
 
-  auto msg2 = std::make_unique<LogLevelMessage>();
-  msg2->log_level_ = server.LogLevel();
-  InMessage(std::move(msg2));
-
-  DoMessageQueue();
-}
+ListenServerConnection::ListenServerConnection(
+    ListenMuxServer& server,
+    std::unique_ptr<boost::asio::ip::tcp::socket>& socket)
+    : owner_(server),
+      mux_(&server),
+      handlers_(server.Handlers()),
+      socket_(std::move(socket)),
+      max_frames_(server.QueueLimit()),
+      overflow_policy_(server.OverflowPolicy()),
+      strand_(make_strand(server.Context())) {}
 
 ListenServerConnection::~ListenServerConnection() {
   if (socket_ && socket_->is_open()) {
@@ -42,17 +55,57 @@ ListenServerConnection::~ListenServerConnection() {
   socket_.reset();
 }
 
+void ListenServerConnection::Start() {
+  DoReadHeader();
+  if (server_ != nullptr) {
+    SendLogLevels(*server_, 0);
+  }
+}
+
+void ListenServerConnection::Shutdown() {
+  post(strand_, [this, self = shared_from_this(),
+                 token = handlers_.Acquire()] {
+    if (socket_ && socket_->is_open()) {
+      Close();
+    }
+  });
+}
+
+void ListenServerConnection::SendLogLevels(ListenServer& server,
+                                           uint32_t channel) {
+  LogLevelTextMessage msg1;
+  msg1.log_level_text_list_ = server.LogLevelList();
+  InFrame(msg1.ToFrame(), channel);
+
+  LogLevelMessage msg2;
+  msg2.log_level_ = server.LogLevel();
+  InFrame(msg2.ToFrame(), channel);
+}
+
 bool ListenServerConnection::Cleanup() const {
-  return !socket_ || !socket_->is_open();
+  // Called from the server's strand, so the socket itself isn't used.
+  return closed_ && !writing_;
+}
+
+ListenServer* ListenServerConnection::ChannelServer(uint32_t channel) const {
+  if (mux_ != nullptr) {
+    return mux_->Channel(channel);
+  }
+  return channel == 0 ? server_ : nullptr;
 }
 
 void ListenServerConnection::DoReadHeader() {  // NOLINT
   if (!socket_ || !socket_->is_open()) {
     return;
   }
+  // The read handlers run on the strand, so they don't close the socket
+  // while a write is in progress on another thread.
   async_read(
       *socket_, boost::asio::buffer(header_data_),
-      [&](const boost::system::error_code& error, size_t bytes) {  // NOLINT
+      bind_executor(strand_, [this, self = shared_from_this(),
+                              token = handlers_.Acquire()](
+                                 const boost::system::error_code& error,
+                                 size_t bytes) {  // NOLINT
         if (error && error == error::eof) {
           LOG_INFO() << "Connection closed by remote";
           Close();
@@ -75,7 +128,7 @@ void ListenServerConnection::DoReadHeader() {  // NOLINT
             Close();
           }
         }
-      });
+      }));
 }
 
 void ListenServerConnection::DoReadBody() {  // NOLINT
@@ -84,7 +137,10 @@ void ListenServerConnection::DoReadBody() {  // NOLINT
   }
   async_read(
       *socket_, boost::asio::buffer(body_data_),
-      [&](const boost::system::error_code& error, size_t bytes) {  // NOLINT
+      bind_executor(strand_, [this, self = shared_from_this(),
+                              token = handlers_.Acquire()](
+                                 const boost::system::error_code& error,
+                                 size_t bytes) {  // NOLINT
         if (error) {
           LOG_ERROR() << "Listen body error. Error: " << error.message();
           Close();
@@ -95,10 +151,11 @@ void ListenServerConnection::DoReadBody() {  // NOLINT
           HandleMessage();
           DoReadHeader();
         }
-      });
+      }));
 }
 
 void ListenServerConnection::Close() {
+  closed_ = true;
   boost::system::error_code dummy;
   socket_->shutdown(ip::tcp::socket::shutdown_both, dummy);
   socket_->close(dummy);
@@ -109,18 +166,51 @@ void ListenServerConnection::HandleMessage() {
   header.FromHeaderBuffer(header_data_);
   switch (header.type_) {
     case ListenMessageType::LogLevelText: {
-      auto msg = std::make_unique<LogLevelTextMessage>();
-      msg->FromHeaderBuffer(header_data_);
-      msg->FromBodyBuffer(body_data_);
-      server_.InMessage(std::move(msg));
+      if (header.version_ >= ListenMessage::kCompactVersion) {
+        // The client supports the compact framing and maybe batches.
+        version_ = std::min(header.version_, ListenMessage::kChannelVersion);
+        break;
+      }
+      auto* server = ChannelServer(read_channel_);
+      if (server != nullptr) {
+        auto msg = std::make_unique<LogLevelTextMessage>();
+        msg->FromHeaderBuffer(header_data_);
+        msg->FromBodyBuffer(body_data_);
+        server->InMessage(std::move(msg));
+      }
       break;
     }
 
     case ListenMessageType::LogLevel: {
-      auto msg = std::make_unique<LogLevelMessage>();
-      msg->FromHeaderBuffer(header_data_);
-      msg->FromBodyBuffer(body_data_);
-      server_.InMessage(std::move(msg));
+      auto* server = ChannelServer(read_channel_);
+      if (server != nullptr) {
+        auto msg = std::make_unique<LogLevelMessage>();
+        msg->FromHeaderBuffer(header_data_);
+        msg->FromBodyBuffer(body_data_);
+        server->InMessage(std::move(msg));
+      }
+      break;
+    }
+
+    case ListenMessageType::Channel: {
+      ListenChannelMessage msg;
+      if (msg.FromBodyBuffer(body_data_)) {
+        read_channel_ = msg.channel_;
+      } else {
+        LOG_ERROR() << "Invalid channel message.";
+      }
+      break;
+    }
+
+    case ListenMessageType::Subscribe: {
+      ListenSubscribeMessage msg;
+      if (mux_ == nullptr) {
+        LOG_ERROR() << "Subscribe is only supported by multiplexed servers.";
+      } else if (!msg.FromBodyBuffer(body_data_)) {
+        LOG_ERROR() << "Invalid subscribe message.";
+      } else {
+        mux_->Subscribe(shared_from_this(), msg);
+      }
       break;
     }
 
@@ -137,46 +227,215 @@ void ListenServerConnection::HandleMessage() {
 }
 
 void ListenServerConnection::InMessage(std::unique_ptr<ListenMessage> msg) {
-  msg_queue_.Put(msg);
+  if (msg) {
+    InFrame(msg->ToFrame());
+  }
 }
 
-void ListenServerConnection::DoMessageQueue() {  // NOLINT
-  if (!socket_ || !socket_->is_open()) {
+void ListenServerConnection::InFrame(ListenFrame frame, uint32_t channel) {
+  if (frame) {
+    ListenFrameSet frame_set;
+    frame_set.type = ListenMessageType::LogLevel;  // Not a text message
+    frame_set.frame = std::move(frame);
+    frame_set.channel = channel;
+    InFrame(frame_set);
+  }
+}
+
+void ListenServerConnection::InFrames(
+    const std::vector<ListenFrameSet>& frame_list,
+    const ListenFrameSet& batch_set) {
+  if (batch_set.frame && version_ >= ListenMessage::kBatchVersion) {
+    InFrame(batch_set);
     return;
   }
-  std::unique_ptr<ListenMessage> msg;
-  bool message = msg_queue_.Get(msg, false);
-  if (message) {
-    msg_data_.clear();
-    msg->ToBuffer(msg_data_);
-    async_write(
-        *socket_, boost::asio::buffer(msg_data_),
-        [&](const boost::system::error_code& error, size_t bytes) {  // NOLINT
-          if (error) {
-            LOG_ERROR() << "Listen body error. Error: " << error.message();
-            Close();
-          } else if (bytes != msg_data_.size()) {
-            LOG_ERROR() << "Listen message length error. Error: "
-                        << error.message();
-            Close();
-          } else {
-            DoMessageQueue();
-          }
-        });
-  } else {
-    DoQueueTimer();
+  for (const auto& frame_set : frame_list) {
+    InFrame(frame_set);
   }
 }
 
-void ListenServerConnection::DoQueueTimer() {
-  queue_timer_.expires_after(20ms);
-  queue_timer_.async_wait([&](const boost::system::error_code error) {
-    if (error) {
-      LOG_ERROR() << "Queue timer error. Error: " << error.message();
+void ListenServerConnection::InFrame(const ListenFrameSet& frame_set) {
+  // The socket belongs to the connection strand. DoWrite() checks it.
+  if (!frame_set.frame || closed_) {
+    return;
+  }
+  bool disconnect = false;
+  {
+    std::lock_guard lock(queue_lock_);
+    if (max_frames_ > 0 && frame_queue_.size() >= max_frames_) {
+      switch (overflow_policy_) {
+        case ListenOverflowPolicy::DropNewest:
+          CountDropped(frame_set.channel);
+          return;
+
+        case ListenOverflowPolicy::Disconnect:
+          CountDropped(frame_set.channel);
+          disconnect = !overflow_disconnect_;
+          overflow_disconnect_ = true;
+          frame_queue_.clear();
+          break;
+
+        case ListenOverflowPolicy::DropOldest:
+        default:
+          CountDropped(frame_queue_.front().channel);
+          frame_queue_.pop_front();
+          frame_queue_.push_back(frame_set);
+          break;
+      }
     } else {
-      DoMessageQueue();
+      frame_queue_.push_back(frame_set);
     }
-  });
+  }
+  if (disconnect) {
+    // The pending write may never complete if the client doesn't read.
+    // Closing the socket aborts it.
+    post(strand_, [this, self = shared_from_this(),
+                   token = handlers_.Acquire()] {
+      if (socket_ && socket_->is_open()) {
+        LOG_ERROR() << "Listen client queue is full. Closing the connection.";
+        Close();
+      }
+    });
+    return;
+  }
+  if (!writing_.exchange(true)) {
+    post(strand_, [this, self = shared_from_this(),
+                   token = handlers_.Acquire()] { DoWrite(); });
+  }
+}
+
+ListenFrameSet ListenServerConnection::DroppedFrame(uint64_t nof_dropped,
+                                                   uint32_t channel) const {
+  const auto* server = ChannelServer(channel);
+  ListenTextMessage msg;
+  msg.ns1970_ = time::TimeStampToNs();
+  msg.pre_text_ = server != nullptr ? server->PreText() : owner_.PreText();
+  msg.text_ = std::to_string(nof_dropped) + " messages dropped";
+
+  ListenFrameSet frame_set;
+  frame_set.frame = msg.ToFrame();
+  frame_set.ns1970 = msg.ns1970_;
+  frame_set.channel = channel;
+  return frame_set;
+}
+
+void ListenServerConnection::CountDropped(uint32_t channel) {
+  ++nof_dropped_;
+  ++unreported_dropped_;
+  if (channel >= channel_dropped_.size()) {
+    channel_dropped_.resize(channel + 1, 0);
+  }
+  ++channel_dropped_[channel];
+}
+
+uint64_t ListenServerConnection::NofDroppedMessages(uint32_t channel) const {
+  std::lock_guard lock(queue_lock_);
+  return channel < channel_dropped_.size() ? channel_dropped_[channel] : 0;
+}
+
+size_t ListenServerConnection::AddToWrite(ListenFrameSet& frame_set) {
+  size_t bytes = 0;
+  const uint32_t channel = frame_set.channel;
+  if (mux_ != nullptr && channel != write_channel_) {
+    // Tells the client that the following frames belongs to another channel
+    auto select = mux_->SelectFrame(channel);
+    if (select) {
+      write_buffers_.emplace_back(buffer(*select));
+      bytes += select->size();
+      write_frames_.push_back(std::move(select));
+      write_channel_ = channel;
+    }
+  }
+  if (channel >= last_ns1970_list_.size()) {
+    last_ns1970_list_.resize(channel + 1, 0);
+  }
+  auto& last_ns1970 = last_ns1970_list_[channel];
+
+  ListenFrame frame = std::move(frame_set.frame);
+  if (frame_set.type == ListenMessageType::TextMessage) {
+    // The compact frame can only be used if the client has the same base
+    // time. After a connect or dropped messages, the absolute time
+    // (version 0) frame is sent instead.
+    if (version_ >= ListenMessage::kCompactVersion &&
+        frame_set.compact_frame && frame_set.base_ns1970 == last_ns1970) {
+      frame = std::move(frame_set.compact_frame);
+    }
+    last_ns1970 = frame_set.ns1970;
+  } else if (frame_set.type == ListenMessageType::TextBatch) {
+    last_ns1970 = frame_set.ns1970;
+  }
+  write_buffers_.emplace_back(buffer(*frame));
+  bytes += frame->size();
+  write_frames_.push_back(std::move(frame));
+  return bytes;
+}
+
+void ListenServerConnection::ClearQueue() {
+  std::lock_guard lock(queue_lock_);
+  frame_queue_.clear();
+}
+
+void ListenServerConnection::DoWrite() {  // NOLINT
+  write_frames_.clear();
+  write_buffers_.clear();
+  if (!socket_ || !socket_->is_open()) {
+    ClearQueue();
+    writing_ = false;
+    return;
+  }
+
+  size_t total = 0;
+  {
+    std::lock_guard lock(queue_lock_);
+    if (overflow_disconnect_) {
+      LOG_ERROR() << "Listen client queue is full. Closing the connection.";
+      frame_queue_.clear();
+      Close();
+      writing_ = false;
+      return;
+    }
+    if (unreported_dropped_ > 0) {
+      // Tells the viewer that messages are missing
+      uint32_t channel = write_channel_ == UINT32_MAX ? 0 : write_channel_;
+      if (!frame_queue_.empty()) {
+        channel = frame_queue_.front().channel;
+      }
+      auto dropped = DroppedFrame(unreported_dropped_, channel);
+      unreported_dropped_ = 0;
+      total += AddToWrite(dropped);
+    }
+    while (write_frames_.size() < kMaxFramesPerWrite &&
+           !frame_queue_.empty()) {
+      total += AddToWrite(frame_queue_.front());
+      frame_queue_.pop_front();
+    }
+    if (write_frames_.empty()) {
+      // Reset the flag while holding the lock, so a new frame either is
+      // found here or starts a new write.
+      writing_ = false;
+      return;
+    }
+  }
+
+  async_write(
+      *socket_, write_buffers_,
+      bind_executor(strand_, [this, self = shared_from_this(),
+                              token = handlers_.Acquire(), total](
+                                 const boost::system::error_code& error,
+                                 size_t bytes) {  // NOLINT
+        if (error) {
+          LOG_ERROR() << "Listen write error. Error: " << error.message();
+          Close();
+          DoWrite();
+        } else if (bytes != total) {
+          LOG_ERROR() << "Listen message length error. Error: "
+                      << error.message();
+          Close();
+          DoWrite();
+        } else {
+          DoWrite();
+        }
+      }));
 }
 
 }  // namespace util::log::detail
@@ -5,43 +5,203 @@
 
 #pragma once
 #include <array>
+#include <atomic>
 #include <boost/asio.hpp>
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <vector>
 
+#include "handlercount.h"
 #include "listenmessage.h"
-#include "util/threadsafequeue.h"
+#include "util/ilisten.h"
 
 namespace util::log::detail {
 class ListenServer;
+class ListenMuxServer;
 
-class ListenServerConnection final {
+/** \brief Connection to a listen client (viewer).
+ *
+ * The connection either belongs to a listen server or to a multiplexed
+ * server. A multiplexed connection is attached to the channels that the
+ * client subscribes to and it tags the frames with a channel message when
+ * the channel changes. The handlers keeps a shared pointer to the connection,
+ * so Start() must be called after the connection has been created. The
+ * handlers also hold a token from the server, so a server on a shared
+ * context can wait for them when it is stopped.
+ */
+class ListenServerConnection final
+    : public std::enable_shared_from_this<ListenServerConnection> {
  public:
   ListenServerConnection(ListenServer& server,
                          std::unique_ptr<boost::asio::ip::tcp::socket>& socket);
+
+  /** \brief Creates a connection to a multiplexed server.
+   *
+   * @param server Multiplexed server.
+   * @param socket Connected socket.
+   */
+  ListenServerConnection(ListenMuxServer& server,
+                         std::unique_ptr<boost::asio::ip::tcp::socket>& socket);
   ~ListenServerConnection();
 
+  /** \brief Starts reading from the client.
+   *
+   * A connection to a listen server also sends the log level texts and the
+   * current log level.
+   */
+  void Start();
+
+  /** \brief Closes the socket on the connection strand.
+   *
+   * The pending handlers are called with an error and the connection is
+   * deleted when the last handler has been called.
+   */
+  void Shutdown();
+
   ListenServerConnection() = delete;
   ListenServerConnection(ListenServerConnection&) = delete;
   ListenServerConnection& operator=(ListenServerConnection&) = delete;
 
+  /** \brief Returns true if the connection can be deleted.
+   *
+   * The connection can be deleted when the socket is closed and no write is
+   * pending.
+   * @return True if the connection is closed.
+   */
   bool Cleanup() const;
+
+  /** \brief Queues a message to the remote client.
+   *
+   * The message is added to the outbound queue. If no write is in progress,
+   * a write is started on the connection strand.
+   * @param msg Message to send.
+   */
   void InMessage(std::unique_ptr<ListenMessage> msg);
 
+  /** \brief Queues an encoded message to the remote client.
+   *
+   * The frame is shared and not copied, so the same frame can be queued to
+   * all connections.
+   * @param frame Encoded message.
+   */
+  void InFrame(ListenFrame frame, uint32_t channel = 0);
+
+  /** \brief Queues a text message that is encoded in all versions.
+   *
+   * The connection selects the frame that suits the client protocol version.
+   * @param frame_set Encoded message.
+   */
+  void InFrame(const ListenFrameSet& frame_set);
+
+  /** \brief Queues a batch of text messages.
+   *
+   * Clients that support batches get the batch frame, other clients get the
+   * single frames.
+   * @param frame_list Text messages encoded as single frames.
+   * @param batch_set Text messages encoded as one batch frame or empty.
+   */
+  void InFrames(const std::vector<ListenFrameSet>& frame_list,
+                const ListenFrameSet& batch_set);
+
+  /** \brief Protocol version that the client supports.
+   *
+   * A client that supports the compact framing tells the server by sending
+   * a message with the compact version number. Older clients use version 0.
+   * @return Protocol version.
+   */
+  [[nodiscard]] uint16_t Version() const { return version_; }
+
+  /** \brief Number of messages dropped due to a full queue.
+   *
+   * @return Number of dropped messages.
+   */
+  [[nodiscard]] uint64_t NofDroppedMessages() const { return nof_dropped_; }
+
+  /** \brief Number of messages from a channel dropped due to a full queue.
+   *
+   * A multiplexed connection is attached to many channels. Each channel
+   * reports its own part of the dropped messages.
+   * @param channel Channel number. Always 0 if not multiplexed.
+   * @return Number of dropped messages from the channel.
+   */
+  [[nodiscard]] uint64_t NofDroppedMessages(uint32_t channel) const;
+
+  /** \brief Sends the log level texts and the log level of a channel.
+   *
+   * Called when the connection is attached to a listen server.
+   * @param server Listen server or channel.
+   * @param channel Channel number.
+   */
+  void SendLogLevels(ListenServer& server, uint32_t channel);
+
  private:
-  ListenServer& server_;
+  IListen& owner_;  ///< Listen server or multiplexed server.
+  ListenServer* server_ = nullptr;  ///< Listen server if not multiplexed.
+  ListenMuxServer* mux_ = nullptr;  ///< Multiplexed server.
+  const util::HandlerCount& handlers_;  ///< Handlers of the owner.
   std::unique_ptr<boost::asio::ip::tcp::socket> socket_;
   std::array<uint8_t, 8> header_data_{0};
   std::vector<uint8_t> body_data_;
-  ThreadSafeQueue<ListenMessage> msg_queue_;
-  std::vector<uint8_t> msg_data_;
-  boost::asio::steady_timer queue_timer_;
+  mutable std::mutex queue_lock_;
+  std::deque<ListenFrameSet> frame_queue_;  ///< Outbound queue.
+  size_t max_frames_ = 0;  ///< Queue limit. Zero means no limit.
+  ListenOverflowPolicy overflow_policy_ = ListenOverflowPolicy::DropOldest;
+  std::atomic<uint64_t> nof_dropped_ = 0;  ///< Total dropped messages.
+  uint64_t unreported_dropped_ = 0;  ///< Dropped since last viewer notice.
+  std::vector<uint64_t> channel_dropped_;  ///< Dropped messages per channel.
+  bool overflow_disconnect_ = false;  ///< Close on next write.
+  boost::asio::strand<boost::asio::io_context::executor_type> strand_;
+  std::atomic<bool> writing_ = false;  ///< True while a write chain is active.
+  std::atomic<bool> closed_ = false;  ///< Set by Close() on the strand.
+  std::vector<ListenFrame> write_frames_;  ///< Frames in the current write.
+  std::vector<boost::asio::const_buffer> write_buffers_;
+  std::atomic<uint16_t> version_ = 0;  ///< Client protocol version.
+  /// Time of last sent text message for each channel.
+  std::vector<uint64_t> last_ns1970_list_;
+  uint32_t write_channel_ = UINT32_MAX;  ///< Channel of the last sent frame.
+  uint32_t read_channel_ = 0;  ///< Channel of the received messages.
 
   void DoReadHeader();
   void DoReadBody();
-  void DoMessageQueue();
-  void DoQueueTimer();
+
+  /** \brief Writes all queued frames in one gathered write.
+   *
+   * Sends the queued frames with one async_write(). The write chain continues
+   * until the queue is empty.
+   */
+  void DoWrite();
+  void ClearQueue();
+
+  /** \brief Creates a text frame that reports dropped messages.
+   *
+   * @param nof_dropped Number of dropped messages.
+   * @return Encoded text message.
+   */
+  [[nodiscard]] ListenFrameSet DroppedFrame(uint64_t nof_dropped,
+                                            uint32_t channel) const;
+
+  /** \brief Adds the frame that suits the client to the current write.
+   *
+   * @param frame_set Encoded message.
+   * @return Number of bytes added.
+   */
+  size_t AddToWrite(ListenFrameSet& frame_set);
+
+  /** \brief Counts a dropped message. Call with the queue locked.
+   *
+   * @param channel Channel of the dropped message.
+   */
+  void CountDropped(uint32_t channel);
   void Close();
   void HandleMessage();
+
+  /** \brief Returns the listen server that handles the channel.
+   *
+   * @param channel Channel number.
+   * @return Listen server or nullptr if the channel doesn't exist.
+   */
+  [[nodiscard]] ListenServer* ChannelServer(uint32_t channel) const;
 };
 }  // namespace util::log::detail
\ No newline at end of file
@@ -0,0 +1,330 @@
+/*
+ * Copyright 2025 Ingemar Hedvall
+ * SPDX-License-Identifier: MIT
+ */
+#include "logbinaryfile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#include "logfile.h"
+#include "util/logconfig.h"
+#include "util/logging.h"
+#include "util/logstream.h"
+
+using namespace boost::interprocess;
+using namespace std::filesystem;
+
+namespace {
+
+constexpr uint64_t kMinFileSize = 64 * 1024;
+constexpr uint64_t kMaxTextLength = 1'000'000;  ///< Longer texts are truncated.
+
+constexpr uint64_t Align8(uint64_t size) { return (size + 7) & ~uint64_t{7}; }
+
+}  // namespace
+
+namespace util::log {
+
+bool ConvertBinaryLogFile(const std::string &binary_file,
+                          const std::string &text_file) {
+  using detail::BinaryLogHeader;
+  using detail::BinaryLogLocation;
+  using detail::BinaryLogRecord;
+  try {
+    const file_mapping file(binary_file.c_str(), read_only);
+    const mapped_region region(file, read_only);
+    const auto *data = static_cast<const uint8_t *>(region.get_address());
+    const uint64_t file_size = region.get_size();
+
+    BinaryLogHeader header;
+    if (file_size < sizeof(header)) {
+      throw std::runtime_error("File is too small");
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, BinaryLogHeader().magic,
+                    sizeof(header.magic)) != 0 ||
+        header.version != 1 || header.header_size != sizeof(header) ||
+        header.header_size + header.table_size + header.ring_size > file_size ||
+        header.table_used > header.table_size ||
+        header.head > header.ring_size || header.tail > header.ring_size) {
+      throw std::runtime_error("Not a valid binary log file");
+    }
+    const uint8_t *table = data + header.header_size;
+    const uint8_t *ring = table + header.table_size;
+
+    std::vector<std::pair<std::string, std::string>> location_list;
+    for (uint64_t pos = 0;
+         pos + sizeof(BinaryLogLocation) <= header.table_used;) {
+      BinaryLogLocation location;
+      std::memcpy(&location, table + pos, sizeof(location));
+      if (location.size <= sizeof(location) ||
+          pos + location.size > header.table_used) {
+        break;
+      }
+      const auto *names = reinterpret_cast<const char *>(table + pos) +
+                          sizeof(location);
+      const size_t max_length = location.size - sizeof(location);
+      const std::string file_name(names, strnlen(names, max_length));
+      const size_t function_offset =
+          std::min(file_name.size() + 1, max_length);
+      const std::string function(
+          names + function_offset,
+          strnlen(names + function_offset, max_length - function_offset));
+      location_list.resize(std::max<size_t>(location_list.size(), location.id));
+      if (location.id > 0) {
+        location_list[location.id - 1] = {file_name, function};
+      }
+      pos += location.size;
+    }
+
+    std::ofstream output(text_file, std::ios_base::out | std::ios_base::trunc);
+    if (!output.is_open()) {
+      throw std::runtime_error("Failed to create the text file");
+    }
+
+    // Oldest record first. A full ring is visited at most once.
+    std::string text;
+    uint64_t visited = 0;
+    for (uint64_t pos = header.tail;
+         pos != header.head && visited <= header.ring_size;) {
+      if (pos >= header.ring_size) {
+        pos = 0;
+        continue;
+      }
+      BinaryLogRecord record;
+      std::memcpy(&record.size, ring + pos, sizeof(record.size));
+      if (record.size == detail::kBinaryLogEnd) {
+        visited += header.ring_size - pos;
+        pos = 0;
+        continue;
+      }
+      if (record.size < sizeof(record) ||
+          pos + record.size > header.ring_size) {
+        throw std::runtime_error("Corrupt record in the binary log file");
+      }
+      std::memcpy(&record, ring + pos, sizeof(record));
+      LogMessage message;
+      message.timestamp = std::chrono::system_clock::time_point(
+          std::chrono::duration_cast<std::chrono::system_clock::duration>(
+              std::chrono::nanoseconds(record.timestamp)));
+      message.severity = static_cast<LogSeverity>(record.severity);
+      message.line = record.line;
+      message.column = record.column;
+      message.message.assign(
+          reinterpret_cast<const char *>(ring + pos + sizeof(record)),
+          std::min<uint64_t>(record.length, record.size - sizeof(record)));
+      const bool has_location =
+          record.location > 0 && record.location <= location_list.size();
+      if (has_location) {
+        // The names only need to live while the line is formatted.
+        message.file = location_list[record.location - 1].first.c_str();
+        message.function = location_list[record.location - 1].second.c_str();
+      }
+      detail::LogFile::FormatLine(message, has_location, text);
+      output << text;
+      text.clear();
+
+      visited += record.size;
+      pos += record.size;
+    }
+  } catch (const std::exception &error) {
+    LOG_ERROR() << "Conversion of binary log file failed. Error: "
+                << error.what() << ", File: " << binary_file;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace util::log
+
+namespace util::log::detail {
+
+LogBinaryFile::LogBinaryFile() {
+  EnableSeverityLevel(LogSeverity::kTrace,
+                      false);  // Turn of trace level by default
+  InitLogFile("");
+}
+
+LogBinaryFile::LogBinaryFile(const std::string &base_name) {
+  EnableSeverityLevel(LogSeverity::kTrace,
+                      false);  // Turn of trace level by default
+  InitLogFile(base_name);
+}
+
+LogBinaryFile::~LogBinaryFile() { LogBinaryFile::Stop(); }
+
+std::string LogBinaryFile::Filename() const { return filename_; }
+
+bool LogBinaryFile::HasLogFile() const { return !filename_.empty(); }
+
+void LogBinaryFile::InitLogFile(const std::string &base_name) {
+  try {
+    const auto &log_config = LogConfig::Instance();
+    path base(base_name.empty() ? log_config.BaseName() : base_name);
+    base.replace_extension(".blog");
+    const path filename = FindLogPath(base.string(), ".blog");
+
+    // The last file is kept as it may hold the messages before a crash.
+    BackupFiles(filename.string(), true, log_config.FileGenerations());
+
+    const uint64_t file_size =
+        std::max(Align8(log_config.BinaryFileSize()), kMinFileSize);
+    {
+      std::ofstream create(filename, std::ios_base::binary);
+    }
+    resize_file(filename, file_size);
+
+    file_ = std::make_unique<file_mapping>(filename.string().c_str(),
+                                           read_write);
+    region_ = std::make_unique<mapped_region>(*file_, read_write);
+    auto *data = static_cast<uint8_t *>(region_->get_address());
+
+    header_ = new (data) BinaryLogHeader;
+    header_->table_size =
+        Align8(std::clamp<uint64_t>(file_size / 16, 4096, 1'000'000));
+    header_->ring_size =
+        file_size - header_->header_size - header_->table_size;
+    table_ = data + header_->header_size;
+    ring_ = table_ + header_->table_size;
+    filename_ = filename.string();
+  } catch (const std::exception &error) {
+    region_.reset();
+    file_.reset();
+    header_ = nullptr;
+    filename_.clear();
+    std::cerr << "Couldn't initiate a binary log file. Error: " << error.what()
+              << std::endl;
+  }
+}
+
+void LogBinaryFile::Stop() {
+  std::lock_guard lock(locker_);
+  if (region_) {
+    region_->flush();
+  }
+  header_ = nullptr;
+  table_ = nullptr;
+  ring_ = nullptr;
+  region_.reset();
+  file_.reset();
+}
+
+uint32_t LogBinaryFile::LocationId(const LogMessage &message) {
+  if (*message.file == '\0' && *message.function == '\0') {
+    return 0;
+  }
+  // The names are permanent, so the pointers identify the location.
+  const auto key = std::make_pair(message.file, message.function);
+  const auto itr = location_list_.find(key);
+  if (itr != location_list_.cend()) {
+    return itr->second;
+  }
+  const size_t file_size = std::strlen(message.file) + 1;
+  const size_t function_size = std::strlen(message.function) + 1;
+
+  // Adds the location to the table. A full table gives no location.
+  BinaryLogLocation location;
+  location.size = static_cast<uint32_t>(
+      Align8(sizeof(location) + file_size + function_size));
+  uint32_t id = 0;
+  if (header_->table_used + location.size <= header_->table_size) {
+    id = static_cast<uint32_t>(location_list_.size() + 1);
+    location.id = id;
+    uint8_t *dest = table_ + header_->table_used;
+    std::memset(dest, 0, location.size);
+    std::memcpy(dest, &location, sizeof(location));
+    std::memcpy(dest + sizeof(location), message.file, file_size);
+    std::memcpy(dest + sizeof(location) + file_size, message.function,
+                function_size);
+    header_->table_used += location.size;
+  }
+  location_list_.emplace(key, id);
+  return id;
+}
+
+void LogBinaryFile::DropOldest() {
+  auto &tail = header_->tail;
+  uint32_t size = 0;
+  std::memcpy(&size, ring_ + tail, sizeof(size));
+  if (size == kBinaryLogEnd) {
+    tail = 0;
+  } else if (size < sizeof(BinaryLogRecord)) {
+    tail = header_->head;  // Corrupt ring. Drop all records.
+  } else {
+    const bool wrapped = tail > header_->head;
+    tail += size;
+    if (wrapped && tail >= header_->ring_size) {
+      tail = 0;
+    }
+  }
+}
+
+void LogBinaryFile::Reserve(uint64_t size) {
+  auto &head = header_->head;
+  auto &tail = header_->tail;
+  // The tail is updated before the records are overwritten, so the file is
+  // valid if the application crashes during a write.
+  for (;;) {
+    if (tail <= head) {
+      // The records are in [tail, head).
+      if (head + size <= header_->ring_size) {
+        return;
+      }
+      if (tail == head) {
+        head = tail = 0;  // Empty ring
+        return;
+      }
+      if (tail > size) {
+        if (head < header_->ring_size) {
+          std::memcpy(ring_ + head, &kBinaryLogEnd, sizeof(kBinaryLogEnd));
+        }
+        head = 0;
+        return;
+      }
+    } else if (head + size < tail) {
+      // The records are in [tail, end of ring) and [0, head).
+      return;
+    }
+    DropOldest();
+  }
+}
+
+void LogBinaryFile::AddLogMessage(const LogMessage &message) {
+  if (!IsSeverityLevelEnabled(message.severity)) {
+    return;
+  }
+  std::lock_guard lock(locker_);
+  if (header_ == nullptr) {
+    return;
+  }
+
+  const uint64_t length = std::min(
+      {static_cast<uint64_t>(message.message.size()), kMaxTextLength,
+       header_->ring_size / 2 - sizeof(BinaryLogRecord)});
+  BinaryLogRecord record;
+  record.size = static_cast<uint32_t>(Align8(sizeof(record) + length));
+  record.location = ShowLocation() ? LocationId(message) : 0;
+  record.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         message.timestamp.time_since_epoch())
+                         .count();
+  record.line = message.line;
+  record.column = message.column;
+  record.length = static_cast<uint32_t>(length);
+  record.severity = static_cast<uint8_t>(message.severity);
+
+  Reserve(record.size);
+  uint8_t *dest = ring_ + header_->head;
+  std::memcpy(dest, &record, sizeof(record));
+  std::memcpy(dest + sizeof(record), message.message.data(), length);
+  header_->head += record.size;  // Publish the record
+}
+
+}  // namespace util::log::detail
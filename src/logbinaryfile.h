@@ -0,0 +1,118 @@
+/*
+ * Copyright 2025 Ingemar Hedvall
+ * SPDX-License-Identifier: MIT
+ */
+/** \file logbinaryfile.h
+ * \brief Implements a logger that saves the messages to a binary ring file.
+ */
+#pragma once
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "util/ilogger.h"
+#include "util/logmessage.h"
+
+namespace util::log::detail {
+
+/** \brief Header at the start of a binary log file.
+ *
+ * The file consists of the header, a location table and a ring of message
+ * records. The values are stored in the native byte order.
+ */
+struct BinaryLogHeader {
+  char magic[8] = {'U', 'T', 'I', 'L', 'B', 'L', 'O', 'G'};
+  uint32_t version = 1;
+  uint32_t header_size = sizeof(BinaryLogHeader);
+  uint64_t table_size = 0;  ///< Bytes reserved for the location table.
+  uint64_t table_used = 0;  ///< Bytes used by the location table.
+  uint64_t ring_size = 0;   ///< Bytes in the record ring.
+  uint64_t head = 0;        ///< Offset of the next record in the ring.
+  uint64_t tail = 0;        ///< Offset of the oldest record in the ring.
+  uint64_t reserved = 0;
+};
+
+/** \brief Header of a location in the location table.
+ *
+ * The header is followed by the null-terminated file and function names.
+ */
+struct BinaryLogLocation {
+  uint32_t size = 0;  ///< Total size including the names. 8-byte aligned.
+  uint32_t id = 0;    ///< Location ID. Starts at 1.
+};
+
+/** \brief Header of a message record in the ring.
+ *
+ * The header is followed by the message text. A record that doesn't fit at
+ * the end of the ring is placed at the start. A size of kBinaryLogEnd then
+ * marks the end of the ring.
+ */
+struct BinaryLogRecord {
+  uint32_t size = 0;      ///< Total size including the text. 8-byte aligned.
+  uint32_t location = 0;  ///< Location ID. 0 = No location.
+  int64_t timestamp = 0;  ///< Nanoseconds since 1970 (UTC).
+  uint32_t line = 0;
+  uint32_t column = 0;
+  uint32_t length = 0;  ///< Number of text bytes.
+  uint8_t severity = 0;
+  uint8_t reserved[3] = {};
+};
+
+constexpr uint32_t kBinaryLogEnd = 0xFFFFFFFF;  ///< End of ring marker.
+
+/** \class LogBinaryFile logbinaryfile.h "logbinaryfile.h"
+ * \brief Implements a logger that saves the messages to a binary ring file.
+ *
+ * The file is preallocated and memory-mapped. A log message is copied into
+ * the ring on the caller's thread without any text formatting. The file
+ * and function names are stored once in a location table and the records
+ * refer to them by an ID. When the ring is full, the oldest records are
+ * overwritten, so the file keeps the latest messages. As the file is
+ * mapped, the messages survive an application crash.
+ *
+ * The file is converted to a text log file by the ConvertBinaryLogFile()
+ * function.
+ */
+class LogBinaryFile final : public ILogger {
+ public:
+  LogBinaryFile();  ///< Uses the default base name.
+  explicit LogBinaryFile(const std::string &base_name);
+  ~LogBinaryFile() override;
+
+  LogBinaryFile(const LogBinaryFile &) = delete;
+  LogBinaryFile(LogBinaryFile &&) = delete;
+  LogBinaryFile &operator=(const LogBinaryFile &) = delete;
+  LogBinaryFile &operator=(LogBinaryFile &&) = delete;
+
+  std::string Filename() const override;  ///< Returns the full path file name.
+  bool HasLogFile() const override;       ///< Returns true if the file is open.
+
+  void AddLogMessage(
+      const LogMessage &message) override;  ///< Handle a log message
+  void Stop() override;                     ///< Flushes and closes the file.
+
+ private:
+  std::string filename_;
+  std::mutex locker_;
+  std::unique_ptr<boost::interprocess::file_mapping> file_;
+  std::unique_ptr<boost::interprocess::mapped_region> region_;
+  BinaryLogHeader *header_ = nullptr;
+  uint8_t *table_ = nullptr;  ///< Start of the location table.
+  uint8_t *ring_ = nullptr;   ///< Start of the record ring.
+  /// Location ID by file and function name pointers.
+  std::map<std::pair<const char *, const char *>, uint32_t> location_list_;
+
+  void InitLogFile(const std::string &base_name);
+  [[nodiscard]] uint32_t LocationId(const LogMessage &message);
+  /// Makes room for a record at the head by dropping the oldest records.
+  void Reserve(uint64_t size);
+  void DropOldest();
+};
+
+}  // namespace util::log::detail
@@ -15,6 +15,7 @@
 #endif
 
 #include "listenlogger.h"
+#include "logbinaryfile.h"
 #include "logconsole.h"
 #include "logfile.h"
 #include "syslog.h"
@@ -94,6 +95,15 @@ bool LogConfig::CreateDefaultLogger() {
       }
     } break;
 
+    case LogType::LogToBinaryFile: {
+      auto log_file = std::make_unique<detail::LogBinaryFile>();
+      create = log_file->HasLogFile();
+      if (create) {
+        std::lock_guard<std::mutex> lock(locker_);
+        log_chain_.emplace("Default", std::move(log_file));
+      }
+    } break;
+
     case LogType::LogToSyslog: {
       auto syslog = std::make_unique<detail::Syslog>("localhost", 514);
       std::lock_guard<std::mutex> lock(locker_);
@@ -126,28 +136,126 @@ bool LogConfig::CreateDefaultLogger() {
     default:
       break;
   }
+  {
+    // The log macros check the severities of all loggers
+    std::lock_guard<std::mutex> lock(locker_);
+    const auto itr = log_chain_.find("Default");
+    if (itr != log_chain_.end() && itr->second) {
+      itr->second->AttachSeverityCount(&severity_count_);
+    }
+  }
   return create;
 }
 
-LogConfig::~LogConfig() { DeleteLogChain(); }
+LogConfig::~LogConfig() {
+  AsyncLogging(false);
+  DeleteLogChain();
+}
 
 void LogConfig::DeleteLogChain() {
+  // The dispatcher thread may not use the loggers while they are deleted.
+  const bool async = async_.exchange(false);
+  if (async) {
+    StopDispatcher();
+  }
   for (auto &itr : log_chain_) {
     itr.second->Stop();
   }
   log_chain_.clear();
+  if (async) {
+    StartDispatcher();
+    async_ = true;
+  }
 }
 
 void LogConfig::AddLogMessage(const LogMessage &message) const {
   if (!Enabled()) {
     return;
   }
+  if (async_) {
+    AddLogMessage(LogMessage(message));
+    return;
+  }
+  std::lock_guard<std::mutex> lock(locker_);
+  for (auto &itr : log_chain_) {
+    itr.second->AddLogMessage(message);
+  }
+}
+
+void LogConfig::AddLogMessage(LogMessage &&message) const {
+  if (!Enabled()) {
+    return;
+  }
+  if (async_) {
+    auto msg = std::make_unique<LogMessage>(std::move(message));
+    if (async_queue_.Put(msg)) {
+      return;
+    }
+    // The queue is stopped. Log the message on this thread instead.
+    message = std::move(*msg);
+  }
   std::lock_guard<std::mutex> lock(locker_);
   for (auto &itr : log_chain_) {
     itr.second->AddLogMessage(message);
   }
 }
 
+void LogConfig::AsyncLogging(bool async) {
+  if (async) {
+    StartDispatcher();
+    async_ = true;
+  } else {
+    async_ = false;
+    StopDispatcher();
+  }
+}
+
+void LogConfig::StartDispatcher() {
+  std::lock_guard lock(dispatcher_lock_);
+  if (dispatcher_thread_.joinable()) {
+    return;
+  }
+  async_queue_.Start();
+  dispatcher_thread_ = std::thread(&LogConfig::DispatcherTask, this);
+}
+
+void LogConfig::StopDispatcher() {
+  std::lock_guard lock(dispatcher_lock_);
+  if (!dispatcher_thread_.joinable()) {
+    return;
+  }
+  // The stop waits for producers that are adding messages. Any late
+  // messages are logged by the caller as the queue is stopped.
+  async_queue_.Stop();
+  dispatcher_thread_.join();
+
+  // Dispatch the remaining messages.
+  std::vector<std::unique_ptr<LogMessage>> msg_list;
+  if (async_queue_.GetRemaining(msg_list)) {
+    DispatchMessages(msg_list);
+  }
+}
+
+void LogConfig::DispatcherTask() {
+  std::vector<std::unique_ptr<LogMessage>> msg_list;
+  while (async_queue_.GetAll(msg_list, true)) {
+    DispatchMessages(msg_list);
+  }
+}
+
+void LogConfig::DispatchMessages(
+    std::vector<std::unique_ptr<LogMessage>> &msg_list) {
+  std::lock_guard<std::mutex> lock(locker_);
+  for (auto &msg : msg_list) {
+    // All loggers share the same immutable message
+    const std::shared_ptr<const LogMessage> shared = std::move(msg);
+    for (auto &itr : log_chain_) {
+      itr.second->AddSharedMessage(shared);
+    }
+  }
+  msg_list.clear();
+}
+
 void LogConfig::AddLogger(const std::string &logger_name, const LogType type,
                           const std::vector<std::string> &arg_list) {
   std::unique_ptr<ILogger> logger;
@@ -162,6 +270,12 @@ void LogConfig::AddLogger(const std::string &logger_name, const LogType type,
       break;
     }
 
+    case LogType::LogToBinaryFile: {
+      const auto base_name = arg_list.empty() ? logger_name : arg_list[0];
+      logger = std::make_unique<detail::LogBinaryFile>(base_name);
+      break;
+    }
+
     case LogType::LogToListen:
       logger = std::make_unique<detail::ListenLogger>();
       break;
@@ -187,6 +301,10 @@ void LogConfig::AddLogger(const std::string &logger_name, const LogType type,
 
 void LogConfig::AddLogger(const std::string &logger_name,
                           std::unique_ptr<ILogger> logger) {
+  if (logger) {
+    // The log macros check the severities of all loggers
+    logger->AttachSeverityCount(&severity_count_);
+  }
   std::lock_guard<std::mutex> lock(locker_);
   auto itr = log_chain_.find(logger_name);
   if (itr == log_chain_.end()) {
@@ -9,6 +9,12 @@
 #include <filesystem>
 #include <iostream>
 
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 #include "util/logconfig.h"
 #include "util/logging.h"
 #include "util/logstream.h"
@@ -28,13 +34,12 @@ std::string GetStem(const std::string &file) {
   return file;
 }
 
-/**
- * Returns the preferred program data root dir. In windows this is
- * 'c:\programdata'.
- * @return empty string or the preferred application data directory.
- */
+}  // namespace
 
-std::string FindLogPath(const std::string &base_name) {
+namespace util::log::detail {
+
+std::string FindLogPath(const std::string &base_name,
+                        const std::string &extension) {
   try {
     auto &log_config = util::log::LogConfig::Instance();
 
@@ -42,7 +47,7 @@ std::string FindLogPath(const std::string &base_name) {
 
     // Add an extension if it is missing
     if (!filename.has_extension()) {
-      filename.replace_extension(".log");
+      filename.replace_extension(extension);
     }
 
     // If the user supply a full path, then use the path as it is
@@ -72,9 +77,6 @@ std::string FindLogPath(const std::string &base_name) {
     throw error;  // No meaning to log the error to file
   }
 }
-}  // namespace
-
-namespace util::log::detail {
 
 std::string LogFile::Filename() const { return filename_; }
 
@@ -104,86 +106,195 @@ LogFile::~LogFile() {
 
 void LogFile::StartWorkerThread() {
   stop_thread_ = false;
-  worker_thread_ = std::thread(&LogFile::WorkerThread, this);
+  worker_thread_ = high_throughput_
+                       ? std::thread(&LogFile::HighThroughputThread, this)
+                       : std::thread(&LogFile::WorkerThread, this);
 }
 
-void LogFile::WorkerThread() {
+void LogFile::StartFile() {
   try {
-    BackupFiles(filename_);
+    BackupFiles(filename_, true, generations_);
   } catch (const std::exception &error) {
     LOG_ERROR() << "Didn't backup log files at start. Error: " << error.what();
   }
+  // The size is only read once. After this, the writer counts the bytes.
+  std::error_code error_code;
+  const auto size = file_size(filename_, error_code);
+  file_size_ = error_code ? 0 : size;
+}
+
+void LogFile::StartRotation() {
+  WaitForRotation();  // The previous rotation is normally done long ago.
+  try {
+    // A rename within the directory is fast. The slow part is done later.
+    path rotated(filename_);
+    rotated += ".rotate";
+    rename(filename_, rotated);
+    rotate_thread_ = std::thread(
+        [filename = filename_, source = rotated.string(),
+         generations = generations_, compress = compress_backups_] {
+          RotateFile(filename, source, generations, compress);
+        });
+  } catch (const std::exception &error) {
+    LOG_ERROR() << "Didn't rotate the log file. Error: " << error.what();
+  }
+  file_size_ = 0;  // Also avoids retrying a failed rotation on each batch.
+}
+
+void LogFile::WaitForRotation() {
+  if (rotate_thread_.joinable()) {
+    rotate_thread_.join();
+  }
+}
+
+void LogFile::WorkerThread() {
+  StartFile();
 
   do {
     std::unique_lock<std::mutex> lock(locker_);
-    condition_.wait_for(lock, 1000ms, [&] { return stop_thread_.load(); });
+    condition_.wait_for(lock, flush_interval_,
+                        [&] { return stop_thread_.load(); });
 
     int message_count = 0;
     for (; !message_list_.empty() && message_count <= 10000; ++message_count) {
-      LogMessage m = message_list_.front();
+      const auto m = std::move(message_list_.front());
       message_list_.pop();
       lock.unlock();
-      HandleMessage(m);
+      HandleMessage(*m);
       lock.lock();
     }
+    lock.unlock();
     if (file_ != nullptr) {
       std::fclose(file_);
       file_ = nullptr;
     }
-    try {
-      if (message_count > 0) {
-        path p(filename_);
-        if (file_ == nullptr && exists(p) && file_size(p) > 10'000'000) {
-          BackupFiles(filename_);
-        }
-      }
-    } catch (const std::exception &error) {
-      LOG_ERROR() << "Didn't backup log files. Error: " << error.what();
+    if (message_count > 0 && file_size_ > rotation_size_) {
+      StartRotation();
     }
   } while (!stop_thread_);
 
   while (!message_list_.empty()) {
-    LogMessage m = message_list_.front();
+    const auto m = std::move(message_list_.front());
     message_list_.pop();
-    HandleMessage(m);
+    HandleMessage(*m);
   }
 
   if (file_ != nullptr) {
     std::fclose(file_);
     file_ = nullptr;
   }
+  WaitForRotation();
 }
 
-void LogFile::HandleMessage(const LogMessage &m) {
+void LogFile::HighThroughputThread() {
+  StartFile();
+
+  std::queue<std::shared_ptr<const LogMessage>> batch;
+  last_sync_ = std::chrono::steady_clock::now();
+  for (bool stop = false; !stop;) {
+    {
+      // The whole queue is taken with one lock
+      std::unique_lock<std::mutex> lock(locker_);
+      condition_.wait_for(lock, flush_interval_,
+                          [&] { return stop_thread_.load(); });
+      stop = stop_thread_;
+      message_list_.swap(batch);
+    }
+    for (; !batch.empty(); batch.pop()) {
+      FormatLine(*batch.front(), ShowLocation(), batch_text_);
+    }
+    WriteBatch();
+
+    if (file_ != nullptr && file_size_ > rotation_size_) {
+      std::fclose(file_);
+      file_ = nullptr;
+      StartRotation();
+    }
+  }
+
+  if (file_ != nullptr) {
+    if (sync_interval_ > 0ms) {
+      SyncFile();
+    }
+    std::fclose(file_);
+    file_ = nullptr;
+  }
+  WaitForRotation();
+}
+
+void LogFile::WriteBatch() {
+  if (batch_text_.empty()) {
+    return;
+  }
   if (file_ == nullptr) {
     file_ = fopen(filename_.c_str(), "at");
+    if (file_ != nullptr) {
+      // The batch text is the buffer. One write call per batch.
+      std::setvbuf(file_, nullptr, _IONBF, 0);
+    }
+  }
+  if (file_ != nullptr) {
+    file_size_ += std::fwrite(batch_text_.data(), 1, batch_text_.size(), file_);
   }
+  batch_text_.clear();  // Keeps the capacity
+
+  const auto now = std::chrono::steady_clock::now();
+  if (file_ != nullptr && sync_interval_ > 0ms &&
+      now - last_sync_ >= sync_interval_) {
+    SyncFile();
+    last_sync_ = now;
+  }
+}
+
+void LogFile::SyncFile() {
   if (file_ == nullptr) {
     return;
   }
+#ifdef _WIN32
+  _commit(_fileno(file_));
+#else
+  fsync(fileno(file_));
+#endif
+}
+
+void LogFile::FormatLine(const LogMessage &m, bool show_location,
+                         std::string &text) {
   if (m.message.empty()) {
     return;
   }
   const char last = m.message.back();
   const bool has_newline = last == '\n' || last == '\r';
-  const std::string time = time::GetLocalTimestampWithMs(m.timestamp);
-  const std::string severity = GetSeverityString(m.severity);
-
-  std::ostringstream temp;
-  temp << "[" << time << "] " << severity << " ";
-  if (has_newline) {
-    std::string text = m.message;
-    text.pop_back();
-    temp << text << " ";
-  } else {
-    temp << m.message << " ";
+
+  text += '[';
+  time::AppendLocalTimestampWithMs(m.timestamp, text);
+  text += "] ";
+  text += GetSeverityString(m.severity);
+  text += ' ';
+  const size_t length = has_newline ? m.message.size() - 1 : m.message.size();
+  text.append(m.message, 0, length);
+  text += ' ';
+  if (show_location) {
+    text += "    [";
+    text += GetStem(m.file);
+    text += ':';
+    text += m.function;
+    text += ':';
+    text += std::to_string(m.line);
+    text += ']';
+  }
+  text += '\n';
+}
+
+void LogFile::HandleMessage(const LogMessage &m) {
+  if (file_ == nullptr) {
+    file_ = fopen(filename_.c_str(), "at");
   }
-  if (ShowLocation()) {
-    temp << "    [" << GetStem(m.file) << ":" << m.function << ":" << m.line
-         << "]";
+  if (file_ == nullptr) {
+    return;
   }
-  temp << std::endl;
-  std::fwrite(temp.str().data(), 1, temp.str().size(), file_);
+  std::string text;
+  FormatLine(m, ShowLocation(), text);
+  file_size_ += std::fwrite(text.data(), 1, text.size(), file_);
 }
 
 /**
@@ -195,6 +306,14 @@ void LogFile::AddLogMessage(const LogMessage &message) {
   if (stop_thread_ || !IsSeverityLevelEnabled(message.severity)) {
     return;
   }
+  AddSharedMessage(std::make_shared<const LogMessage>(message));
+}
+
+void LogFile::AddSharedMessage(
+    const std::shared_ptr<const LogMessage> &message) {
+  if (stop_thread_ || !message || !IsSeverityLevelEnabled(message->severity)) {
+    return;
+  }
 
   {
     std::lock_guard<std::mutex> lock(locker_);
@@ -245,6 +364,14 @@ void LogFile::InitLogFile(const std::string &base_name) {
                                    p.string());
     }
     filename_ = p.string();
+
+    const auto &log_config = LogConfig::Instance();
+    high_throughput_ = log_config.FileHighThroughput();
+    flush_interval_ = log_config.FileFlushInterval();
+    sync_interval_ = log_config.FileSyncInterval();
+    rotation_size_ = log_config.FileRotationSize();
+    generations_ = log_config.FileGenerations();
+    compress_backups_ = log_config.FileCompressBackups();
     StartWorkerThread();
   } catch (const std::exception &error) {
     std::cerr << "Couldn't initiate a log file. Error: " << error.what()
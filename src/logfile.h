@@ -7,7 +7,9 @@
  */
 #pragma once
 
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <cstdio>
 #include <mutex>
 #include <queue>
@@ -19,12 +21,31 @@
 
 namespace util::log::detail {
 
+/** \brief Returns the full path to a log file.
+ *
+ * The base name may be a full path. Otherwise is the file placed in the
+ * log directory that is defined by the LogConfig root and sub-directory.
+ * @param base_name Base name (stem) or full path of the file.
+ * @param extension Extension that is added if the base name has none.
+ * @return Full path to the log file.
+ */
+std::string FindLogPath(const std::string &base_name,
+                        const std::string &extension = ".log");
+
 /** \class LogFile logfile.h "logfile.h"
  * \brief Implement a logger that saves log messages to a file.
  *
  * Logger that saves the messages to file. The file has a rotating backup of the
  * last 10 files. The logger have an internal message queue so it will not delay
  * the application.
+ *
+ * The file size is counted by the writer. When the file passes the rotation
+ * size, it is renamed and a new file is started. The backup files are
+ * shifted, and optionally compressed, by a background thread. See
+ * LogConfig::FileRotationSize().
+ *
+ * In high-throughput mode, the file is kept open and each batch of messages
+ * is written with one call. See LogConfig::FileHighThroughput().
  */
 class LogFile final : public ILogger {
  public:
@@ -41,23 +62,57 @@ class LogFile final : public ILogger {
 
   void AddLogMessage(
       const LogMessage &message) override;  ///< Handle a log message
+  void AddSharedMessage(const std::shared_ptr<const LogMessage> &message)
+      override;  ///< Queues the shared message without a copy.
   bool HasLogFile() const override;         ///< Return true.
 
   void Stop() override;  ///< Stops the working thread.
 
+  /** \brief Appends a message as a formatted log line to the text.
+   *
+   * This is the text format of the log file. It is also used when a binary
+   * log file is converted to text.
+   * @param m Log message.
+   * @param show_location True if the source location should be appended.
+   * @param text Text to append the line to.
+   */
+  static void FormatLine(const LogMessage &m, bool show_location,
+                         std::string &text);
+
  private:
   std::FILE *file_ = nullptr;
   std::string filename_;
   std::mutex locker_;
 
-  std::queue<LogMessage> message_list_;
+  std::queue<std::shared_ptr<const LogMessage>> message_list_;
   std::thread worker_thread_;
   std::atomic<bool> stop_thread_ = false;
   std::condition_variable condition_;
 
+  bool high_throughput_ = false;  ///< Keeps the file open. Batch writes.
+  std::chrono::milliseconds flush_interval_ = std::chrono::milliseconds(1000);
+  std::chrono::milliseconds sync_interval_ = std::chrono::milliseconds(0);
+  std::chrono::steady_clock::time_point last_sync_;
+  std::string batch_text_;  ///< Formatted batch. Reused by the worker.
+
+  uint64_t rotation_size_ = 10'000'000;  ///< Rotates the file at this size.
+  size_t generations_ = 10;              ///< Number of backup files.
+  bool compress_backups_ = false;        ///< Gzip compress the backup files.
+  uint64_t file_size_ = 0;  ///< Bytes in the file. Counted by the worker.
+  std::thread rotate_thread_;  ///< Shifts the backup files. Owned by worker.
+
   void InitLogFile(const std::string &base_name);
   void StartWorkerThread();
   void WorkerThread();
+  void HighThroughputThread();
+  /// Backs up any old log file and initiates the file size.
+  void StartFile();
+  /// Renames the file and shifts the backups on a background thread.
+  void StartRotation();
+  void WaitForRotation();
   void HandleMessage(const LogMessage &m);
+  /// Writes the batch text with one call and syncs the file if it is time.
+  void WriteBatch();
+  void SyncFile();
 };
 }  // namespace util::log::detail
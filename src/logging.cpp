@@ -2,13 +2,20 @@
  * Copyright 2021 Ingemar Hedvall
  * SPDX-License-Identifier: MIT
  */
+#include <algorithm>
 #include <cstdarg>
+#include <cstdio>
 #include <filesystem>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <boost/asio.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/process.hpp>
+#include <zlib.h>
 
 #include "util/logconfig.h"
 #include "util/logging.h"
@@ -16,16 +23,84 @@
 
 namespace {
 
-void SendLogMessage(const util::log::LogMessage &m) {
+void SendLogMessage(util::log::LogMessage &&m) {
   const auto &log_config = util::log::LogConfig::Instance();
-  log_config.AddLogMessage(m);
+  log_config.AddLogMessage(std::move(m));
+}
+
+
+/// Returns the path to a backup file (xxx_N.ext or xxx_N.ext.gz).
+std::filesystem::path BackupPath(const std::filesystem::path &full,
+                                 size_t index, bool compressed) {
+  std::ostringstream temp;
+  temp << full.stem().string() << "_" << index << full.extension().string();
+  if (compressed) {
+    temp << ".gz";
+  }
+  std::filesystem::path file(full.parent_path());
+  file.append(temp.str());
+  return file;
+}
+
+/// Removes the oldest backup and shifts xxx_N-1 -> xxx_N, so xxx_0 is free.
+void ShiftBackupFiles(const std::filesystem::path &full,
+                      size_t nof_generations) {
+  nof_generations = std::max(nof_generations, size_t{1});
+  for (const bool compressed : {false, true}) {
+    const auto last = BackupPath(full, nof_generations - 1, compressed);
+    if (std::filesystem::exists(last)) {
+      std::filesystem::remove(last);
+    }
+    for (size_t ii = nof_generations - 1; ii > 0; --ii) {
+      const auto file2 = BackupPath(full, ii - 1, compressed);
+      if (std::filesystem::exists(file2)) {
+        std::filesystem::rename(file2, BackupPath(full, ii, compressed));
+      }
+    }
+  }
+}
+
+/// Compresses a file into file.gz and removes the original file.
+void CompressFile(const std::filesystem::path &file) {
+  std::filesystem::path gz_file(file);
+  gz_file += ".gz";
+
+  std::FILE *input = std::fopen(file.string().c_str(), "rb");
+  if (input == nullptr) {
+    throw std::runtime_error("Failed to open the file");
+  }
+  gzFile output = gzopen(gz_file.string().c_str(), "wb");
+  if (output == nullptr) {
+    std::fclose(input);
+    throw std::runtime_error("Failed to create the compressed file");
+  }
+  bool valid = true;
+  std::vector<char> buffer(64 * 1024);
+  for (size_t bytes = std::fread(buffer.data(), 1, buffer.size(), input);
+       valid && bytes > 0;
+       bytes = std::fread(buffer.data(), 1, buffer.size(), input)) {
+    valid = gzwrite(output, buffer.data(), static_cast<unsigned>(bytes)) ==
+            static_cast<int>(bytes);
+  }
+  valid = gzclose(output) == Z_OK && valid;
+  std::fclose(input);
+
+  if (!valid) {
+    std::filesystem::remove(gz_file);
+    throw std::runtime_error("Failed to compress the file");
+  }
+  std::filesystem::remove(file);
 }
 
 }  // namespace
 namespace util::log {
 
+bool IsLogEnabled(LogSeverity severity) {
+  return LogConfig::Instance().IsSeverityEnabled(severity);
+}
+
 void LogDebug(const Loc &loc, const char *fmt, ...) {
-  if (fmt == nullptr) {
+  if (fmt == nullptr || !IsLogEnabled(LogSeverity::kDebug)) {
     return;
   }
   char buffer[5000]{};
@@ -39,7 +114,7 @@ void LogDebug(const Loc &loc, const char *fmt, ...) {
 }
 
 void LogInfo(const Loc &loc, const char *fmt, ...) {
-  if (fmt == nullptr) {
+  if (fmt == nullptr || !IsLogEnabled(LogSeverity::kInfo)) {
     return;
   }
   char buffer[5000]{};
@@ -53,7 +128,7 @@ void LogInfo(const Loc &loc, const char *fmt, ...) {
 }
 
 void LogError(const Loc &loc, const char *fmt, ...) {
-  if (fmt == nullptr) {
+  if (fmt == nullptr || !IsLogEnabled(LogSeverity::kError)) {
     return;
   }
   char buffer[5000]{};
@@ -76,7 +151,7 @@ void LogString(const Loc &location, LogSeverity severity,
   m.function = location.function_name();
   m.severity = severity;
 
-  SendLogMessage(m);
+  SendLogMessage(std::move(m));
 }
 
 void LogStringEx(uint32_t line, uint32_t column, const std::string &file,
@@ -86,11 +161,11 @@ void LogStringEx(uint32_t line, uint32_t column, const std::string &file,
   m.message = message;
   m.line = line;
   m.column = column;
-  m.file = file;
-  m.function = function;
+  m.file = InternString(file);
+  m.function = InternString(function);
   m.severity = severity;
 
-  SendLogMessage(m);
+  SendLogMessage(std::move(m));
 }
 
 std::string FindNotepad() {
@@ -151,7 +226,8 @@ std::string FindNotepad() {
   return note;
 }
 
-bool BackupFiles(const std::string &filename, bool remove_file) {
+bool BackupFiles(const std::string &filename, bool remove_file,
+                 size_t nof_generations) {
   if (filename.empty()) {
     LOG_ERROR() << "File name is empty. Illegal use of function";
     return false;
@@ -159,37 +235,16 @@ bool BackupFiles(const std::string &filename, bool remove_file) {
 
   try {
     const std::filesystem::path full(filename);
-    const std::filesystem::path parent(full.parent_path());
-    const std::filesystem::path stem(full.stem());
-    const std::filesystem::path ext(full.extension());
     if (!std::filesystem::exists(full)) {
       return true;  // No meaning to back up if original doesn't exist.
     }
     // shift all file xxx_N -> xxx_N-1 and last xxx -> xxx_0
-    for (int ii = 9; ii >= 0; --ii) {
-      std::ostringstream temp1;
-      temp1 << stem.string() << "_" << ii << ext.string();
-
-      std::filesystem::path file1(parent);
-      file1.append(temp1.str());
-      if (std::filesystem::exists(file1) && ii == 9) {
-        std::filesystem::remove(file1);
-      }
-      if (ii == 0) {
-        if (remove_file) {
-          std::filesystem::rename(full, file1);
-        } else {
-          std::filesystem::copy(full, file1);
-        }
-      } else {
-        std::ostringstream temp2;
-        temp2 << stem.string() << "_" << ii - 1 << ext.string();
-        std::filesystem::path file2(parent);
-        file2.append(temp2.str());
-        if (std::filesystem::exists(file2)) {
-          std::filesystem::rename(file2, file1);
-        }
-      }
+    ShiftBackupFiles(full, nof_generations);
+    const auto file0 = BackupPath(full, 0, false);
+    if (remove_file) {
+      std::filesystem::rename(full, file0);
+    } else {
+      std::filesystem::copy(full, file0);
     }
   } catch (const std::exception &error) {
     LOG_ERROR() << "Backup of file failed. Error: " << error.what()
@@ -199,4 +254,30 @@ bool BackupFiles(const std::string &filename, bool remove_file) {
   return true;
 }
 
+bool RotateFile(const std::string &filename, const std::string &source,
+                size_t nof_generations, bool compress) {
+  if (filename.empty() || source.empty()) {
+    LOG_ERROR() << "File name is empty. Illegal use of function";
+    return false;
+  }
+
+  try {
+    const std::filesystem::path full(filename);
+    if (!std::filesystem::exists(source)) {
+      return true;
+    }
+    ShiftBackupFiles(full, nof_generations);
+    const auto file0 = BackupPath(full, 0, false);
+    std::filesystem::rename(source, file0);
+    if (compress) {
+      CompressFile(file0);
+    }
+  } catch (const std::exception &error) {
+    LOG_ERROR() << "Rotation of file failed. Error: " << error.what()
+                << ", File: " << filename;
+    return false;
+  }
+  return true;
+}
+
 }  // namespace util::log
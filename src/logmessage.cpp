@@ -4,6 +4,8 @@
  */
 #include "util/logmessage.h"
 
+#include <mutex>
+#include <set>
 #include <string>
 
 namespace util::log {
@@ -32,4 +34,17 @@ std::string GetSeverityString(LogSeverity severity) {
   }
   return "[Unknown]";
 }
+
+const char *InternString(std::string_view text) {
+  // The set nodes are never moved, so the text pointers are stable.
+  static std::mutex locker;
+  static std::set<std::string, std::less<>> text_list;
+  std::lock_guard lock(locker);
+  auto itr = text_list.find(text);
+  if (itr == text_list.end()) {
+    itr = text_list.emplace(text).first;
+  }
+  return itr->c_str();
+}
+
 }  // namespace util::log
\ No newline at end of file
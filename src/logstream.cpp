@@ -4,9 +4,75 @@
  */
 #include "util/logstream.h"
 
+#include <utility>
+
+#include "util/logconfig.h"
+
+namespace {
+
+/** \brief Text buffer that is reused by all log streams of a thread.
+ *
+ * A log statement inside another log statement's stream operator uses its
+ * own buffer instead.
+ */
+struct ThreadText {
+  std::string text;
+  bool busy = false;
+};
+
+thread_local ThreadText kThreadText;
+
+std::string &AcquireText(bool thread_text, std::string &own_text) {
+  if (!thread_text) {
+    return own_text;
+  }
+  kThreadText.busy = true;
+  kThreadText.text.clear();  // Keeps the capacity
+  return kThreadText.text;
+}
+
+}  // namespace
+
 namespace util::log {
+
+LogStream::TextBuffer::int_type LogStream::TextBuffer::overflow(
+    int_type in_char) {
+  if (!traits_type::eq_int_type(in_char, traits_type::eof())) {
+    text_.push_back(traits_type::to_char_type(in_char));
+  }
+  return traits_type::not_eof(in_char);
+}
+
+std::streamsize LogStream::TextBuffer::xsputn(const char *text,
+                                              std::streamsize count) {
+  text_.append(text, static_cast<size_t>(count));
+  return count;
+}
+
 LogStream::LogStream(const Loc &location, LogSeverity severity)
-    : location_(location), severity_(severity) {}
+    : std::ostream(nullptr),
+      location_(location),
+      severity_(severity),
+      thread_text_(!kThreadText.busy),
+      text_(&AcquireText(thread_text_, own_text_)),
+      buffer_(*text_) {
+  rdbuf(&buffer_);
+}
+
+LogStream::~LogStream() {
+  LogMessage message;
+  message.message = std::move(*text_);
+  message.line = location_.line();
+  message.column = location_.column();
+  message.file = location_.file_name();
+  message.function = location_.function_name();
+  message.severity = severity_;
+  LogConfig::Instance().AddLogMessage(std::move(message));
 
-LogStream::~LogStream() { LogString(location_, severity_, str()); }
+  if (thread_text_) {
+    // Takes back the buffer if the text wasn't moved into a queue
+    kThreadText.text = std::move(message.message);  // NOLINT
+    kThreadText.busy = false;
+  }
+}
 }  // namespace util::log
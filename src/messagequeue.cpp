@@ -5,25 +5,254 @@
 #include "messagequeue.h"
 
 #include <boost/interprocess/sync/scoped_lock.hpp>
+#include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
 #include <thread>
 using namespace boost::interprocess;
 using namespace std::chrono_literals;
 
+namespace {
+
+using namespace util::log::detail;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "The ring queue requires lock-free 64-bit atomics");
+static_assert(sizeof(SharedListenRing) % alignof(SharedListenSlot) == 0,
+              "The ring slots must be aligned to cache lines");
+static_assert(sizeof(SharedListenRecord) % 8 == 0,
+              "The records must be 8-byte aligned");
+
+SharedListenQueue &ToMutexQueue(SharedQueueHeader &queue) {
+  return queue.base;
+}
+
+SharedListenRing &ToRing(SharedQueueHeader &queue) {
+  return *reinterpret_cast<SharedListenRing *>(&queue);
+}
+
+SharedListenRecordRing &ToRecordRing(SharedQueueHeader &queue) {
+  return *reinterpret_cast<SharedListenRecordRing *>(&queue);
+}
+
+std::string_view FixedText(const char *text, size_t max_size) {
+  return {text, strnlen(text, max_size)};
+}
+
+void CopyFixedText(std::string_view text, char *dest, size_t max_size) {
+  const size_t size = std::min(text.size(), max_size - 1);
+  memcpy(dest, text.data(), size);
+  dest[size] = '\0';
+}
+
+uint64_t RecordSize(std::string_view pre_text, std::string_view text) {
+  const uint64_t size =
+      sizeof(SharedListenRecord) + pre_text.size() + text.size();
+  return (size + 7) & ~uint64_t{7};
+}
+
+void WakeConsumer(SharedQueueHeader &mem) {
+  // Only wake the master if it is waiting on the semaphore.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (mem.consumer_waiting.load(std::memory_order_relaxed) &&
+      mem.consumer_waiting.exchange(false)) {
+    mem.base.message_semaphore.post();
+  }
+}
+
+template <typename Pop>
+bool WaitAndPop(SharedQueueHeader &mem, const std::atomic<bool> &stop,
+                Pop &&pop) {
+  while (!stop) {
+    if (pop()) {
+      return true;
+    }
+    mem.consumer_waiting = true;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (pop()) {
+      mem.consumer_waiting = false;
+      return true;
+    }
+    mem.base.message_semaphore.wait();
+  }
+  return false;
+}
+
+bool PushMutexQueue(SharedListenQueue &mem, const SharedListenMessage &msg) {
+  scoped_lock lock(mem.locker);
+  if (mem.nof_messages > 255) {
+    return false;
+  }
+  auto &in_msg = mem.queue[mem.queue_in];
+  in_msg = msg;
+  ++mem.queue_in;
+  ++mem.nof_messages;
+  mem.message_semaphore.post();
+  return true;
+}
+
+bool PopMutexQueue(SharedListenQueue &mem, SharedListenMessage &msg) {
+  scoped_lock lock(mem.locker);
+  if (mem.nof_messages == 0) {
+    return false;
+  }
+  const auto &out_msg = mem.queue[mem.queue_out];
+  msg = out_msg;
+  ++mem.queue_out;
+  --mem.nof_messages;
+  return true;
+}
+
+bool PushRing(SharedListenRing &ring, const SharedListenMessage &msg) {
+  auto *slots = ring.Slots();
+  uint64_t pos = ring.tail.load(std::memory_order_relaxed);
+  for (;;) {
+    auto &slot = slots[pos & ring.mask];
+    const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+    const auto diff = static_cast<int64_t>(sequence - pos);
+    if (diff == 0) {
+      if (ring.tail.compare_exchange_weak(pos, pos + 1,
+                                          std::memory_order_relaxed)) {
+        slot.msg = msg;
+        slot.sequence.store(pos + 1, std::memory_order_release);
+        break;
+      }
+    } else if (diff < 0) {
+      return false;  // Queue is full
+    } else {
+      pos = ring.tail.load(std::memory_order_relaxed);
+    }
+  }
+  WakeConsumer(ring.header);
+  return true;
+}
+
+bool PopRing(SharedListenRing &ring, SharedListenMessage &msg) {
+  const uint64_t pos = ring.head.load(std::memory_order_relaxed);
+  auto &slot = ring.Slots()[pos & ring.mask];
+  const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+  if (sequence != pos + 1) {
+    return false;  // Queue is empty
+  }
+  msg = slot.msg;
+  slot.sequence.store(pos + ring.capacity, std::memory_order_release);
+  ring.head.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+bool PushRecord(SharedListenRecordRing &ring, uint64_t ns1970,
+                std::string_view pre_text, std::string_view text) {
+  const uint64_t record_size = RecordSize(pre_text, text);
+  uint64_t pos = ring.tail.load(std::memory_order_relaxed);
+  uint64_t needed = record_size;
+  for (;;) {
+    // A record that doesn't fit at the end, needs a padding record first.
+    const uint64_t to_end = ring.capacity - (pos & ring.mask);
+    needed = record_size <= to_end ? record_size : to_end + record_size;
+    const uint64_t head = ring.head.load(std::memory_order_acquire);
+    if (pos + needed - head > ring.capacity) {
+      return false;  // Queue is full
+    }
+    if (ring.tail.compare_exchange_weak(pos, pos + needed,
+                                        std::memory_order_relaxed)) {
+      break;
+    }
+  }
+  auto *buffer = ring.Buffer();
+  uint64_t offset = pos & ring.mask;
+  if (needed != record_size) {
+    auto *padding = reinterpret_cast<std::atomic<uint32_t> *>(buffer + offset);
+    padding->store(SharedListenRecord::kPaddingFlag |
+                       static_cast<uint32_t>(ring.capacity - offset),
+                   std::memory_order_release);
+    offset = 0;
+  }
+  auto *record = reinterpret_cast<SharedListenRecord *>(buffer + offset);
+  record->text_size = static_cast<uint32_t>(text.size());
+  record->pre_text_size = static_cast<uint32_t>(pre_text.size());
+  record->ns1970 = ns1970;
+  auto *data = buffer + offset + sizeof(SharedListenRecord);
+  if (!pre_text.empty()) {
+    memcpy(data, pre_text.data(), pre_text.size());
+  }
+  if (!text.empty()) {
+    memcpy(data + pre_text.size(), text.data(), text.size());
+  }
+  ring.nof_committed.fetch_add(1, std::memory_order_relaxed);
+  record->size.store(static_cast<uint32_t>(record_size),
+                     std::memory_order_release);
+  WakeConsumer(ring.header);
+  return true;
+}
+
+bool PopRecord(SharedListenRecordRing &ring, ListenTextMessage &msg) {
+  auto *buffer = ring.Buffer();
+  for (;;) {
+    const uint64_t head = ring.head.load(std::memory_order_relaxed);
+    const uint64_t offset = head & ring.mask;
+    auto *record = reinterpret_cast<SharedListenRecord *>(buffer + offset);
+    const uint32_t size = record->size.load(std::memory_order_acquire);
+    if (size == 0) {
+      return false;  // Queue is empty or the record isn't committed yet
+    }
+    if ((size & SharedListenRecord::kPaddingFlag) != 0) {
+      const uint32_t skip = size & ~SharedListenRecord::kPaddingFlag;
+      memset(buffer + offset, 0, skip);
+      ring.head.store(head + skip, std::memory_order_release);
+      continue;
+    }
+    const auto *data = buffer + offset + sizeof(SharedListenRecord);
+    msg.ns1970_ = record->ns1970;
+    msg.pre_text_.assign(reinterpret_cast<const char *>(data),
+                         record->pre_text_size);
+    msg.text_.assign(
+        reinterpret_cast<const char *>(data + record->pre_text_size),
+        record->text_size);
+    // Producers expects that free bytes are zero.
+    memset(buffer + offset, 0, size);
+    ring.nof_consumed.fetch_add(1, std::memory_order_relaxed);
+    ring.head.store(head + size, std::memory_order_release);
+    return true;
+  }
+}
+
+size_t QueueSize(SharedQueueHeader &queue) {
+  switch (queue.format) {
+    case SharedQueueFormat::RingQueue: {
+      const auto &ring = ToRing(queue);
+      const uint64_t head = ring.head.load();
+      const uint64_t tail = ring.tail.load();
+      return tail > head ? static_cast<size_t>(tail - head) : 0;
+    }
+
+    case SharedQueueFormat::RecordQueue: {
+      const auto &ring = ToRecordRing(queue);
+      const uint64_t consumed = ring.nof_consumed.load();
+      const uint64_t committed = ring.nof_committed.load();
+      return committed > consumed ? static_cast<size_t>(committed - consumed)
+                                  : 0;
+    }
+
+    case SharedQueueFormat::MutexQueue:
+    default:
+      break;
+  }
+  return ToMutexQueue(queue).nof_messages;
+}
+
+}  // namespace
+
 namespace util::log::detail {
 
-MessageQueue::MessageQueue(bool master, const std::string &shared_mem_name)
-    : master_(master), name_(shared_mem_name) {
+MessageQueue::MessageQueue(bool master, const std::string &shared_mem_name,
+                           bool persistent)
+    : master_(master), persistent_(!master && persistent),
+      name_(shared_mem_name) {
   try {
     if (master_) {
-      shared_memory_object::remove(shared_mem_name.c_str());
-      shared_mem_ = std::make_unique<shared_memory_object>(
-          create_only, shared_mem_name.c_str(), read_write);
-      shared_mem_->truncate(sizeof(SharedListenQueue));
-      region_ = std::make_unique<mapped_region>(*shared_mem_, read_write);
-      queue_ = new(region_->get_address()) SharedListenQueue;
-      queue_->active = false;
+      CreateMaster(SharedQueueFormat::MutexQueue, 256);
     } else {
       active_ = false;
       CheckQueue();
@@ -37,13 +266,28 @@ MessageQueue::MessageQueue(bool master, const std::string &shared_mem_name)
   }
 }
 
+MessageQueue::MessageQueue(const std::string &shared_mem_name,
+                           SharedQueueFormat format, size_t capacity)
+    : master_(true), name_(shared_mem_name) {
+  try {
+    CreateMaster(format, capacity);
+  } catch (const std::exception &error) {
+    queue_ = nullptr;
+    region_.reset();
+    shared_mem_.reset();
+  }
+}
+
 MessageQueue::~MessageQueue() {
   task_stop_ = true;
   if (queue_ != nullptr) {
     // Just in case any client is holding the area, the remove will fail
+    queue_->base.active = false;
+    queue_->base.log_level = 0;
     queue_->active = false;
     queue_->log_level = 0;
-    queue_->message_semaphore
+    queue_->generation = 0;  // Tells persistent clients that the master closed
+    queue_->base.message_semaphore
         .post();  // Generate a fake message to wake-up GetMessage() waits
   }
   if (task_.joinable()) {
@@ -53,44 +297,155 @@ MessageQueue::~MessageQueue() {
   queue_ = nullptr;
   region_.reset();
   shared_mem_.reset();
+  {
+    std::unique_lock lock(mapped_lock_);
+    mapped_queue_ = nullptr;
+    mapped_region_.reset();
+  }
 
   if (master_) {
     shared_memory_object::remove(name_.c_str());
   }
 }
 
-void MessageQueue::Add(const SharedListenMessage &msg) {
+void MessageQueue::CreateMaster(SharedQueueFormat format, size_t capacity) {
+  shared_memory_object::remove(name_.c_str());
+  shared_mem_ = std::make_unique<shared_memory_object>(
+      create_only, name_.c_str(), read_write);
+  switch (format) {
+    case SharedQueueFormat::RingQueue: {
+      shared_mem_->truncate(
+          static_cast<offset_t>(SharedListenRing::MemorySize(capacity)));
+      region_ = std::make_unique<mapped_region>(*shared_mem_, read_write);
+      auto *ring = new (region_->get_address()) SharedListenRing(capacity);
+      queue_ = &ring->header;
+      break;
+    }
+
+    case SharedQueueFormat::RecordQueue: {
+      shared_mem_->truncate(
+          static_cast<offset_t>(SharedListenRecordRing::MemorySize(capacity)));
+      region_ = std::make_unique<mapped_region>(*shared_mem_, read_write);
+      auto *ring =
+          new (region_->get_address()) SharedListenRecordRing(capacity);
+      queue_ = &ring->header;
+      break;
+    }
+
+    case SharedQueueFormat::MutexQueue:
+    default: {
+      format = SharedQueueFormat::MutexQueue;
+      shared_mem_->truncate(sizeof(SharedQueueHeader));
+      region_ = std::make_unique<mapped_region>(*shared_mem_, read_write);
+      queue_ = new (region_->get_address()) SharedQueueHeader;
+      break;
+    }
+  }
+  format_ = format;
+  queue_->base.active = false;
+  queue_->active = false;
+  // Clients with a persistent mapping use the generation to detect a
+  // restarted master.
+  queue_->generation = time::TimeStampToNs();
+}
+
+template <typename Func>
+bool MessageQueue::WithQueue(Func &&func) {
+  if (persistent_) {
+    std::shared_lock map_lock(mapped_lock_);
+    if (mapped_queue_ != nullptr) {
+      return func(mapped_queue_->base, mapped_queue_);
+    }
+  }
   try {
-    bool add = false;
-    do {
-      shared_memory_object shared_mem(open_only, name_.c_str(), read_write);
-      mapped_region region(shared_mem, read_write);
-      auto *queue = static_cast<SharedListenQueue *>(region.get_address());
-      if (queue == nullptr) {
-        return;
-      }
-      auto &mem = *queue;
-      if (task_stop_) {
-        return;
+    if (task_stop_) {
+      return false;
+    }
+    shared_memory_object shared_mem(open_only, name_.c_str(), read_write);
+    mapped_region region(shared_mem, read_write);
+    auto *base = static_cast<SharedListenQueue *>(region.get_address());
+    if (base == nullptr) {
+      return false;
+    }
+    auto *queue = SharedQueueHeader::FromMemory(base, region.get_size());
+    format_ = queue != nullptr ? queue->format : SharedQueueFormat::MutexQueue;
+    return func(*base, queue);
+  } catch (const std::exception &) {
+  }
+  return false;
+}
+
+template <typename Push>
+bool MessageQueue::AddToQueue(Push &&push) {
+  try {
+    while (!task_stop_) {
+      bool full = false;
+      const bool added =
+          WithQueue([&](SharedListenQueue &base, SharedQueueHeader *queue) {
+            // An older master has no generation. A closed master has zero.
+            if (queue != nullptr && queue->generation == 0) {
+              return false;
+            }
+            full = !push(base, queue);
+            return !full;
+          });
+      if (added) {
+        return true;
       }
-      scoped_lock lock(mem.locker);
-
-      if (mem.nof_messages > 255) {
-        lock.unlock();
-        std::this_thread::sleep_for(1ms);
-        lock.lock();
-      } else {
-        auto &in_msg = mem.queue[mem.queue_in];
-        in_msg = msg;
-        ++mem.queue_in;
-        ++mem.nof_messages;
-        mem.message_semaphore.post();
-        add = true;
+      if (!full) {
+        return false;  // No shared memory or the master is closed
       }
-    } while (!add);
-
+      // The persistent mapping is unlocked while waiting, so the client task
+      // can remap the memory if the master has been restarted.
+      std::this_thread::sleep_for(1ms);
+    }
   } catch (const std::exception &) {
   }
+  return false;
+}
+
+void MessageQueue::Add(const SharedListenMessage &msg) {
+  AddToQueue([&](SharedListenQueue &base, SharedQueueHeader *queue) {
+    const SharedQueueFormat format =
+        queue != nullptr ? queue->format : SharedQueueFormat::MutexQueue;
+    switch (format) {
+      case SharedQueueFormat::RingQueue:
+        return PushRing(ToRing(*queue), msg);
+
+      case SharedQueueFormat::RecordQueue:
+        return PushRecord(ToRecordRing(*queue), msg.ns1970,
+                          FixedText(msg.pre_text, sizeof(msg.pre_text)),
+                          FixedText(msg.text, sizeof(msg.text)));
+
+      case SharedQueueFormat::MutexQueue:
+      default:
+        break;
+    }
+    return PushMutexQueue(base, msg);
+  });
+}
+
+bool MessageQueue::AddText(uint64_t ns1970, std::string_view pre_text,
+                           std::string_view text) {
+  // Avoids mapping the memory twice when the master uses a fixed size format.
+  if (format_ != SharedQueueFormat::RecordQueue) {
+    return false;
+  }
+  bool rejected = false;
+  // The message is handled even if the master closes while waiting.
+  AddToQueue([&](SharedListenQueue &, SharedQueueHeader *queue) {
+    if (queue == nullptr || queue->format != SharedQueueFormat::RecordQueue) {
+      rejected = true;
+      return true;
+    }
+    auto &ring = ToRecordRing(*queue);
+    if (RecordSize(pre_text, text) > ring.MaxRecordSize()) {
+      rejected = true;
+      return true;
+    }
+    return PushRecord(ring, ns1970, pre_text, text);
+  });
+  return !rejected;
 }
 
 bool MessageQueue::Get(SharedListenMessage &msg, bool block) {
@@ -98,38 +453,79 @@ bool MessageQueue::Get(SharedListenMessage &msg, bool block) {
     return false;
   }
   auto &mem = *queue_;
-  if (block) {
-    mem.message_semaphore.wait();
-    if (!task_stop_ && mem.nof_messages > 0) {
-      scoped_lock lock(mem.locker);
-      const auto &out_msg = mem.queue[mem.queue_out];
-      msg = out_msg;
-      ++mem.queue_out;
-      --mem.nof_messages;
+  switch (mem.format) {
+    case SharedQueueFormat::RingQueue: {
+      auto &ring = ToRing(mem);
+      return block ? WaitAndPop(mem, task_stop_,
+                                [&] { return PopRing(ring, msg); })
+                   : PopRing(ring, msg);
+    }
+
+    case SharedQueueFormat::RecordQueue: {
+      ListenTextMessage text;
+      if (!Get(text, block)) {
+        return false;
+      }
+      msg.ns1970 = text.ns1970_;
+      CopyFixedText(text.pre_text_, msg.pre_text, sizeof(msg.pre_text));
+      CopyFixedText(text.text_, msg.text, sizeof(msg.text));
       return true;
     }
 
+    case SharedQueueFormat::MutexQueue:
+    default:
+      break;
+  }
+
+  if (block) {
+    mem.base.message_semaphore.wait();
+    if (!task_stop_) {
+      return PopMutexQueue(ToMutexQueue(mem), msg);
+    }
   } else {
-    const bool message = mem.message_semaphore.try_wait();
-    if (message && !task_stop_ && mem.nof_messages > 0) {
-      scoped_lock lock(mem.locker);
-      const auto &out_msg = mem.queue[mem.queue_out];
-      msg = out_msg;
-      ++mem.queue_out;
-      --mem.nof_messages;
-      return true;
+    const bool message = mem.base.message_semaphore.try_wait();
+    if (message && !task_stop_) {
+      return PopMutexQueue(ToMutexQueue(mem), msg);
     }
   }
   return false;
 }
 
+bool MessageQueue::Get(ListenTextMessage &msg, bool block) {
+  if (task_stop_ || !master_ || queue_ == nullptr) {
+    return false;
+  }
+  auto &mem = *queue_;
+  if (mem.format == SharedQueueFormat::RecordQueue) {
+    auto &ring = ToRecordRing(mem);
+    return block ? WaitAndPop(mem, task_stop_,
+                              [&] { return PopRecord(ring, msg); })
+                 : PopRecord(ring, msg);
+  }
+  SharedListenMessage fixed;
+  if (!Get(fixed, block)) {
+    return false;
+  }
+  msg.ns1970_ = fixed.ns1970;
+  msg.pre_text_ = FixedText(fixed.pre_text, sizeof(fixed.pre_text));
+  msg.text_ = FixedText(fixed.text, sizeof(fixed.text));
+  return true;
+}
+
 size_t MessageQueue::NofMessages() const {
+  if (persistent_) {
+    std::shared_lock lock(mapped_lock_);
+    if (mapped_queue_ != nullptr) {
+      return QueueSize(*mapped_queue_);
+    }
+  }
   try {
     shared_memory_object shared_mem(open_only, name_.c_str(), read_write);
     mapped_region region(shared_mem, read_write);
-    auto *queue = static_cast<SharedListenQueue *>(region.get_address());
-    if (queue != nullptr) {
-      return queue->nof_messages;
+    auto *base = static_cast<SharedListenQueue *>(region.get_address());
+    if (base != nullptr) {
+      auto *queue = SharedQueueHeader::FromMemory(base, region.get_size());
+      return queue != nullptr ? QueueSize(*queue) : base->nof_messages.load();
     }
   } catch (const std::exception &) {
   }
@@ -153,10 +549,14 @@ void MessageQueue::Stop() {
     try {
       shared_memory_object shared_mem(open_only, name_.c_str(), read_write);
       mapped_region region(shared_mem, read_write);
-      auto *queue = static_cast<SharedListenQueue *>(region.get_address());
-      if (queue != nullptr) {
-        queue->active = false;
-        queue->message_semaphore.post();
+      auto *base = static_cast<SharedListenQueue *>(region.get_address());
+      if (base != nullptr) {
+        auto *queue = SharedQueueHeader::FromMemory(base, region.get_size());
+        if (queue != nullptr) {
+          queue->active = false;
+        }
+        base->active = false;
+        base->message_semaphore.post();
       }
     } catch (const std::exception &) {
     }
@@ -167,6 +567,10 @@ void MessageQueue::SetActive(bool active) {
   active_ = active;
   if (queue_ != nullptr) {
     queue_->active = active;
+    // Older clients only see the mutex queue.
+    if (queue_->format == SharedQueueFormat::MutexQueue) {
+      queue_->base.active = active;
+    }
   }
 }
 
@@ -174,25 +578,79 @@ void MessageQueue::SetLogLevel(uint8_t log_level) {
   log_level_ = log_level;
   if (queue_ != nullptr) {
     queue_->log_level = log_level;
+    queue_->base.log_level = log_level;
   }
 }
 
 void MessageQueue::CheckQueue() {
+  if (persistent_) {
+    CheckMapping();
+    return;
+  }
   try {
     shared_memory_object shared_mem(open_only, name_.c_str(), read_write);
     mapped_region region(shared_mem, read_write);
-    const auto *queue =
-        static_cast<SharedListenQueue *>(region.get_address());
-    if (queue == nullptr) {
-      active_ = false;
-      log_level_ = 0;
-    } else {
+    auto *base = static_cast<SharedListenQueue *>(region.get_address());
+    const auto *queue = SharedQueueHeader::FromMemory(base, region.get_size());
+    if (queue != nullptr) {
       active_ = queue->active.load();
       log_level_ = queue->log_level.load();
+      format_ = queue->format;
+    } else if (base != nullptr) {
+      active_ = base->active.load();
+      log_level_ = base->log_level.load();
+      format_ = SharedQueueFormat::MutexQueue;
+    } else {
+      active_ = false;
+      log_level_ = 0;
+    }
+  } catch (const std::exception &) {
+    active_ = false;
+    log_level_ = 0;
+  }
+}
+
+void MessageQueue::CheckMapping() {
+  try {
+    shared_memory_object shared_mem(open_only, name_.c_str(), read_write);
+    mapped_region region(shared_mem, read_write);
+    auto *base = static_cast<SharedListenQueue *>(region.get_address());
+    if (base == nullptr) {
+      throw std::runtime_error("Shared memory is not mapped");
+    }
+    auto *queue = SharedQueueHeader::FromMemory(base, region.get_size());
+    if (queue == nullptr) {
+      // An older master without a generation. The memory is opened on each
+      // call instead, so a restarted master is found.
+      active_ = base->active.load();
+      log_level_ = base->log_level.load();
+      format_ = SharedQueueFormat::MutexQueue;
+      std::unique_lock lock(mapped_lock_);
+      mapped_queue_ = nullptr;
+      mapped_region_.reset();
+      generation_ = 0;
+      return;
+    }
+    const uint64_t generation = queue->generation.load();
+    active_ = queue->active.load();
+    log_level_ = queue->log_level.load();
+
+    if (mapped_queue_ == nullptr || generation != generation_) {
+      // First call or the master has been restarted. Keep this mapping.
+      std::unique_lock lock(mapped_lock_);
+      mapped_region_ = std::make_unique<mapped_region>(std::move(region));
+      mapped_queue_ =
+          static_cast<SharedQueueHeader *>(mapped_region_->get_address());
+      generation_ = generation;
+      format_ = mapped_queue_->format;
     }
   } catch (const std::exception &) {
     active_ = false;
     log_level_ = 0;
+    std::unique_lock lock(mapped_lock_);
+    mapped_queue_ = nullptr;
+    mapped_region_.reset();
+    generation_ = 0;
   }
 }
 
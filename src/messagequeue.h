@@ -9,7 +9,9 @@
 #include <boost/interprocess/shared_memory_object.hpp>
 #include <condition_variable>
 #include <memory>
+#include <shared_mutex>
 #include <string>
+#include <string_view>
 #include <thread>
 
 #include "listenmessage.h"
@@ -18,7 +20,34 @@ namespace util::log::detail {
 
 class MessageQueue {
  public:
-  MessageQueue(bool master, const std::string &shared_mem_name);
+  /** \brief Creates a master (server) or a client (producer) queue.
+   *
+   * A client queue normally opens and maps the shared memory on every call.
+   * In persistent mode, the client maps the shared memory once and keeps it
+   * mapped. The mapping is only renewed when a restarted master is detected
+   * through the generation counter in the shared memory.
+   *
+   * The master creates the default mutex queue format. Clients detect the
+   * format from the shared memory.
+   * @param master True if this object owns the shared memory.
+   * @param shared_mem_name Name of the shared memory.
+   * @param persistent True if the client should keep the memory mapped.
+   */
+  MessageQueue(bool master, const std::string &shared_mem_name,
+               bool persistent = false);
+
+  /** \brief Creates a master queue with a selectable format.
+   *
+   * The ring formats use lock-free head/tail indexes and a capacity that is
+   * rounded up to a power of two. The ring capacity is number of messages
+   * while the record ring capacity is number of bytes (minimum 64 kB). The
+   * capacity is ignored by the mutex format.
+   * @param shared_mem_name Name of the shared memory.
+   * @param format Shared memory queue format.
+   * @param capacity Number of message slots or bytes.
+   */
+  MessageQueue(const std::string &shared_mem_name, SharedQueueFormat format,
+               size_t capacity = 256);
   virtual ~MessageQueue();
 
   MessageQueue() = delete;
@@ -29,21 +58,75 @@ class MessageQueue {
 
   [[nodiscard]] uint8_t LogLevel() const { return log_level_; }
 
+  [[nodiscard]] bool IsPersistent() const { return persistent_; }
+
+  /** \brief Returns true if the queue has been stopped.
+   *
+   * A stopped queue doesn't return any more messages and needs to be
+   * recreated.
+   * @return True if Stop() has been called.
+   */
+  [[nodiscard]] bool IsStopped() const { return task_stop_; }
+
+  /** \brief Returns the format of the shared memory.
+   *
+   * Returns the format the master created. A client returns the format
+   * of the last mapped shared memory.
+   * @return Shared memory queue format.
+   */
+  [[nodiscard]] SharedQueueFormat Format() const { return format_; }
+
   void SetActive(bool active);
   void SetLogLevel(uint8_t log_level);
 
   void Add(const SharedListenMessage &msg);
+
+  /** \brief Adds a variable length text message.
+   *
+   * Adds the text as one record if the shared memory uses the record format.
+   * The format detected by the last mapping is checked first, so nothing is
+   * mapped if the master uses a fixed size format.
+   * The function returns false if the master uses a fixed size format or if
+   * the message is larger than the maximum record size. The caller should
+   * then split the text into fixed size messages.
+   * @param ns1970 Time stamp nanoseconds since 1970.
+   * @param pre_text Pre-text string.
+   * @param text Message text.
+   * @return True if the message was handled.
+   */
+  bool AddText(uint64_t ns1970, std::string_view pre_text,
+               std::string_view text);
+
   bool Get(SharedListenMessage &msg, bool block);
+
+  /** \brief Gets the next message without any length limits.
+   *
+   * Gets the next message in any of the queue formats. Fixed size messages
+   * are converted.
+   * @param msg Destination message.
+   * @param block True if the call should wait for a message.
+   * @return True if a message was returned.
+   */
+  bool Get(ListenTextMessage &msg, bool block);
   [[nodiscard]] size_t NofMessages() const;
   void Stop();
 
  private:
   std::unique_ptr<boost::interprocess::shared_memory_object> shared_mem_;
   std::unique_ptr<boost::interprocess::mapped_region> region_;
-  SharedListenQueue *queue_ = nullptr;
+  SharedQueueHeader *queue_ = nullptr;
   bool master_ = false;
+  bool persistent_ = false;
+  std::atomic<SharedQueueFormat> format_ = SharedQueueFormat::MutexQueue;
   std::string name_;
 
+  /// Persistent client mapping. Add() takes a shared lock while the client
+  /// task takes an exclusive lock when it remaps the memory.
+  mutable std::shared_mutex mapped_lock_;
+  std::unique_ptr<boost::interprocess::mapped_region> mapped_region_;
+  SharedQueueHeader *mapped_queue_ = nullptr;
+  uint64_t generation_ = 0;
+
   std::thread task_;
   std::atomic<bool> task_stop_ = false;
   std::condition_variable task_event_;
@@ -52,6 +135,7 @@ class MessageQueue {
   std::atomic<bool> active_ = false;
   std::atomic<uint8_t> log_level_ = 0;
 
+  void CreateMaster(SharedQueueFormat format, size_t capacity);
   void ClientTask();
 
   /** \brief function that the thread cyclic calls.
@@ -61,6 +145,40 @@ class MessageQueue {
  * is started to speed up the connection.
  */
   void CheckQueue();
+
+  /** \brief Checks and renews the persistent client mapping.
+   *
+   * Opens the shared memory by name and compares its generation with the
+   * mapped generation. The memory is only remapped if the master has been
+   * restarted.
+   */
+  void CheckMapping();
+
+  /** \brief Calls the function with the persistent or an opened queue.
+   *
+   * The header pointer is null if an older master created the shared
+   * memory. Such a master only supports the mutex queue.
+   * @tparam Func Function object that takes the mutex queue reference and
+   * the header pointer.
+   * @param func Function that returns true on success.
+   * @return False if no shared memory exist or the function failed.
+   */
+  template <typename Func>
+  bool WithQueue(Func &&func);
+
+  /** \brief Adds a message to the queue of any format.
+   *
+   * Each push attempt maps or locks the queue by itself. If the queue is
+   * full, the function waits without holding the persistent mapping, so a
+   * restarted master is detected. The wait ends if the queue is stopped,
+   * the shared memory is removed or the master is closed.
+   * @tparam Push Function object that takes the mutex queue reference and
+   * the header pointer, and returns false if the queue is full.
+   * @param push Function that adds the message.
+   * @return True if the message was added.
+   */
+  template <typename Push>
+  bool AddToQueue(Push &&push);
 };
 
 }  // namespace util::log::detail
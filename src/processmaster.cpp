@@ -20,7 +20,17 @@ using namespace util::log;
 namespace util::supervise {
 
 ProcessMaster::ProcessMaster()
-: io_context_(),
+: own_context_(std::make_unique<io_context>()),
+  io_context_(*own_context_),
+  strand_(make_strand(io_context_)),
+  poll_timer_(io_context_) {
+
+}
+
+ProcessMaster::ProcessMaster(std::shared_ptr<IoContextPool> pool)
+: pool_(std::move(pool)),
+  io_context_(pool_->Context()),
+  strand_(make_strand(io_context_)),
   poll_timer_(io_context_) {
 
 }
@@ -31,13 +41,17 @@ ProcessMaster::~ProcessMaster() {
 
 void ProcessMaster::Start() {
   Stop();
-  if (io_context_.stopped()) {
+  if (own_context_ && io_context_.stopped()) {
     io_context_.restart();
   }
   stop_thread_ = false;
   ISuperviseMaster::Start();
-  DoPollTimer();
-  supervise_thread_ = std::thread(&ProcessMaster::SuperviseThread, this);
+  if (own_context_) {
+    DoPollTimer();
+    supervise_thread_ = std::thread(&ProcessMaster::SuperviseThread, this);
+  } else {
+    post(strand_, [this, token = handlers_.Acquire()] { DoPollTimer(); });
+  }
 
 }
 
@@ -45,6 +59,13 @@ void ProcessMaster::Stop() {
   stop_thread_ = true; // Actually supresses log messages
   ISuperviseMaster::Stop(); // Stops all processes
 
+  if (!own_context_) {
+    // The context is shared and cannot be stopped
+    util::RunOnStrand(io_context_, strand_,
+                              [&] { poll_timer_.cancel(); });
+    handlers_.Wait();
+    return;
+  }
   if (!io_context_.stopped()) {
     io_context_.stop();
   }
@@ -70,7 +91,8 @@ void ProcessMaster::SuperviseThread() {
 
 void ProcessMaster::DoPollTimer() {
   poll_timer_.expires_after(500ms);
-  poll_timer_.async_wait([&] (const error_code& ec) -> void {
+  poll_timer_.async_wait(bind_executor(strand_,
+      [this, token = handlers_.Acquire()] (const error_code& ec) -> void {
     if (stop_thread_) {
       return;
     }
@@ -84,6 +106,6 @@ void ProcessMaster::DoPollTimer() {
       application->Poll();
     }
     DoPollTimer();
-  });
+  }));
 }
 } // util::supervise
\ No newline at end of file
@@ -12,6 +12,8 @@
 
 #include <boost/asio.hpp>
 
+#include "handlercount.h"
+#include "util/iocontextpool.h"
 #include "util/isupervisemaster.h"
 
 namespace util::supervise {
@@ -23,6 +25,14 @@ class ProcessMaster : public ISuperviseMaster {
   friend class ProcessApplication;
 public:
   ProcessMaster();
+
+  /** \brief Creates a master that polls on a shared context.
+   *
+   * The applications are polled by the pool threads instead of an own
+   * supervise thread.
+   * @param pool Shared context pool.
+   */
+  explicit ProcessMaster(std::shared_ptr<IoContextPool> pool);
   ~ProcessMaster() override;
   void Start() override;
   void Stop() override;
@@ -31,7 +41,11 @@ private:
   std::thread supervise_thread_;
   std::atomic<bool> stop_thread_ = false;;
 
-  boost::asio::io_context io_context_;
+  util::HandlerCount handlers_;
+  std::shared_ptr<IoContextPool> pool_;  ///< Shared context pool or null.
+  std::unique_ptr<boost::asio::io_context> own_context_;
+  boost::asio::io_context& io_context_;
+  boost::asio::strand<boost::asio::io_context::executor_type> strand_;
   boost::asio::steady_timer poll_timer_;
 
   void SuperviseThread();
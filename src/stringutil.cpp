@@ -182,4 +182,33 @@ std::string FloatToString(float value) {
 std::string DoubleToString(double value) {
   return boost::lexical_cast<std::string>(value);
 }
+
+void WriteFormat(std::ostream &stream, std::string_view format,
+                 const FormatArg *arg_list, size_t nof_args) {
+  size_t arg_index = 0;
+  for (size_t index = 0; index < format.size(); ++index) {
+    const char in_char = format[index];
+    const bool next_same =
+        index + 1 < format.size() && format[index + 1] == in_char;
+    if ((in_char == '{' || in_char == '}') && next_same) {
+      stream << in_char;  // '{{' or '}}'
+      ++index;
+    } else if (in_char == '{') {
+      const auto end = format.find('}', index);
+      if (end == std::string_view::npos) {
+        stream << format.substr(index);
+        break;
+      }
+      if (arg_index < nof_args && arg_list != nullptr) {
+        const auto &arg = arg_list[arg_index];
+        arg.write(stream, arg.value);
+      }
+      ++arg_index;
+      index = end;
+    } else {
+      stream << in_char;
+    }
+  }
+}
+
 }  // namespace util::string
@@ -23,6 +23,18 @@ Syslog::Syslog(const std::string &remote_host, uint16_t port)
   EnableSeverityLevel(LogSeverity::kDebug, false);
   StartWorkerThread();
 }
+
+Syslog::Syslog(const std::string &remote_host, uint16_t port,
+               std::shared_ptr<IoContextPool> pool)
+    : remote_host_(remote_host),
+      port_(port),
+      pool_(std::move(pool)),
+      strand_(std::make_unique<strand<io_context::executor_type>>(
+          make_strand(pool_->Context()))) {
+  EnableSeverityLevel(LogSeverity::kTrace, false);
+  EnableSeverityLevel(LogSeverity::kDebug, false);
+}
+
 Syslog::~Syslog() { Stop(); }
 void Syslog::StartWorkerThread() {
   stop_thread_ = false;
@@ -31,9 +43,6 @@ void Syslog::StartWorkerThread() {
 
 void Syslog::WorkerThread() {
   io_context context;
-  ip::udp::resolver resolver(context);
-  bool in_service = true;  // Suppresses event and alarms
-
   // We have the messages in a queue, so there is no hurry to transfer them
   // to the syslog server.
   do {
@@ -44,37 +53,53 @@ void Syslog::WorkerThread() {
 
     while (!message_list_.empty()) {
       // Connect to the syslog server
-      LogMessage m = message_list_.front();
+      const auto m = std::move(message_list_.front());
       message_list_.pop();
       lock.unlock();
+      SendMessage(context, *m);
+      lock.lock();
+    }
+  } while (!stop_thread_);
+}
 
-      SyslogMessage msg(m, ShowLocation());
-      const auto data = msg.GenerateMessage();
-      const auto buffer = boost::asio::buffer(data);
+void Syslog::SendQueue() {
+  // Reset the flag before the queue is emptied, so any message added while
+  // sending posts a new call.
+  send_posted_ = false;
+  std::unique_lock<std::mutex> lock(locker_);
+  while (!message_list_.empty()) {
+    const auto m = std::move(message_list_.front());
+    message_list_.pop();
+    lock.unlock();
+    SendMessage(pool_->Context(), *m);
+    lock.lock();
+  }
+}
 
-      try {
-        auto end_points = resolver.resolve(ip::udp::v4(), remote_host_,
-                                           std::to_string(port_));
-        ip::udp::socket socket(context);
-        socket.open(ip::udp::v4());
-        const auto points = end_points.size();
-        socket.send_to(buffer, *end_points.begin());
-        if (!in_service) {
-          LOG_INFO() << "Syslog client is in service.";
-        }
-        in_service = true;
-      } catch (const std::exception &err) {
-        // If something wrong clear the message buffer
-        if (in_service) {
-          LOG_ERROR() << "Syslog is out-of-service. Error: " << err.what()
-                      << ", Remote: " << remote_host_ << ":" << port_;
-        }
-        in_service = false;
-      }
+void Syslog::SendMessage(io_context &context, const LogMessage &message) {
+  SyslogMessage msg(message, ShowLocation());
+  const auto data = msg.GenerateMessage();
+  const auto buffer = boost::asio::buffer(data);
 
-      lock.lock();
+  try {
+    ip::udp::resolver resolver(context);
+    auto end_points =
+        resolver.resolve(ip::udp::v4(), remote_host_, std::to_string(port_));
+    ip::udp::socket socket(context);
+    socket.open(ip::udp::v4());
+    socket.send_to(buffer, *end_points.begin());
+    if (!in_service_) {
+      LOG_INFO() << "Syslog client is in service.";
     }
-  } while (!stop_thread_);
+    in_service_ = true;
+  } catch (const std::exception &err) {
+    // If something wrong clear the message buffer
+    if (in_service_) {
+      LOG_ERROR() << "Syslog is out-of-service. Error: " << err.what()
+                  << ", Remote: " << remote_host_ << ":" << port_;
+    }
+    in_service_ = false;
+  }
 }
 
 /**
@@ -86,6 +111,14 @@ void Syslog::AddLogMessage(const LogMessage &message) {
   if (stop_thread_ || !IsSeverityLevelEnabled(message.severity)) {
     return;
   }
+  AddSharedMessage(std::make_shared<const LogMessage>(message));
+}
+
+void Syslog::AddSharedMessage(
+    const std::shared_ptr<const LogMessage> &message) {
+  if (stop_thread_ || !message || !IsSeverityLevelEnabled(message->severity)) {
+    return;
+  }
   {
     std::lock_guard<std::mutex> lock(locker_);
     if (stop_thread_) {
@@ -93,7 +126,11 @@ void Syslog::AddLogMessage(const LogMessage &message) {
     }
     message_list_.push(message);
   }
-  condition_.notify_one();
+  if (!strand_) {
+    condition_.notify_one();
+  } else if (!send_posted_.exchange(true)) {
+    post(*strand_, [this, token = handlers_.Acquire()] { SendQueue(); });
+  }
 }
 
 /**
@@ -102,6 +139,10 @@ void Syslog::AddLogMessage(const LogMessage &message) {
  */
 void Syslog::Stop() {
   stop_thread_ = true;
+  if (strand_) {
+    // The posted handler sends the queued messages
+    handlers_.Wait();
+  }
   if (worker_thread_.joinable()) {
     condition_.notify_one();
     worker_thread_.join();
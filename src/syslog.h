@@ -4,12 +4,17 @@
  */
 
 #pragma once
+#include <atomic>
+#include <boost/asio.hpp>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <thread>
 
+#include "handlercount.h"
 #include "util/ilogger.h"
+#include "util/iocontextpool.h"
 #include "util/logmessage.h"
 namespace util::log::detail {
 
@@ -17,23 +22,49 @@ class Syslog : public ILogger {
  public:
   Syslog() = default;
   Syslog(const std::string& remote_host, uint16_t port);
+
+  /** \brief Creates a logger that sends the messages on a shared context.
+   *
+   * No worker thread is created. The messages are sent by a handler on the
+   * pool threads.
+   * @param remote_host Syslog server host name.
+   * @param port Syslog server port.
+   * @param pool Shared context pool.
+   */
+  Syslog(const std::string& remote_host, uint16_t port,
+         std::shared_ptr<IoContextPool> pool);
   ~Syslog() override;
 
   void AddLogMessage(
       const LogMessage& message) override;  ///< Handle a log message
+  void AddSharedMessage(const std::shared_ptr<const LogMessage>& message)
+      override;  ///< Queues the shared message without a copy.
   void Stop() override;                     ///< Stops the working thread.
  private:
   std::mutex locker_;
-  std::queue<LogMessage> message_list_;
+  std::queue<std::shared_ptr<const LogMessage>> message_list_;
   std::thread worker_thread_;
   std::atomic<bool> stop_thread_ = false;
   std::condition_variable condition_;
 
   std::string remote_host_ = "localhost";
   uint16_t port_ = 514;
+  bool in_service_ = true;  ///< Suppresses event and alarms
+
+  util::HandlerCount handlers_;
+  std::shared_ptr<IoContextPool> pool_;  ///< Shared context pool or null.
+  /// Sends the messages on the pool context. Null if using a worker thread.
+  std::unique_ptr<boost::asio::strand<boost::asio::io_context::executor_type>>
+      strand_;
+  std::atomic<bool> send_posted_ = false;
 
   void StartWorkerThread();
   void WorkerThread();
+
+  /** \brief Sends the queued messages. Called on the pool strand. */
+  void SendQueue();
+  void SendMessage(boost::asio::io_context& context,
+                   const LogMessage& message);
 };
 
 }  // namespace util::log::detail
\ No newline at end of file
@@ -17,8 +17,12 @@ namespace util::syslog {
 
 SyslogConnection::SyslogConnection(
     ISyslogServer& server,
-    std::unique_ptr<boost::asio::ip::tcp::socket>& socket)
-    : server_(server), socket_(std::move(socket)) {
+    std::unique_ptr<boost::asio::ip::tcp::socket>& socket,
+    const util::HandlerCount& handlers)
+    : server_(server),
+      handlers_(handlers),
+      socket_(std::move(socket)),
+      strand_(make_strand(socket_->get_executor())) {
   try {
     socket_base::keep_alive option(true);
     socket_->set_option(option);
@@ -44,6 +48,10 @@ SyslogConnection::~SyslogConnection() {
 
 bool SyslogConnection::Cleanup() { return !socket_ || !socket_->is_open(); }
 
+void SyslogConnection::Shutdown() {
+  post(strand_, [this, token = handlers_.Acquire()] { Close(); });
+}
+
 void SyslogConnection::Close() {
   if (!socket_ || !socket_->is_open()) {
     return;
@@ -62,7 +70,8 @@ void SyslogConnection::DoReadLength() {  // NOLINT
     return;
   }
   async_read(*socket_, buffer(length_buffer_.data(), 1),
-             [&](const error_code& error, std::size_t bytes) {  // NOLINT
+             bind_executor(strand_, [this, token = handlers_.Acquire()](
+                 const error_code& error, std::size_t bytes) {  // NOLINT
                if (error && error == error::eof) {
                  Close();  // Connection closed by remote client
                } else if (error) {
@@ -81,7 +90,7 @@ void SyslogConnection::DoReadLength() {  // NOLINT
                    DoReadLength();
                  }
                }
-             });
+             }));
 }
 
 void SyslogConnection::DoReadMessage() {  // NOLINT
@@ -91,7 +100,8 @@ void SyslogConnection::DoReadMessage() {  // NOLINT
   msg_buffer_.clear();
   msg_buffer_.resize(length_, '\0');
   async_read(*socket_, buffer(msg_buffer_.data(), length_),
-             [&](const error_code& error, std::size_t bytes) {  // NOLINT
+             bind_executor(strand_, [this, token = handlers_.Acquire()](
+                 const error_code& error, std::size_t bytes) {  // NOLINT
                if (error && error == error::eof) {
                  Close();  // Connection closed by remote client
                } else if (error) {
@@ -109,7 +119,7 @@ void SyslogConnection::DoReadMessage() {  // NOLINT
                  length_ = 0;
                  DoReadLength();
                }
-             });
+             }));
 }
 
 void SyslogConnection::SendSyslogMessage(const SyslogMessage& message) {
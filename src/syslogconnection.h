@@ -9,14 +9,23 @@
 
 #include <boost/asio.hpp>
 
+#include "handlercount.h"
+
 namespace util::syslog {
 
 class ISyslogServer;
 
+/** \brief Connection to a remote syslog client.
+ *
+ * The handlers run on the connection strand and hold a token from the
+ * server, so a server on a shared context can wait for them when it is
+ * stopped.
+ */
 class SyslogConnection {
  public:
   SyslogConnection(ISyslogServer& server,
-                   std::unique_ptr<boost::asio::ip::tcp::socket>& socket);
+                   std::unique_ptr<boost::asio::ip::tcp::socket>& socket,
+                   const util::HandlerCount& handlers);
   ~SyslogConnection();
 
   SyslogConnection() = delete;
@@ -27,9 +36,14 @@ class SyslogConnection {
 
   void SendSyslogMessage(const SyslogMessage& message);
 
+  /** \brief Closes the socket on the connection strand. */
+  void Shutdown();
+
  private:
   ISyslogServer& server_;
+  const util::HandlerCount& handlers_;
   std::unique_ptr<boost::asio::ip::tcp::socket> socket_;
+  boost::asio::strand<boost::asio::any_io_executor> strand_;
   size_t length_ = 0;
   std::string length_buffer_ = " ";
   std::string msg_buffer_;
@@ -21,7 +21,23 @@ using namespace util::string;
 namespace util::syslog {
 
 SyslogPublisher::SyslogPublisher()
-    : ISyslogServer(), cleanup_timer_(context_), check_list_timer_(context_) {
+    : ISyslogServer(),
+      own_context_(std::make_unique<io_context>()),
+      context_(*own_context_),
+      strand_(make_strand(context_)),
+      cleanup_timer_(context_),
+      check_list_timer_(context_) {
+  type_ = SyslogServerType::TcpPublisher;
+  Address("127.0.0.1");  // Change default to enable only localhost
+}
+
+SyslogPublisher::SyslogPublisher(std::shared_ptr<IoContextPool> pool)
+    : ISyslogServer(),
+      pool_(std::move(pool)),
+      context_(pool_->Context()),
+      strand_(make_strand(context_)),
+      cleanup_timer_(context_),
+      check_list_timer_(context_) {
   type_ = SyslogServerType::TcpPublisher;
   Address("127.0.0.1");  // Change default to enable only localhost
 }
@@ -49,7 +65,13 @@ void SyslogPublisher::Start() {
     DoAccept();              // Accept all incoming connections
     DoCleanupConnections();  // Cleanup unused connections
     DoCheckMessageList();
-    server_thread_ = std::thread(&SyslogPublisher::ServerThread, this);
+    if (own_context_) {
+      if (context_.stopped()) {
+        context_.restart();
+      }
+      server_thread_ = std::thread(&SyslogPublisher::ServerThread, this);
+    }
+    started_ = true;
     operable_ = true;
   } catch (const std::exception& err) {
     LOG_ERROR() << "Failed to start receiver thread. Name: " << Name()
@@ -59,15 +81,33 @@ void SyslogPublisher::Start() {
 }
 
 void SyslogPublisher::Stop() {
-  if (context_.stopped()) {
+  if (context_.stopped() || !started_.exchange(false)) {
     return;
   }
   try {
+    if (!own_context_) {
+      // The context is shared and cannot be stopped
+      util::RunOnStrand(context_, strand_, [&] {
+        boost::system::error_code dummy;
+        if (acceptor_) {
+          acceptor_->close(dummy);
+        }
+        cleanup_timer_.cancel();
+        check_list_timer_.cancel();
+        std::lock_guard lock(connection_list_lock_);
+        for (auto& connection : connection_list_) {
+          if (connection) {
+            connection->Shutdown();
+          }
+        }
+      });
+      handlers_.Wait();
+    }
     {
       std::lock_guard lock(connection_list_lock_);
       connection_list_.clear();
     }
-    if (!context_.stopped()) {
+    if (own_context_ && !context_.stopped()) {
       context_.stop();
     }
     if (server_thread_.joinable()) {
@@ -93,13 +133,18 @@ void SyslogPublisher::ServerThread() {
 void SyslogPublisher::DoAccept() {
   socket_ = std::make_unique<ip::tcp::socket>(context_);
   acceptor_->async_accept(
-      *socket_, [&](const boost::system::error_code& error) {
-        if (error) {
+      *socket_,
+      bind_executor(strand_, [this, token = handlers_.Acquire()](
+                                 const boost::system::error_code& error) {
+        if (error == error::operation_aborted) {
+          socket_.reset();
+        } else if (error) {
           socket_.reset();
           LOG_ERROR() << "Accept error. Name: " << Name()
                       << ", Error: " << error.message();
         } else {
-          auto connection = std::make_unique<SyslogConnection>(*this, socket_);
+          auto connection =
+              std::make_unique<SyslogConnection>(*this, socket_, handlers_);
           {
             std::lock_guard lock(message_list_lock_);
             for (const auto& msg : message_list_) {
@@ -114,12 +159,17 @@ void SyslogPublisher::DoAccept() {
           socket_.reset();
           DoAccept();
         }
-      });
+      }));
 }
 
 void SyslogPublisher::DoCleanupConnections() {
   cleanup_timer_.expires_after(2s);
-  cleanup_timer_.async_wait([&](const boost::system::error_code error) {
+  cleanup_timer_.async_wait(bind_executor(
+      strand_, [this, token = handlers_.Acquire()](
+                   const boost::system::error_code error) {
+    if (error == error::operation_aborted) {
+      return;
+    }
     if (error) {
       LOG_ERROR() << "Cleanup timer error. Name: " << Name()
                   << ", Error: " << error.message();
@@ -137,12 +187,17 @@ void SyslogPublisher::DoCleanupConnections() {
       }
       DoCleanupConnections();
     }
-  });
+  }));
 }
 
 void SyslogPublisher::DoCheckMessageList() {
   check_list_timer_.expires_after(60s);
-  check_list_timer_.async_wait([&](const boost::system::error_code error) {
+  check_list_timer_.async_wait(bind_executor(
+      strand_, [this, token = handlers_.Acquire()](
+                   const boost::system::error_code error) {
+    if (error == error::operation_aborted) {
+      return;
+    }
     if (error) {
       LOG_ERROR() << "Check list timer error. Name: " << Name()
                   << ", Error: " << error.message();
@@ -155,7 +210,7 @@ void SyslogPublisher::DoCheckMessageList() {
       }
       DoCheckMessageList();
     }
-  });
+  }));
 }
 
 void SyslogPublisher::AddMsg(const SyslogMessage& message) {
@@ -10,13 +10,21 @@
 #include <mutex>
 #include <thread>
 
+#include "handlercount.h"
 #include "syslogconnection.h"
+#include "util/iocontextpool.h"
 #include "util/isyslogserver.h"
 namespace util::syslog {
 
 class SyslogPublisher : public ISyslogServer {
  public:
   SyslogPublisher();
+
+  /** \brief Creates a publisher that runs on a shared context.
+   *
+   * @param pool Shared context pool.
+   */
+  explicit SyslogPublisher(std::shared_ptr<IoContextPool> pool);
   SyslogPublisher(const SyslogPublisher&) = delete;
   ~SyslogPublisher() override;
   void Start() override;
@@ -27,7 +35,12 @@ class SyslogPublisher : public ISyslogServer {
   [[nodiscard]] size_t NofConnections() const override;
 
  private:
-  boost::asio::io_context context_;
+  util::HandlerCount handlers_;
+  std::shared_ptr<IoContextPool> pool_;  ///< Shared context pool or null.
+  std::unique_ptr<boost::asio::io_context> own_context_;
+  boost::asio::io_context& context_;
+  boost::asio::strand<boost::asio::io_context::executor_type> strand_;
+  std::atomic<bool> started_ = false;  ///< Used on a shared context.
   boost::asio::steady_timer cleanup_timer_;
   boost::asio::steady_timer check_list_timer_;
   std::unique_ptr<boost::asio::ip::tcp::acceptor> acceptor_;
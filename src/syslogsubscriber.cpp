@@ -19,7 +19,20 @@ using namespace std::chrono_literals;
 namespace util::syslog {
 
 SyslogSubscriber::SyslogSubscriber()
-    : lookup_(context_),
+    : own_context_(std::make_unique<io_context>()),
+      context_(*own_context_),
+      strand_(make_strand(context_)),
+      lookup_(context_),
+      retry_timer_(context_) {
+  type_ = SyslogServerType::TcpSubscriber;
+  operable_ = false;
+}
+
+SyslogSubscriber::SyslogSubscriber(std::shared_ptr<IoContextPool> pool)
+    : pool_(std::move(pool)),
+      context_(pool_->Context()),
+      strand_(make_strand(context_)),
+      lookup_(context_),
       retry_timer_(context_) {
   type_ = SyslogServerType::TcpSubscriber;
   operable_ = false;
@@ -43,18 +56,34 @@ void SyslogSubscriber::WorkerTask() {
 void SyslogSubscriber::Start() {
   stop_subscriber_ = false;
   ISyslogServer::Start();
-  worker_thread_ = std::thread(&SyslogSubscriber::WorkerTask, this);
+  if (own_context_) {
+    if (context_.stopped()) {
+      context_.restart();
+    }
+    worker_thread_ = std::thread(&SyslogSubscriber::WorkerTask, this);
+  } else {
+    post(strand_, [this, token = handlers_.Acquire()] { DoLookup(); });
+  }
 }
 
 void SyslogSubscriber::Stop() {
   stop_subscriber_ = true;
-  Close();
-
-  if (!context_.stopped()) {
-    context_.stop();
-  }
-  if (worker_thread_.joinable()) {
-    worker_thread_.join();
+  if (own_context_) {
+    Close();
+    if (!context_.stopped()) {
+      context_.stop();
+    }
+    if (worker_thread_.joinable()) {
+      worker_thread_.join();
+    }
+  } else {
+    // The context is shared, so the pending operations are cancelled instead
+    util::RunOnStrand(context_, strand_, [&] {
+      lookup_.cancel();
+      retry_timer_.cancel();
+      Close();
+    });
+    handlers_.Wait();
   }
   ISyslogServer::Stop();
   operable_ = false;
@@ -88,7 +117,11 @@ void SyslogSubscriber::DoLookup() {
   std::string port(std::to_string(Port()));
 
   lookup_.async_resolve(ip::tcp::v4(), address, port,
-                        [&](const error_code &error, ip::tcp::resolver::results_type result) -> void {
+                        bind_executor(strand_, [this, token = handlers_.Acquire()](
+                            const error_code &error, ip::tcp::resolver::results_type result) -> void {
+                          if (stop_subscriber_) {
+                            return;
+                          }
                           if (error.failed()) {
                             LOG_TRACE() << "Lookup error. Host: " << Address() << ":" << Port()
                                         << ",Error (" << error.value() << "): " << error.message();
@@ -103,21 +136,22 @@ void SyslogSubscriber::DoLookup() {
                             endpoint_itr_ = endpoints_.begin();
                             DoConnect();
                           }
-                        });
+                        }));
 }
 
 void SyslogSubscriber::DoRetryWait() {
   operable_ = false;
   retry_timer_.expires_after(5s);
-  retry_timer_.async_wait([&](const error_code error) {
-    if (error) {
-      LOG_TRACE() << "Retry timer error. Error: " << error.message();
-      return;
-    }
-    if (!stop_subscriber_) {
-      DoLookup();
-    }
-  });
+  retry_timer_.async_wait(bind_executor(
+      strand_, [this, token = handlers_.Acquire()](const error_code error) {
+        if (error) {
+          LOG_TRACE() << "Retry timer error. Error: " << error.message();
+          return;
+        }
+        if (!stop_subscriber_) {
+          DoLookup();
+        }
+      }));
 
   Close();
 }
@@ -125,7 +159,12 @@ void SyslogSubscriber::DoRetryWait() {
 void SyslogSubscriber::DoConnect() {
   auto &end_point = *endpoint_itr_;
   ++endpoint_itr_;
-  socket_->async_connect(end_point, [&](error_code error) -> void {
+  socket_->async_connect(end_point, bind_executor(
+      strand_, [this, token = handlers_.Acquire(), &end_point](
+                   error_code error) -> void {
+    if (stop_subscriber_) {
+      return;
+    }
     if (error.failed()) {
       LOG_TRACE() << "Connect error. Host: " << end_point.host_name()
                   << ", Service/Port:" << end_point.service_name()
@@ -150,7 +189,7 @@ void SyslogSubscriber::DoConnect() {
       length_ = 0;
       DoReadLength();
     }
-  });
+  }));
 }
 
 void SyslogSubscriber::DoReadLength() {  // NOLINT
@@ -158,9 +197,12 @@ void SyslogSubscriber::DoReadLength() {  // NOLINT
     return;
   }
   async_read(*socket_, buffer(length_buffer_.data(), 1),
-             [&](const error_code &error, std::size_t bytes) {  // NOLINT
+             bind_executor(strand_, [this, token = handlers_.Acquire()](
+                 const error_code &error, std::size_t bytes) {  // NOLINT
                if (error) {
-                 DoRetryWait();
+                 if (!stop_subscriber_) {
+                   DoRetryWait();
+                 }
                } else {
                  char input = length_buffer_[0];
                  if (isdigit(input)) {
@@ -176,7 +218,7 @@ void SyslogSubscriber::DoReadLength() {  // NOLINT
                    }
                  }
                }
-             });
+             }));
 }
 
 void SyslogSubscriber::DoReadMessage() {  // NOLINT
@@ -186,11 +228,14 @@ void SyslogSubscriber::DoReadMessage() {  // NOLINT
   msg_buffer_.clear();
   msg_buffer_.resize(length_, '\0');
   async_read(*socket_, buffer(msg_buffer_.data(), length_),
-             [&](const error_code &error, std::size_t bytes) {  // NOLINT
+             bind_executor(strand_, [this, token = handlers_.Acquire()](
+                 const error_code &error, std::size_t bytes) {  // NOLINT
                if (error) {
                  LOG_TRACE()
                      << "Read message error. Error: " << error.message();
-                 DoRetryWait();
+                 if (!stop_subscriber_) {
+                   DoRetryWait();
+                 }
                } else {
                  SyslogMessage message;
                  const auto parse = message.ParseMessage(msg_buffer_);
@@ -202,7 +247,7 @@ void SyslogSubscriber::DoReadMessage() {  // NOLINT
                  length_ = 0;
                  DoReadLength();
                }
-             });
+             }));
 }
 
 }  // namespace util::syslog
\ No newline at end of file
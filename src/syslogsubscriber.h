@@ -11,6 +11,8 @@
 #include <thread>
 
 #include <boost/asio.hpp>
+#include "handlercount.h"
+#include "util/iocontextpool.h"
 #include "util/isyslogserver.h"
 
 namespace util::syslog {
@@ -19,6 +21,12 @@ class SyslogSubscriber : public ISyslogServer {
  public:
   SyslogSubscriber();
 
+  /** \brief Creates a subscriber that runs on a shared context.
+   *
+   * @param pool Shared context pool.
+   */
+  explicit SyslogSubscriber(std::shared_ptr<IoContextPool> pool);
+
   SyslogSubscriber(const SyslogSubscriber &) = delete;
 
   ~SyslogSubscriber() override;
@@ -28,7 +36,11 @@ class SyslogSubscriber : public ISyslogServer {
   void Stop() override;
 
  private:
-  boost::asio::io_context context_;
+  util::HandlerCount handlers_;
+  std::shared_ptr<IoContextPool> pool_;  ///< Shared context pool or null.
+  std::unique_ptr<boost::asio::io_context> own_context_;
+  boost::asio::io_context &context_;
+  boost::asio::strand<boost::asio::io_context::executor_type> strand_;
   boost::asio::ip::tcp::resolver lookup_;
   boost::asio::steady_timer retry_timer_;
   std::unique_ptr<boost::asio::ip::tcp::socket> socket_;
@@ -21,7 +21,22 @@ using namespace util::string;
 
 namespace util::syslog {
 
-TcpSyslogServer::TcpSyslogServer() : ISyslogServer(), cleanup_timer_(context_) {
+TcpSyslogServer::TcpSyslogServer()
+    : ISyslogServer(),
+      own_context_(std::make_unique<io_context>()),
+      context_(*own_context_),
+      strand_(make_strand(context_)),
+      cleanup_timer_(context_) {
+  type_ = SyslogServerType::TcpServer;
+  Address("127.0.0.1");  // Change default to enable only localhost
+}
+
+TcpSyslogServer::TcpSyslogServer(std::shared_ptr<IoContextPool> pool)
+    : ISyslogServer(),
+      pool_(std::move(pool)),
+      context_(pool_->Context()),
+      strand_(make_strand(context_)),
+      cleanup_timer_(context_) {
   type_ = SyslogServerType::TcpServer;
   Address("127.0.0.1");  // Change default to enable only localhost
 }
@@ -47,7 +62,12 @@ void TcpSyslogServer::Start() {
     }
     DoAccept();              // Accept all incoming connections
     DoCleanupConnections();  // Cleanup unused connections
-    server_thread_ = std::thread(&TcpSyslogServer::ServerThread, this);
+    if (own_context_) {
+      if (context_.stopped()) {
+        context_.restart();
+      }
+      server_thread_ = std::thread(&TcpSyslogServer::ServerThread, this);
+    }
     operable_ = true;
   } catch (const std::exception& err) {
     LOG_ERROR() << "Failed to start receiver thread. Name: " << Name()
@@ -58,11 +78,29 @@ void TcpSyslogServer::Start() {
 
 void TcpSyslogServer::Stop() {
   try {
-    if (!context_.stopped()) {
-      context_.stop();
-    }
-    if (server_thread_.joinable()) {
-      server_thread_.join();
+    if (own_context_) {
+      if (!context_.stopped()) {
+        context_.stop();
+      }
+      if (server_thread_.joinable()) {
+        server_thread_.join();
+      }
+    } else {
+      // The context is shared and cannot be stopped
+      util::RunOnStrand(context_, strand_, [&] {
+        boost::system::error_code dummy;
+        if (acceptor_) {
+          acceptor_->close(dummy);
+        }
+        cleanup_timer_.cancel();
+        std::lock_guard lock(connection_list_lock_);
+        for (auto& connection : connection_list_) {
+          if (connection) {
+            connection->Shutdown();
+          }
+        }
+      });
+      handlers_.Wait();
     }
     std::lock_guard lock(connection_list_lock_);
     connection_list_.clear();
@@ -84,28 +122,37 @@ void TcpSyslogServer::ServerThread() {
 }
 
 void TcpSyslogServer::DoAccept() {
-  auto connection_socket = std::make_unique<ip::tcp::socket>(context_);
+  socket_ = std::make_unique<ip::tcp::socket>(context_);
   acceptor_->async_accept(
-      *connection_socket, [&](const boost::system::error_code& error) {
-        if (error) {
-          connection_socket.reset();
+      *socket_,
+      bind_executor(strand_, [this, token = handlers_.Acquire()](
+                                 const boost::system::error_code& error) {
+        if (error == error::operation_aborted) {
+          socket_.reset();
+        } else if (error) {
+          socket_.reset();
           LOG_ERROR() << "Accept error. Name: " << Name()
                       << ", Error: " << error.message();
         } else {
           auto connection =
-              std::make_unique<SyslogConnection>(*this, connection_socket);
+              std::make_unique<SyslogConnection>(*this, socket_, handlers_);
           {
             std::lock_guard lock(connection_list_lock_);
             connection_list_.push_back(std::move(connection));
           }
           DoAccept();
         }
-      });
+      }));
 }
 
 void TcpSyslogServer::DoCleanupConnections() {
   cleanup_timer_.expires_after(2s);
-  cleanup_timer_.async_wait([&](const boost::system::error_code error) {
+  cleanup_timer_.async_wait(bind_executor(
+      strand_, [this, token = handlers_.Acquire()](
+                   const boost::system::error_code error) {
+    if (error == error::operation_aborted) {
+      return;
+    }
     if (error) {
       LOG_ERROR() << "Cleanup timer error. Name: " << Name()
                   << ", Error: " << error.message();
@@ -123,7 +170,7 @@ void TcpSyslogServer::DoCleanupConnections() {
       }
       DoCleanupConnections();
     }
-  });
+  }));
 }
 
 size_t TcpSyslogServer::NofConnections() const {
@@ -11,13 +11,21 @@
 #include <mutex>
 #include <thread>
 
+#include "handlercount.h"
 #include "syslogconnection.h"
+#include "util/iocontextpool.h"
 #include "util/isyslogserver.h"
 namespace util::syslog {
 
 class TcpSyslogServer : public ISyslogServer {
  public:
   TcpSyslogServer();
+
+  /** \brief Creates a server that runs on a shared context.
+   *
+   * @param pool Shared context pool.
+   */
+  explicit TcpSyslogServer(std::shared_ptr<IoContextPool> pool);
   TcpSyslogServer(const TcpSyslogServer&) = delete;
   ~TcpSyslogServer() override;
 
@@ -27,7 +35,11 @@ class TcpSyslogServer : public ISyslogServer {
   [[nodiscard]] size_t NofConnections() const override;
 
  private:
-  boost::asio::io_context context_;
+  util::HandlerCount handlers_;
+  std::shared_ptr<IoContextPool> pool_;  ///< Shared context pool or null.
+  std::unique_ptr<boost::asio::io_context> own_context_;
+  boost::asio::io_context& context_;
+  boost::asio::strand<boost::asio::io_context::executor_type> strand_;
   boost::asio::steady_timer cleanup_timer_;
   std::unique_ptr<boost::asio::ip::tcp::acceptor> acceptor_;
   std::unique_ptr<boost::asio::ip::tcp::socket> socket_;
@@ -4,12 +4,28 @@
  */
 #include "util/timestamp.h"
 
+#include <array>
 #include <chrono>
+#include <cstdint>
 #include <cstring>
 #include <ctime>
 #include <iomanip>
 #include <sstream>
 
+namespace {
+
+/// Date and time text of the last formatted second. One per thread.
+struct SecondText {
+  bool valid = false;
+  int64_t second = 0;  ///< Seconds since 1970.
+  size_t length = 0;   ///< Length of the date and time text.
+  std::array<char, 32> text = {};  ///< Text with room for ".ms".
+};
+
+thread_local SecondText kSecondText;
+
+}  // namespace
+
 namespace util::time {
 
 std::string GetLocalDateTime(
@@ -23,16 +39,44 @@ std::string GetLocalDateTime(
 
 std::string GetLocalTimestampWithMs(
     std::chrono::time_point<std::chrono::system_clock> timestamp) {
-  const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-      timestamp.time_since_epoch()) %
-      1000;
-  const auto timer = std::chrono::system_clock::to_time_t(timestamp);
-  const struct tm *bt = localtime(&timer);
+  std::string text;
+  AppendLocalTimestampWithMs(timestamp, text);
+  return text;
+}
 
-  std::ostringstream text;
-  text << std::put_time(bt, "%Y-%m-%d %H:%M:%S") << '.' << std::setfill('0')
-       << std::setw(3) << ms.count();
-  return text.str();
+void AppendLocalTimestampWithMs(TimeStamp timestamp, std::string &text) {
+  const auto ms_since_1970 =
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          timestamp.time_since_epoch())
+          .count();
+  auto seconds = ms_since_1970 / 1000;
+  auto ms = ms_since_1970 % 1000;
+  if (ms < 0) {
+    ms += 1000;  // Before 1970
+    --seconds;
+  }
+
+  auto &cache = kSecondText;
+  if (!cache.valid || cache.second != seconds) {
+    const auto timer = static_cast<std::time_t>(seconds);
+    struct tm bt = {};
+#ifdef _WIN32
+    localtime_s(&bt, &timer);
+#else
+    localtime_r(&timer, &bt);
+#endif
+    cache.length = std::strftime(cache.text.data(), cache.text.size() - 4,
+                                 "%Y-%m-%d %H:%M:%S", &bt);
+    cache.text[cache.length] = '.';
+    cache.second = seconds;
+    cache.valid = true;
+  }
+  // Only the milliseconds are updated
+  char *ms_text = cache.text.data() + cache.length + 1;
+  ms_text[0] = static_cast<char>('0' + ms / 100);
+  ms_text[1] = static_cast<char>('0' + (ms / 10) % 10);
+  ms_text[2] = static_cast<char>('0' + ms % 10);
+  text.append(cache.text.data(), cache.length + 4);
 }
 
 std::string GetLocalTimestampWithUs(
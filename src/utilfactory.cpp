@@ -8,8 +8,10 @@
 #include "listenclient.h"
 #include "listenconsole.h"
 #include "listenlogger.h"
+#include "listenmuxserver.h"
 #include "listenproxy.h"
 #include "listenserver.h"
+#include "logbinaryfile.h"
 #include "logconsole.h"
 #include "logfile.h"
 #include "syslog.h"
@@ -27,8 +29,18 @@ using namespace util::string;
 
 namespace util {
 
+std::shared_ptr<IoContextPool> UtilFactory::CreateIoContextPool(
+    size_t nof_threads) {
+  return std::make_shared<IoContextPool>(nof_threads);
+}
+
 std::unique_ptr<ISyslogServer> UtilFactory::CreateSyslogServer(
     SyslogServerType type) {
+  return CreateSyslogServer(type, {});
+}
+
+std::unique_ptr<ISyslogServer> UtilFactory::CreateSyslogServer(
+    SyslogServerType type, const std::shared_ptr<IoContextPool> &pool) {
   std::unique_ptr<ISyslogServer> server;
 
   switch (type) {
@@ -38,17 +50,20 @@ std::unique_ptr<ISyslogServer> UtilFactory::CreateSyslogServer(
       break;
     }
     case SyslogServerType::TcpServer: {
-      auto tcp_server = std::make_unique<TcpSyslogServer>();
+      auto tcp_server = pool ? std::make_unique<TcpSyslogServer>(pool)
+                             : std::make_unique<TcpSyslogServer>();
       server = std::move(tcp_server);
       break;
     }
     case SyslogServerType::TcpPublisher: {
-      auto tcp_publisher = std::make_unique<SyslogPublisher>();
+      auto tcp_publisher = pool ? std::make_unique<SyslogPublisher>(pool)
+                                : std::make_unique<SyslogPublisher>();
       server = std::move(tcp_publisher);
       break;
     }
     case SyslogServerType::TcpSubscriber: {
-      auto tcp_subscriber = std::make_unique<SyslogSubscriber>();
+      auto tcp_subscriber = pool ? std::make_unique<SyslogSubscriber>(pool)
+                                 : std::make_unique<SyslogSubscriber>();
       server = std::move(tcp_subscriber);
       break;
     }
@@ -61,6 +76,12 @@ std::unique_ptr<ISyslogServer> UtilFactory::CreateSyslogServer(
 
 std::unique_ptr<log::ILogger> UtilFactory::CreateLogger(
     log::LogType type, const std::vector<std::string> &arg_list) {
+  return CreateLogger(type, arg_list, {});
+}
+
+std::unique_ptr<log::ILogger> UtilFactory::CreateLogger(
+    log::LogType type, const std::vector<std::string> &arg_list,
+    const std::shared_ptr<IoContextPool> &pool) {
   std::unique_ptr<ILogger> logger;
 
   switch (type) {
@@ -74,6 +95,12 @@ std::unique_ptr<log::ILogger> UtilFactory::CreateLogger(
       break;
     }
 
+    case LogType::LogToBinaryFile: {
+      const auto base_name = arg_list.empty() ? "default" : arg_list[0];
+      logger = std::make_unique<detail::LogBinaryFile>(base_name);
+      break;
+    }
+
     case LogType::LogToListen:
       logger = std::make_unique<detail::ListenLogger>();
       break;
@@ -82,8 +109,13 @@ std::unique_ptr<log::ILogger> UtilFactory::CreateLogger(
       const auto remote_host = arg_list.empty() ? "localhost" : arg_list[0];
       const auto port =
           std::stoul(arg_list.size() < 2 ? std::string("514") : arg_list[1]);
-      logger = std::make_unique<detail::Syslog>(remote_host,
-                                                static_cast<uint16_t>(port));
+      if (pool) {
+        logger = std::make_unique<detail::Syslog>(
+            remote_host, static_cast<uint16_t>(port), pool);
+      } else {
+        logger = std::make_unique<detail::Syslog>(remote_host,
+                                                  static_cast<uint16_t>(port));
+      }
       break;
     }
 
@@ -108,6 +140,12 @@ std::unique_ptr<IListen> UtilFactory::CreateListen(
 
 std::unique_ptr<IListen> UtilFactory::CreateListen( TypeOfListen type,
     const std::string &share_name) {
+  return CreateListen(type, share_name, {});
+}
+
+std::unique_ptr<IListen> UtilFactory::CreateListen(
+    TypeOfListen type, const std::string &share_name,
+    const std::shared_ptr<IoContextPool> &pool) {
   std::unique_ptr<IListen> listen;
   switch (type) {
     case TypeOfListen::ListenProxyType:
@@ -119,13 +157,26 @@ std::unique_ptr<IListen> UtilFactory::CreateListen( TypeOfListen type,
       break;
 
     case TypeOfListen::ListenServerType:
-      listen = std::make_unique<detail::ListenServer>(share_name);
+      if (pool) {
+        listen = std::make_unique<detail::ListenServer>(pool, share_name);
+      } else {
+        listen = std::make_unique<detail::ListenServer>(share_name);
+      }
       break;
 
     case TypeOfListen::ListenConsoleType:
       listen = std::make_unique<detail::ListenConsole>(share_name);
       break;
 
+    case TypeOfListen::ListenMuxServerType:
+      // The share names are added later with AddChannel()
+      if (pool) {
+        listen = std::make_unique<detail::ListenMuxServer>(pool);
+      } else {
+        listen = std::make_unique<detail::ListenMuxServer>();
+      }
+      break;
+
     default:
       LOG_ERROR() << "Unknown listen type: " << static_cast<int>(type);
       break;
@@ -139,8 +190,24 @@ std::unique_ptr<log::IListenClient> UtilFactory::CreateListenClient(
   return temp;
 }
 
+std::unique_ptr<log::IListenClient> UtilFactory::CreateListenClient(
+    const std::string &host, uint16_t port,
+    const std::shared_ptr<IoContextPool> &pool) {
+  if (!pool) {
+    return CreateListenClient(host, port);
+  }
+  auto temp = std::make_unique<log::detail::ListenClient>(host, port, pool);
+  return temp;
+}
+
 std::unique_ptr<supervise::ISuperviseMaster> UtilFactory::CreateSuperviseMaster(
     supervise::TypeOfSuperviseMaster type) {
+  return CreateSuperviseMaster(type, {});
+}
+
+std::unique_ptr<supervise::ISuperviseMaster> UtilFactory::CreateSuperviseMaster(
+    supervise::TypeOfSuperviseMaster type,
+    const std::shared_ptr<IoContextPool> &pool) {
   std::unique_ptr<supervise::ISuperviseMaster> master;
   switch (type) {
     case supervise::TypeOfSuperviseMaster::SuperviseMasterType: {
@@ -149,7 +216,11 @@ std::unique_ptr<supervise::ISuperviseMaster> UtilFactory::CreateSuperviseMaster(
     }
 
     case supervise::TypeOfSuperviseMaster::ProcessMasterType: {
-      master = std::make_unique<supervise::ProcessMaster>();
+      if (pool) {
+        master = std::make_unique<supervise::ProcessMaster>(pool);
+      } else {
+        master = std::make_unique<supervise::ProcessMaster>();
+      }
       break;
     }
     default: {
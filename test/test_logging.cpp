@@ -6,7 +6,12 @@
 
 #include <array>
 #include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include "util/logconfig.h"
 #include "util/logging.h"
@@ -14,6 +19,7 @@
 #include "util/logtolist.h"
 
 using namespace util::log;
+using namespace std::chrono_literals;
 
 namespace {
 
@@ -103,6 +109,126 @@ TEST(Logging, LogToFileMutiThread)  // NOLINT
   log_config.DeleteLogChain();
 }
 
+TEST(Logging, LogToFileHighThroughput)  // NOLINT
+{
+  auto &log_config = LogConfig::Instance();
+  log_config.Type(LogType::LogToFile);
+  log_config.BaseName("test_batch.log");
+  log_config.SubDir("Testing/log");
+  log_config.FileHighThroughput(true);
+  log_config.FileFlushInterval(10ms);
+  log_config.FileSyncInterval(100ms);
+  log_config.CreateDefaultLogger();
+  const auto filename = log_config.GetLogFile();
+  ASSERT_FALSE(filename.empty());
+
+  for (int ii = 0; ii < 1000; ++ii) {
+    LOG_INFO() << "Batch: " << ii;
+  }
+  log_config.DeleteLogChain();  // Writes the last batch
+  log_config.FileHighThroughput(false);
+  log_config.FileFlushInterval(1000ms);
+  log_config.FileSyncInterval(0ms);
+
+  std::ifstream file(filename);
+  size_t nof_lines = 0;
+  for (std::string line; std::getline(file, line); ++nof_lines) {
+    EXPECT_NE(line.find("Batch: "), std::string::npos);
+  }
+  EXPECT_EQ(nof_lines, 1000);
+}
+
+TEST(Logging, LogToFileRotation)  // NOLINT
+{
+  auto &log_config = LogConfig::Instance();
+  log_config.Type(LogType::LogToFile);
+  log_config.BaseName("test_rotate.log");
+  log_config.SubDir("Testing/log");
+  log_config.CreateDefaultLogger();
+  const std::filesystem::path filename(log_config.GetLogFile());
+  ASSERT_FALSE(filename.empty());
+  log_config.DeleteLogChain();
+
+  // Remove any files from an earlier run.
+  for (const auto &entry :
+       std::filesystem::directory_iterator(filename.parent_path())) {
+    if (entry.path().filename().string().starts_with("test_rotate")) {
+      std::filesystem::remove(entry.path());
+    }
+  }
+
+  log_config.FileHighThroughput(true);
+  log_config.FileFlushInterval(10ms);
+  log_config.FileRotationSize(10'000);
+  log_config.FileGenerations(3);
+  log_config.FileCompressBackups(true);
+  log_config.CreateDefaultLogger();
+
+  for (int ii = 0; ii < 2000; ++ii) {
+    LOG_INFO() << "Rotate: " << ii;
+    if (ii % 100 == 0) {
+      std::this_thread::sleep_for(20ms);  // Several batches
+    }
+  }
+  log_config.DeleteLogChain();  // Waits for the last rotation
+  log_config.FileHighThroughput(false);
+  log_config.FileFlushInterval(1000ms);
+  log_config.FileRotationSize(10'000'000);
+  log_config.FileGenerations(10);
+  log_config.FileCompressBackups(false);
+
+  const auto backup = [&](int index, const std::string &ext) {
+    auto file = filename.parent_path();
+    file.append("test_rotate_" + std::to_string(index) + ".log" + ext);
+    return file;
+  };
+  for (int index = 0; index < 3; ++index) {
+    EXPECT_TRUE(std::filesystem::exists(backup(index, ".gz"))) << index;
+    EXPECT_FALSE(std::filesystem::exists(backup(index, ""))) << index;
+  }
+  EXPECT_FALSE(std::filesystem::exists(backup(3, ".gz")));
+}
+
+TEST(Logging, LogToBinaryFile)  // NOLINT
+{
+  auto &log_config = LogConfig::Instance();
+  log_config.Type(LogType::LogToBinaryFile);
+  log_config.BaseName("test_binary");
+  log_config.SubDir("Testing/log");
+  log_config.BinaryFileSize(64 * 1024);  // Wraps the ring many times
+  ASSERT_TRUE(log_config.CreateDefaultLogger());
+  const std::filesystem::path filename(log_config.GetLogFile());
+  EXPECT_EQ(filename.extension().string(), ".blog");
+
+  constexpr int kNofMessages = 10'000;
+  for (int ii = 0; ii < kNofMessages; ++ii) {
+    LOG_INFO() << "Binary: " << ii;
+  }
+  log_config.DeleteLogChain();
+  log_config.BinaryFileSize(10'000'000);
+
+  auto text_file = filename;
+  text_file.replace_extension(".txt");
+  ASSERT_TRUE(ConvertBinaryLogFile(filename.string(), text_file.string()));
+
+  // The file keeps the latest messages in order.
+  std::ifstream file(text_file);
+  std::vector<int> index_list;
+  for (std::string line; std::getline(file, line);) {
+    EXPECT_NE(line.find("] [Info] Binary: "), std::string::npos) << line;
+    EXPECT_NE(line.find("test_logging:"), std::string::npos) << line;
+    const auto pos = line.find("Binary: ");
+    ASSERT_NE(pos, std::string::npos);
+    index_list.push_back(std::stoi(line.substr(pos + 8)));
+  }
+  ASSERT_FALSE(index_list.empty());
+  EXPECT_LT(index_list.size(), kNofMessages);
+  EXPECT_EQ(index_list.back(), kNofMessages - 1);
+  for (size_t index = 1; index < index_list.size(); ++index) {
+    EXPECT_EQ(index_list[index], index_list[index - 1] + 1);
+  }
+}
+
 TEST(Logging, DISABLED_LogToFilePerformance)  // NOLINT
 {
   jj = 0;
@@ -163,4 +289,147 @@ TEST(Logging, Test_LogToList) {
   log_config.DeleteLogChain();
 }
 
+TEST(Logging, DisabledSeverity) {
+  auto &log_config = LogConfig::Instance();
+  log_config.AddLogger("List", std::make_unique<LogToList>("List"));
+  auto *list_logger = dynamic_cast<LogToList *>(log_config.GetLogger("List"));
+  ASSERT_TRUE(list_logger != nullptr);
+  list_logger->EnableSeverityLevel(LogSeverity::kTrace, false);
+  EXPECT_FALSE(log_config.IsSeverityEnabled(LogSeverity::kTrace));
+  EXPECT_TRUE(log_config.IsSeverityEnabled(LogSeverity::kInfo));
+
+  int nof_calls = 0;
+  auto count = [&nof_calls] { return ++nof_calls; };
+  LOG_TRACE() << "Not evaluated: " << count();
+  EXPECT_EQ(nof_calls, 0);
+  EXPECT_EQ(list_logger->Size(), 0);
+
+  list_logger->EnableSeverityLevel(LogSeverity::kTrace, true);
+  LOG_TRACE() << "Evaluated: " << count();
+  EXPECT_EQ(nof_calls, 1);
+  EXPECT_EQ(list_logger->Size(), 1);
+
+  log_config.DeleteLogChain();
+  EXPECT_FALSE(log_config.IsSeverityEnabled(LogSeverity::kInfo));
+}
+
+TEST(Logging, StreamFormat) {
+  auto &log_config = LogConfig::Instance();
+  log_config.AddLogger("List", std::make_unique<LogToList>("List"));
+  auto *list_logger = dynamic_cast<LogToList *>(log_config.GetLogger("List"));
+  ASSERT_TRUE(list_logger != nullptr);
+
+  LOG_INFO().Format("Value: {} Name: {} {{}}", 12, "Olle") << " Tail";
+  ASSERT_EQ(list_logger->Size(), 1);
+  EXPECT_EQ(list_logger->GetLogMessage(0).message,
+            "Value: 12 Name: Olle {} Tail");
+
+  // A log call inside a log statement uses its own buffer
+  auto inner = [] {
+    LOG_INFO() << "Inner";
+    return 1;
+  };
+  LOG_INFO() << "Outer " << inner();
+  ASSERT_EQ(list_logger->Size(), 3);
+  EXPECT_EQ(list_logger->GetLogMessage(0).message, "Outer 1");
+  EXPECT_EQ(list_logger->GetLogMessage(1).message, "Inner");
+
+  log_config.DeleteLogChain();
+}
+
+TEST(Logging, AsyncLogToList) {
+  auto &log_config = LogConfig::Instance();
+  log_config.Type(LogType::LogToList);
+  log_config.CreateDefaultLogger();
+  log_config.AsyncLogging(true);
+  EXPECT_TRUE(log_config.AsyncLogging());
+
+  auto *list_logger =
+      dynamic_cast<LogToList *>(log_config.GetLogger("Default"));
+  ASSERT_TRUE(list_logger != nullptr);
+  list_logger->MaxSize(4000);
+
+  std::array<std::thread, 4> thread_list;
+  for (auto &thread : thread_list) {
+    thread = std::thread([] {
+      for (int ii = 0; ii < 1000; ++ii) {
+        LOG_INFO() << "Async: " << ii;
+      }
+    });
+  }
+  for (auto &thread : thread_list) {
+    thread.join();
+  }
+  log_config.AsyncLogging(false);  // Dispatches the queued messages
+  EXPECT_FALSE(log_config.AsyncLogging());
+  EXPECT_EQ(list_logger->Size(), 4000);
+
+  log_config.DeleteLogChain();
+}
+
+TEST(Logging, AsyncLoggingStop) {
+  auto &log_config = LogConfig::Instance();
+  log_config.Type(LogType::LogToList);
+  log_config.CreateDefaultLogger();
+  log_config.AsyncLogging(true);
+
+  auto *list_logger =
+      dynamic_cast<LogToList *>(log_config.GetLogger("Default"));
+  ASSERT_TRUE(list_logger != nullptr);
+  list_logger->MaxSize(40'000);
+
+  // No message may be lost while the asynchronous front end is turned off.
+  std::atomic<bool> started = false;
+  std::array<std::thread, 4> thread_list;
+  for (auto &thread : thread_list) {
+    thread = std::thread([&started] {
+      for (int ii = 0; ii < 10'000; ++ii) {
+        LOG_INFO() << "Stop: " << ii;
+        started = true;
+      }
+    });
+  }
+  while (!started) {
+    std::this_thread::yield();
+  }
+  log_config.AsyncLogging(false);
+  for (auto &thread : thread_list) {
+    thread.join();
+  }
+  EXPECT_FALSE(log_config.AsyncLogging());
+  EXPECT_EQ(list_logger->Size(), 40'000);
+
+  log_config.DeleteLogChain();
+}
+
+TEST(Logging, InternedLocation) {
+  const std::string name = "interned.cpp";
+  const char *interned = InternString(name);
+  EXPECT_STREQ(interned, "interned.cpp");
+  EXPECT_EQ(interned, InternString("interned.cpp"));
+  EXPECT_NE(interned, InternString("other.cpp"));
+
+  auto &log_config = LogConfig::Instance();
+  log_config.Type(LogType::LogToList);
+  log_config.CreateDefaultLogger();
+  auto *list_logger =
+      dynamic_cast<LogToList *>(log_config.GetLogger("Default"));
+  ASSERT_TRUE(list_logger != nullptr);
+
+  LogStringEx(10, 2, name, "Function", LogSeverity::kInfo, "Extended");
+  const auto location = Loc::current();
+  LOG_INFO() << "Location";
+  ASSERT_EQ(list_logger->Size(), 2);
+
+  // The extended message refers to the interned names.
+  const auto stream_message = list_logger->GetLogMessage(0);
+  EXPECT_STREQ(stream_message.file, location.file_name());
+  const auto ex_message = list_logger->GetLogMessage(1);
+  EXPECT_EQ(ex_message.file, interned);
+  EXPECT_STREQ(ex_message.function, "Function");
+  EXPECT_EQ(ex_message.line, 10);
+
+  log_config.DeleteLogChain();
+}
+
 }  // namespace util::test
\ No newline at end of file
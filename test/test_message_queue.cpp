@@ -7,9 +7,12 @@
 #include <array>
 #include <atomic>
 #include <chrono>
+#include <string>
 #include <string_view>
 #include <thread>
 
+#include <boost/interprocess/sync/scoped_lock.hpp>
+
 #include "messagequeue.h"
 using namespace boost::interprocess;
 using namespace std::chrono_literals;
@@ -31,6 +34,31 @@ void SendTask() {
   }
 }
 
+/// Copy of the original shared memory layout that older processes use.
+struct OldSharedListenQueue {
+  interprocess_recursive_mutex locker;
+  interprocess_semaphore message_semaphore;
+  std::atomic<bool> active = false;
+  std::atomic<uint8_t> log_level = 0;
+  std::atomic<uint16_t> nof_messages = 0;
+  uint8_t queue_in = 0;
+  uint8_t queue_out = 0;
+  SharedListenMessage queue[256]{};
+
+  OldSharedListenQueue() : message_semaphore(0) {}
+};
+
+/// Sends a message the same way as an older producer does.
+void OldAdd(OldSharedListenQueue& mem, const char* text) {
+  scoped_lock lock(mem.locker);
+  auto& in_msg = mem.queue[mem.queue_in];
+  in_msg = SharedListenMessage();
+  strcpy(in_msg.text, text);
+  ++mem.queue_in;
+  ++mem.nof_messages;
+  mem.message_semaphore.post();
+}
+
 void ReceiveTask(MessageQueue* queue) {
   kTaskCount = 0;
   do {
@@ -94,4 +122,240 @@ TEST(MessageQueue, TestMultipleSender) {
   std::cout << "Message Count: " << kTaskCount << std::endl;
   EXPECT_EQ(kTaskCount, task_list.size() * 10);
 }
+
+TEST(MessageQueue, TestPersistentMapping) {
+  auto master = std::make_unique<MessageQueue>(true, kQueueName.data());
+  MessageQueue producer(false, kQueueName.data(), true);
+  EXPECT_TRUE(producer.IsPersistent());
+
+  for (size_t index = 0; index < 10; ++index) {
+    SharedListenMessage msg;
+    msg.ns1970 = index;
+    strcpy(msg.text, "Text");
+    producer.Add(msg);
+  }
+  EXPECT_EQ(master->NofMessages(), 10);
+  EXPECT_EQ(producer.NofMessages(), 10);
+
+  // Restart the master. The producer should detect the new generation and
+  // remap the shared memory.
+  master.reset();
+  master = std::make_unique<MessageQueue>(true, kQueueName.data());
+  EXPECT_EQ(master->NofMessages(), 0);
+
+  for (size_t count = 0; count < 50 && master->NofMessages() == 0; ++count) {
+    SharedListenMessage msg;
+    strcpy(msg.text, "Text");
+    producer.Add(msg);
+    std::this_thread::sleep_for(100ms);
+  }
+  EXPECT_GT(master->NofMessages(), 0);
+  producer.Stop();
+}
+
+TEST(MessageQueue, TestCrashedMaster) {
+  // Creates a full queue the same way as a master that later crashes. The
+  // crashed master never sets the generation to zero.
+  shared_memory_object::remove(kQueueName.data());
+  shared_memory_object shared_mem(create_only, kQueueName.data(), read_write);
+  shared_mem.truncate(sizeof(SharedQueueHeader));
+  mapped_region region(shared_mem, read_write);
+  auto* crashed = new (region.get_address()) SharedQueueHeader;
+  crashed->active = true;
+  crashed->generation = 1;
+  crashed->base.nof_messages = 256;
+
+  MessageQueue producer(false, kQueueName.data(), true);
+  EXPECT_TRUE(producer.IsActive());
+  std::atomic<bool> added = false;
+  auto send_task = std::thread([&] {
+    SharedListenMessage msg;
+    strcpy(msg.text, "Text");
+    producer.Add(msg);
+    added = true;
+  });
+  std::this_thread::sleep_for(100ms);
+  EXPECT_FALSE(added);
+
+  // The producer shall remap to the restarted master and add the message.
+  MessageQueue master(true, kQueueName.data());
+  for (size_t count = 0; count < 50 && !added; ++count) {
+    std::this_thread::sleep_for(100ms);
+  }
+  EXPECT_TRUE(added);
+  EXPECT_EQ(master.NofMessages(), 1);
+  producer.Stop();
+  send_task.join();
+}
+
+TEST(MessageQueue, TestOldProducer) {
+  MessageQueue master(true, kQueueName.data());
+  master.SetActive(true);
+  master.SetLogLevel(3);
+
+  shared_memory_object shared_mem(open_only, kQueueName.data(), read_write);
+  mapped_region region(shared_mem, read_write);
+  auto* old_queue = static_cast<OldSharedListenQueue*>(region.get_address());
+  EXPECT_TRUE(old_queue->active);
+  EXPECT_EQ(old_queue->log_level, 3);
+
+  OldAdd(*old_queue, "Old");
+  EXPECT_EQ(master.NofMessages(), 1);
+  SharedListenMessage msg;
+  EXPECT_TRUE(master.Get(msg, false));
+  EXPECT_STREQ(msg.text, "Old");
+
+  // An older producer shall not send to a ring format.
+  MessageQueue ring(kQueueName.data(), SharedQueueFormat::RingQueue, 64);
+  ring.SetActive(true);
+  shared_memory_object ring_mem(open_only, kQueueName.data(), read_write);
+  mapped_region ring_region(ring_mem, read_write);
+  const auto* old_ring =
+      static_cast<OldSharedListenQueue*>(ring_region.get_address());
+  EXPECT_FALSE(old_ring->active);
+}
+
+TEST(MessageQueue, TestOldMaster) {
+  // Creates the shared memory the same way as an older master does.
+  shared_memory_object::remove(kQueueName.data());
+  shared_memory_object shared_mem(create_only, kQueueName.data(), read_write);
+  shared_mem.truncate(sizeof(OldSharedListenQueue));
+  mapped_region region(shared_mem, read_write);
+  auto* old_queue = new (region.get_address()) OldSharedListenQueue;
+  old_queue->active = true;
+  old_queue->log_level = 2;
+
+  for (const bool persistent : {false, true}) {
+    MessageQueue producer(false, kQueueName.data(), persistent);
+    EXPECT_TRUE(producer.IsActive());
+    EXPECT_EQ(producer.LogLevel(), 2);
+    EXPECT_EQ(producer.Format(), SharedQueueFormat::MutexQueue);
+    EXPECT_FALSE(producer.AddText(0, "", "Text"));
+
+    SharedListenMessage msg;
+    strcpy(msg.text, "New");
+    producer.Add(msg);
+    EXPECT_EQ(producer.NofMessages(), 1);
+    EXPECT_EQ(old_queue->nof_messages, 1);
+    EXPECT_TRUE(old_queue->message_semaphore.try_wait());
+    EXPECT_STREQ(old_queue->queue[old_queue->queue_out].text, "New");
+    ++old_queue->queue_out;
+    --old_queue->nof_messages;
+    producer.Stop();
+  }
+  shared_memory_object::remove(kQueueName.data());
+}
+
+TEST(MessageQueue, TestRingBasic) {
+  MessageQueue master(kQueueName.data(), SharedQueueFormat::RingQueue, 100);
+  EXPECT_EQ(master.Format(), SharedQueueFormat::RingQueue);
+
+  auto send_task = std::thread(&SendTask);
+  send_task.join();
+  EXPECT_EQ(master.NofMessages(), 10);
+
+  SharedListenMessage msg;
+  for (size_t index = 0; index < 10; ++index) {
+    EXPECT_TRUE(master.Get(msg, false));
+    EXPECT_EQ(msg.ns1970, index);
+    EXPECT_STREQ(msg.text, "Text");
+  }
+  EXPECT_FALSE(master.Get(msg, false));
+  EXPECT_EQ(master.NofMessages(), 0);
+}
+
+TEST(MessageQueue, TestRingMultipleSender) {
+  MessageQueue master(kQueueName.data(), SharedQueueFormat::RingQueue, 64);
+  kStopTask = false;
+  auto server_task = std::thread(&ReceiveTask, &master);
+  kTaskCount = 0;
+  std::array<std::thread, 1000> task_list;
+  for (auto& task1 : task_list) {
+    task1 = std::thread(&SendTask);
+  }
+
+  for (size_t count = 0; count < 3000 && kTaskCount < task_list.size() * 10;
+       ++count) {
+    std::this_thread::sleep_for(10ms);
+  }
+  for (auto& task2 : task_list) {
+    if (task2.joinable()) {
+      task2.join();
+    }
+  }
+  kStopTask = true;
+  master.Stop();
+  server_task.join();
+
+  std::cout << "Message Count: " << kTaskCount << std::endl;
+  EXPECT_EQ(kTaskCount, task_list.size() * 10);
+}
+
+TEST(MessageQueue, TestRecordBasic) {
+  MessageQueue master(kQueueName.data(), SharedQueueFormat::RecordQueue,
+                      64'000);
+  EXPECT_EQ(master.Format(), SharedQueueFormat::RecordQueue);
+
+  MessageQueue client(false, kQueueName.data());
+  const std::string long_text(1000, 'X');
+  // Wraps the ring several times
+  for (size_t index = 0; index < 1000; ++index) {
+    const std::string text = long_text + std::to_string(index);
+    EXPECT_TRUE(client.AddText(index, "Pre", text));
+    EXPECT_EQ(client.Format(), SharedQueueFormat::RecordQueue);
+    EXPECT_EQ(master.NofMessages(), 1);
+
+    ListenTextMessage msg;
+    EXPECT_TRUE(master.Get(msg, false));
+    EXPECT_EQ(msg.ns1970_, index);
+    EXPECT_EQ(msg.pre_text_, "Pre");
+    EXPECT_EQ(msg.text_, text);
+  }
+  ListenTextMessage empty;
+  EXPECT_FALSE(master.Get(empty, false));
+  EXPECT_EQ(master.NofMessages(), 0);
+
+  // Too large records should be split by the caller
+  const std::string huge_text(100'000, 'Y');
+  EXPECT_FALSE(client.AddText(0, "", huge_text));
+
+  // Fixed size messages are converted
+  auto send_task = std::thread(&SendTask);
+  send_task.join();
+  EXPECT_EQ(master.NofMessages(), 10);
+  SharedListenMessage msg;
+  for (size_t index = 0; index < 10; ++index) {
+    EXPECT_TRUE(master.Get(msg, false));
+    EXPECT_EQ(msg.ns1970, index);
+    EXPECT_STREQ(msg.text, "Text");
+  }
+  EXPECT_FALSE(master.Get(msg, false));
+}
+
+TEST(MessageQueue, TestRecordMultipleSender) {
+  MessageQueue master(kQueueName.data(), SharedQueueFormat::RecordQueue);
+  kStopTask = false;
+  auto server_task = std::thread(&ReceiveTask, &master);
+  kTaskCount = 0;
+  std::array<std::thread, 1000> task_list;
+  for (auto& task1 : task_list) {
+    task1 = std::thread(&SendTask);
+  }
+
+  for (size_t count = 0; count < 3000 && kTaskCount < task_list.size() * 10;
+       ++count) {
+    std::this_thread::sleep_for(10ms);
+  }
+  for (auto& task2 : task_list) {
+    if (task2.joinable()) {
+      task2.join();
+    }
+  }
+  kStopTask = true;
+  master.Stop();
+  server_task.join();
+
+  std::cout << "Message Count: " << kTaskCount << std::endl;
+  EXPECT_EQ(kTaskCount, task_list.size() * 10);
+}
 }  // end namespace util::test
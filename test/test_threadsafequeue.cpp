@@ -0,0 +1,293 @@
+/*
+ * Copyright 2025 Ingemar Hedvall
+ * SPDX-License-Identifier: MIT
+ */
+#include <gtest/gtest.h>
+
+#include <array>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "util/mpscqueue.h"
+#include "util/ringqueue.h"
+#include "util/threadsafequeue.h"
+
+using namespace util::log;
+using namespace std::chrono_literals;
+
+namespace {
+
+struct TestItem {
+  size_t producer = 0;
+  size_t index = 0;
+};
+
+/** Producers add all items while one consumer fetch them with GetAll().
+ * Returns number of items per second. */
+template <typename Queue>
+double RunProducers(size_t nof_producers, size_t nof_items, size_t batch) {
+  Queue queue;
+  std::vector<std::thread> producer_list;
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t producer = 0; producer < nof_producers; ++producer) {
+    producer_list.emplace_back([&queue, producer, nof_items, batch] {
+      std::vector<std::unique_ptr<TestItem>> item_list;
+      for (size_t index = 0; index < nof_items; ++index) {
+        auto item = std::make_unique<TestItem>();
+        item->producer = producer;
+        item->index = index;
+        if (batch <= 1) {
+          queue.Put(item);
+          continue;
+        }
+        item_list.push_back(std::move(item));
+        if (item_list.size() >= batch) {
+          queue.PutMany(item_list);
+        }
+      }
+      queue.PutMany(item_list);
+    });
+  }
+
+  // Checks that each producer's items are in order
+  std::vector<size_t> next_list(nof_producers, 0);
+  size_t count = 0;
+  std::vector<std::unique_ptr<TestItem>> dest;
+  while (count < nof_producers * nof_items) {
+    if (!queue.GetAll(dest, true)) {
+      break;
+    }
+    for (const auto& item : dest) {
+      EXPECT_EQ(item->index, next_list[item->producer]);
+      next_list[item->producer] = item->index + 1;
+    }
+    count += dest.size();
+    dest.clear();
+  }
+  const auto stop = std::chrono::steady_clock::now();
+  for (auto& producer : producer_list) {
+    producer.join();
+  }
+  EXPECT_EQ(count, nof_producers * nof_items);
+  EXPECT_TRUE(queue.Empty());
+  const std::chrono::duration<double> time = stop - start;
+  return time.count() > 0 ? static_cast<double>(count) / time.count() : 0.0;
+}
+
+template <typename Queue>
+void TestBlockingStop() {
+  Queue queue;
+  std::atomic<bool> done = false;
+  std::thread consumer([&] {
+    std::unique_ptr<TestItem> item;
+    EXPECT_FALSE(queue.Get(item, true));
+    done = true;
+  });
+  std::this_thread::sleep_for(10ms);
+  EXPECT_FALSE(done);
+  queue.Stop();
+  consumer.join();
+  EXPECT_TRUE(done);
+
+  queue.Start();
+  auto item = std::make_unique<TestItem>();
+  queue.Put(item);
+  EXPECT_EQ(queue.Size(), 1);
+  queue.Clear();
+  EXPECT_TRUE(queue.Empty());
+}
+
+}  // namespace
+
+namespace util::test {
+
+TEST(ThreadSafeQueue, PutManyGetAll) {
+  ThreadSafeQueue<TestItem> queue;
+  std::vector<std::unique_ptr<TestItem>> item_list;
+  for (size_t index = 0; index < 10; ++index) {
+    auto item = std::make_unique<TestItem>();
+    item->index = index;
+    item_list.push_back(std::move(item));
+  }
+  queue.PutMany(item_list);
+  EXPECT_TRUE(item_list.empty());
+  EXPECT_EQ(queue.Size(), 10);
+
+  std::unique_ptr<TestItem> first;
+  ASSERT_TRUE(queue.Get(first, false));
+  EXPECT_EQ(first->index, 0);
+
+  std::vector<std::unique_ptr<TestItem>> dest;
+  EXPECT_TRUE(queue.GetAll(dest, false));
+  ASSERT_EQ(dest.size(), 9);
+  for (size_t index = 0; index < dest.size(); ++index) {
+    EXPECT_EQ(dest[index]->index, index + 1);
+  }
+  EXPECT_TRUE(queue.Empty());
+  EXPECT_FALSE(queue.GetAll(dest, false));
+
+  TestBlockingStop<ThreadSafeQueue<TestItem>>();
+}
+
+TEST(ThreadSafeQueue, BoundedQueue) {
+  ThreadSafeQueue<TestItem> queue;
+  queue.MaxSize(2);
+  for (size_t index = 0; index < 3; ++index) {
+    auto item = std::make_unique<TestItem>();
+    item->index = index;
+    queue.Put(item);
+  }
+  EXPECT_EQ(queue.Size(), 2);
+  EXPECT_EQ(queue.NofDropped(), 1);
+  EXPECT_EQ(queue.HighWaterMark(), 2);
+
+  auto item = std::make_unique<TestItem>();
+  EXPECT_FALSE(queue.TryPut(item));
+  EXPECT_TRUE(item);  // Kept by the caller
+  EXPECT_FALSE(queue.Put(item, 10ms));
+  EXPECT_EQ(queue.NofDropped(), 2);
+
+  // A consumer makes room for the waiting producer
+  std::thread consumer([&] {
+    std::this_thread::sleep_for(10ms);
+    std::unique_ptr<TestItem> first;
+    EXPECT_TRUE(queue.Get(first, 100ms));
+  });
+  EXPECT_TRUE(queue.Put(item, 1000ms));
+  consumer.join();
+  EXPECT_FALSE(item);
+  EXPECT_EQ(queue.Size(), 2);
+
+  queue.Clear();
+  std::unique_ptr<TestItem> dest;
+  EXPECT_FALSE(queue.Get(dest, 10ms));
+}
+
+TEST(MpscQueue, PutManyGetAll) {
+  MpscQueue<TestItem> queue;
+  std::unique_ptr<TestItem> item = std::make_unique<TestItem>();
+  queue.Put(item);
+  EXPECT_FALSE(item);
+
+  std::vector<std::unique_ptr<TestItem>> item_list;
+  for (size_t index = 1; index < 10; ++index) {
+    auto temp = std::make_unique<TestItem>();
+    temp->index = index;
+    item_list.push_back(std::move(temp));
+  }
+  queue.PutMany(item_list);
+  EXPECT_TRUE(item_list.empty());
+  EXPECT_EQ(queue.Size(), 10);
+
+  std::unique_ptr<TestItem> first;
+  ASSERT_TRUE(queue.Get(first, false));
+  EXPECT_EQ(first->index, 0);
+
+  std::vector<std::unique_ptr<TestItem>> dest;
+  EXPECT_TRUE(queue.GetAll(dest, false));
+  ASSERT_EQ(dest.size(), 9);
+  for (size_t index = 0; index < dest.size(); ++index) {
+    EXPECT_EQ(dest[index]->index, index + 1);
+  }
+  EXPECT_TRUE(queue.Empty());
+  EXPECT_FALSE(queue.Get(first, false));
+
+  TestBlockingStop<MpscQueue<TestItem>>();
+}
+
+TEST(RingQueue, RecycleSlots) {
+  RingQueue<std::string> queue(4);
+  const std::string text(100, 'A');
+  for (size_t index = 0; index < 10; ++index) {
+    queue.Put(text + std::to_string(index));
+  }
+  EXPECT_EQ(queue.Size(), 10);
+  EXPECT_GE(queue.Capacity(), 10);  // The ring has grown
+
+  std::string dest;
+  for (size_t index = 0; index < 10; ++index) {
+    ASSERT_TRUE(queue.Get(dest, false));
+    EXPECT_EQ(dest, text + std::to_string(index));
+  }
+  EXPECT_TRUE(queue.Empty());
+  EXPECT_FALSE(queue.Get(dest, false));
+
+  // The consumer's object is recycled by the next producer
+  queue.Emplace([&](std::string& slot) { slot = "Recycled"; });
+  std::string other;
+  ASSERT_TRUE(queue.Get(other, false));
+  EXPECT_EQ(other, "Recycled");
+  const auto capacity = queue.Capacity();
+  for (size_t index = 0; index < 100; ++index) {
+    queue.Put(text);
+    std::vector<std::string> dest_list;
+    EXPECT_TRUE(queue.GetAll(dest_list, false));
+    EXPECT_EQ(dest_list.size(), 1);
+  }
+  EXPECT_EQ(queue.Capacity(), capacity);  // No more growing
+
+  std::atomic<bool> done = false;
+  std::thread consumer([&] {
+    std::string value;
+    EXPECT_FALSE(queue.Get(value, true));
+    done = true;
+  });
+  std::this_thread::sleep_for(10ms);
+  EXPECT_FALSE(done);
+  queue.Stop();
+  consumer.join();
+  EXPECT_TRUE(done);
+}
+
+TEST(RingQueue, BoundedQueue) {
+  RingQueue<std::string> queue(2);
+  queue.MaxSize(3);
+  for (size_t index = 0; index < 4; ++index) {
+    queue.Put(std::to_string(index));
+  }
+  EXPECT_EQ(queue.Size(), 3);
+  EXPECT_EQ(queue.Capacity(), 3);  // Doesn't grow beyond the max size
+  EXPECT_EQ(queue.NofDropped(), 1);
+  EXPECT_EQ(queue.HighWaterMark(), 3);
+  EXPECT_FALSE(queue.TryPut("4"));
+  EXPECT_FALSE(queue.Put("5", 10ms));
+
+  std::string dest;
+  ASSERT_TRUE(queue.Get(dest, 10ms));
+  EXPECT_EQ(dest, "0");
+  EXPECT_TRUE(queue.Put("6", 10ms));
+  queue.Clear();
+  EXPECT_FALSE(queue.Get(dest, 10ms));
+}
+
+TEST(ThreadSafeQueue, DISABLED_Contention) {  // NOLINT
+  // Prints items per second for 1 to 16 producers and one consumer.
+  constexpr size_t kNofItems = 400'000;  // Total number of items
+  constexpr std::array<size_t, 5> kProducerList = {1, 2, 4, 8, 16};
+  std::cout << std::setw(10) << "Producers" << std::setw(14) << "Put"
+            << std::setw(14) << "PutMany(64)" << std::setw(14) << "MPSC Put"
+            << std::setw(14) << "MPSC PutMany" << std::endl;
+  for (const auto nof_producers : kProducerList) {
+    const size_t nof_items = kNofItems / nof_producers;
+    const auto put =
+        RunProducers<ThreadSafeQueue<TestItem>>(nof_producers, nof_items, 1);
+    const auto put_many =
+        RunProducers<ThreadSafeQueue<TestItem>>(nof_producers, nof_items, 64);
+    const auto mpsc_put =
+        RunProducers<MpscQueue<TestItem>>(nof_producers, nof_items, 1);
+    const auto mpsc_put_many =
+        RunProducers<MpscQueue<TestItem>>(nof_producers, nof_items, 64);
+    std::cout << std::setw(10) << nof_producers << std::fixed
+              << std::setprecision(2) << std::setw(12) << put / 1e6 << " M"
+              << std::setw(12) << put_many / 1e6 << " M" << std::setw(12)
+              << mpsc_put / 1e6 << " M" << std::setw(12)
+              << mpsc_put_many / 1e6 << " M" << std::endl;
+  }
+}
+
+}  // namespace util::test
@@ -71,6 +71,25 @@ TEST(Timestamp, GetCurrentTimestampWithMs)  // NOLINT
   EXPECT_EQ(timestamp.size(), kTimestampMs.size()) << timestamp;
 }
 
+TEST(Timestamp, AppendLocalTimestampWithMs)  // NOLINT
+{
+  const auto second = floor<seconds>(SystemClock::now());
+  const auto date_time = GetLocalDateTime(second);
+  std::string text;
+  AppendLocalTimestampWithMs(second + 7ms, text);
+  EXPECT_EQ(text, date_time + ".007");
+
+  // Same second only updates the milliseconds
+  text.clear();
+  AppendLocalTimestampWithMs(second + 999ms, text);
+  EXPECT_EQ(text, date_time + ".999");
+
+  text = "[";
+  AppendLocalTimestampWithMs(second + 1s + 120ms, text);
+  EXPECT_EQ(text, "[" + GetLocalDateTime(second + 1s) + ".120");
+  EXPECT_EQ(GetLocalTimestampWithMs(second + 1s + 120ms), text.substr(1));
+}
+
 TEST(Timestamp, GetCurrentTimestampWithUs)  // NOLINT
 {
   const auto timestamp = GetLocalTimestampWithUs();
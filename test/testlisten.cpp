@@ -4,7 +4,11 @@
  */
 #include "testlisten.h"
 
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <iomanip>
+#include <map>
 #include <string_view>
 
 #include "listenclient.h"
@@ -23,6 +27,7 @@ namespace {
 constexpr uint64_t kServerPort = 43099;
 constexpr std::string_view kServerName = "TestServer";
 constexpr std::string_view kServerPreText = "TS>";
+constexpr std::string_view kShareName = "TestListenShare";
 bool kLogError = false;
 }  // namespace
 namespace util::test {
@@ -44,9 +49,12 @@ void ListenMock::AddMessage(uint64_t nano_sec_1970, const std::string &pre_text,
                             const std::string &text) {
   std::cout << time::NsToLocalIsoTime(nano_sec_1970) << " " << pre_text << " "
             << text << std::endl;
+  IncrementNumberOfMessages();
 }
 
-size_t ListenMock::LogLevel() { return 0; }
+size_t ListenMock::LogLevel() { return log_level_; }
+
+void ListenMock::SetLogLevel(size_t log_level) { log_level_ = log_level; }
 
 TEST_F(TestListen, ListenBasic) {
   ListenMock listen;
@@ -58,11 +66,158 @@ TEST_F(TestListen, ListenBasic) {
   listen.ListenString(temp.str());
   listen.ListenText("Test text %d", 12);
   listen.ListenTextEx(0, "NULL>", "Test text %d", 33);
+  listen.ListenFormat("Test text {}", 13);
+  listen.ListenFormatEx(0, "NULL>", "Test text {} {}", 34, "fmt");
   const std::vector<uint8_t> buffer = {0, 1, 2, 3, 4, 5, 6, 7};
   listen.ListenTransmit(time::TimeStampToNs(), "T>", buffer, nullptr);
   listen.ListenReceive(time::TimeStampToNs(), "R>", buffer, nullptr);
 }
 
+TEST_F(TestListen, ListenFormatText) {
+  const std::string name = "Olle";
+  EXPECT_EQ(IListen::FormatText("No arguments"), "No arguments");
+  EXPECT_EQ(IListen::FormatText("Value: {} Name: {}", 12, name),
+            "Value: 12 Name: Olle");
+  EXPECT_EQ(IListen::FormatText("{}{}{}", 'a', 1.5, "c"), "a1.5c");
+  EXPECT_EQ(IListen::FormatText("{{{}}}", 3), "{3}");
+  EXPECT_EQ(IListen::FormatText("Spec: {:x}", 10), "Spec: 10");
+  EXPECT_EQ(IListen::FormatText("Missing: {} {}", 1), "Missing: 1 ");
+  EXPECT_EQ(IListen::FormatText("Open {", 1), "Open {");
+
+  ListenMock listen;
+  const std::string long_text(3000, 'x');
+  listen.ListenText("%s", long_text.c_str());  // Longer than the stack buffer
+}
+
+TEST_F(TestListen, ListenLogLevel) {
+  ListenMock listen;
+  listen.PreText("LEVEL>");
+  for (size_t log_level = 0; log_level < 3; ++log_level) {
+    listen.SetLogLevel(log_level);
+    listen.ResetNumberOfMessages();
+    for (size_t level = 0; level < 3; ++level) {
+      EXPECT_EQ(listen.IsEnabled(level), level >= log_level);
+      listen.ListenText(level, "Text level %d", static_cast<int>(level));
+      listen.ListenFormat(level, "Format level {}", level);
+      listen.ListenString(level, "String level");
+    }
+    EXPECT_EQ(listen.GetNumberOfMessages(), 3 * (3 - log_level));
+  }
+}
+
+TEST_F(TestListen, ListenParseHex) {
+  std::vector<uint8_t> buffer;
+  for (size_t size = 0; size <= 100; ++size) {
+    std::ostringstream expected;
+    for (size_t index = 0; index < buffer.size(); ++index) {
+      if (index > 0) {
+        expected << " ";
+      }
+      expected << std::hex << std::setw(2) << std::setfill('0')
+               << static_cast<int>(buffer[index]);
+    }
+    const auto hex = IListen::ParseHex(buffer);
+    EXPECT_EQ(hex, expected.str()) << size;
+    EXPECT_EQ(hex.size(), IListen::HexSize(buffer.size()));
+    buffer.push_back(static_cast<uint8_t>(size * 37 + 0xF0));
+  }
+
+  // Only whole bytes are written into a too small buffer
+  const std::vector<uint8_t> data = {0x01, 0xA2, 0xFF};
+  std::array<char, 7> dest = {};
+  EXPECT_EQ(IListen::ParseHex(data.data(), data.size(), dest.data(), 7), 5);
+  EXPECT_EQ(std::string_view(dest.data(), 5), "01 a2");
+  EXPECT_EQ(IListen::ParseHex(data.data(), data.size(), dest.data(), 1), 0);
+}
+
+TEST_F(TestListen, ListenCompactFrame) {
+  ListenTextMessage msg;
+  msg.ns1970_ = time::TimeStampToNs();
+  msg.pre_text_ = "PRE>";
+  msg.text_ = "Compact text";
+
+  std::vector<uint8_t> normal;
+  msg.ToBuffer(normal);
+  std::vector<uint8_t> compact;
+  msg.ToCompactBuffer(compact, msg.ns1970_ - 1'000);
+  EXPECT_LE(compact.size() + 20, normal.size());
+
+  std::array<uint8_t, 8> header{};
+  std::copy_n(compact.cbegin(), header.size(), header.begin());
+  ListenTextMessage dest;
+  dest.FromHeaderBuffer(header);
+  EXPECT_EQ(dest.version_, ListenMessage::kCompactVersion);
+  EXPECT_EQ(dest.body_size_, compact.size() - 8);
+
+  const std::vector<uint8_t> body(compact.cbegin() + 8, compact.cend());
+  EXPECT_TRUE(dest.FromCompactBuffer(body, msg.ns1970_ - 1'000));
+  EXPECT_EQ(dest.ns1970_, msg.ns1970_);
+  EXPECT_EQ(dest.pre_text_, msg.pre_text_);
+  EXPECT_EQ(dest.text_, msg.text_);
+
+  // Time stamps may go backwards
+  msg.ToCompactBuffer(compact, msg.ns1970_ + 1'000);
+  const std::vector<uint8_t> body2(compact.cbegin() + 8, compact.cend());
+  EXPECT_TRUE(dest.FromCompactBuffer(body2, msg.ns1970_ + 1'000));
+  EXPECT_EQ(dest.ns1970_, msg.ns1970_);
+
+  const std::vector<uint8_t> corrupt(body.cbegin(), body.cend() - 1);
+  EXPECT_FALSE(dest.FromCompactBuffer(corrupt, msg.ns1970_ - 1'000));
+}
+
+TEST_F(TestListen, ListenBatchMessage) {
+  ListenBatchMessage batch;
+  const uint64_t now = time::TimeStampToNs();
+  for (size_t index = 0; index < 100; ++index) {
+    auto text = std::make_unique<ListenTextMessage>();
+    text->ns1970_ = now + index * 1'000;
+    text->pre_text_ = "BUS>";
+    text->text_ = "01 02 03 04 05 06 07 08 " + std::to_string(index);
+    batch.text_list_.push_back(std::move(text));
+  }
+  std::vector<uint8_t> buffer;
+  batch.ToBuffer(buffer);
+  EXPECT_LT(buffer.size(), 100 * 20);  // Compressed
+
+  std::array<uint8_t, 8> header{};
+  std::copy_n(buffer.cbegin(), header.size(), header.begin());
+  ListenBatchMessage dest;
+  dest.FromHeaderBuffer(header);
+  EXPECT_EQ(dest.type_, ListenMessageType::TextBatch);
+  EXPECT_EQ(dest.body_size_, buffer.size() - 8);
+
+  const std::vector<uint8_t> body(buffer.cbegin() + 8, buffer.cend());
+  ASSERT_TRUE(dest.FromBodyBuffer(body));
+  ASSERT_EQ(dest.text_list_.size(), 100);
+  for (size_t index = 0; index < dest.text_list_.size(); ++index) {
+    const auto &text = dest.text_list_[index];
+    EXPECT_EQ(text->ns1970_, now + index * 1'000);
+    EXPECT_EQ(text->pre_text_, "BUS>");
+    EXPECT_EQ(text->text_, "01 02 03 04 05 06 07 08 " + std::to_string(index));
+  }
+
+  const std::vector<uint8_t> corrupt(body.cbegin(), body.cend() - 10);
+  EXPECT_FALSE(dest.FromBodyBuffer(corrupt));
+
+  // Null texts are not counted
+  batch.text_list_.emplace_back();
+  batch.text_list_.insert(batch.text_list_.begin(), nullptr);
+  buffer.clear();
+  batch.ToBuffer(buffer);
+  const std::vector<uint8_t> body3(buffer.cbegin() + 8, buffer.cend());
+  ASSERT_TRUE(dest.FromBodyBuffer(body3));
+  EXPECT_EQ(dest.text_list_.size(), 100);
+
+  // A block size above the protocol maximum is rejected before allocating
+  std::vector<uint8_t> huge = {1, 1};  // One text, zlib compressed
+  for (uint64_t size = ListenBatchMessage::kMaxBlockSize + 1; size > 0;
+       size >>= 7) {
+    huge.push_back(static_cast<uint8_t>(size >= 0x80 ? size | 0x80 : size));
+  }
+  huge.resize(huge.size() + 100'000, 0);
+  EXPECT_FALSE(dest.FromBodyBuffer(huge));
+}
+
 TEST_F(TestListen, ListenServer) {
   auto server = UtilFactory::CreateListen("ListenServer", "");
   ASSERT_TRUE(server);
@@ -92,6 +247,415 @@ TEST_F(TestListen, ListenServer) {
   server.reset();
 }
 
+TEST_F(TestListen, ListenServerShareMemory) {
+  for (const auto format : {ListenQueueFormat::MutexQueue,
+                            ListenQueueFormat::RingQueue,
+                            ListenQueueFormat::RecordQueue}) {
+    auto server =
+        UtilFactory::CreateListen(TypeOfListen::ListenServerType,
+                                  kShareName.data());
+    ASSERT_TRUE(server);
+    server->ShareQueueFormat(format);
+    server->Name(kServerName.data());
+    server->HostName("127.0.0.1");
+    server->Port(kServerPort);
+    EXPECT_TRUE(server->Start());
+
+    auto client = UtilFactory::CreateListenClient("localhost", kServerPort);
+    ASSERT_TRUE(client);
+    auto proxy = UtilFactory::CreateListen(TypeOfListen::ListenProxyType,
+                                           kShareName.data());
+    ASSERT_TRUE(proxy);
+    for (size_t index1 = 0; index1 < 50 && !proxy->IsActive(); ++index1) {
+      std::this_thread::sleep_for(100ms);
+    }
+    ASSERT_TRUE(proxy->IsActive());
+
+    proxy->ListenText("Proxy text %d", 1);
+
+    bool found = false;
+    for (size_t index2 = 0; index2 < 100 && !found; ++index2) {
+      std::unique_ptr<ListenMessage> msg;
+      while (!found && client->GetMsg(msg)) {
+        const auto *text = dynamic_cast<const ListenTextMessage *>(msg.get());
+        found = text != nullptr && text->text_ == "Proxy text 1";
+      }
+      if (!found) {
+        std::this_thread::sleep_for(10ms);
+      }
+    }
+    EXPECT_TRUE(found);
+
+    proxy.reset();
+    client.reset();
+    EXPECT_TRUE(server->Stop());
+    server.reset();
+  }
+}
+
+TEST_F(TestListen, ListenServerBurst) {
+  for (const bool batch : {false, true}) {
+    auto server =
+        UtilFactory::CreateListen(TypeOfListen::ListenServerType, "");
+    ASSERT_TRUE(server);
+    server->BatchMessages(batch);
+    server->Name(kServerName.data());
+    server->HostName("127.0.0.1");
+    server->Port(kServerPort);
+    EXPECT_TRUE(server->Start());
+
+    // The text frames are shared between the connections
+    std::array<std::unique_ptr<IListenClient>, 2> client_list;
+    for (auto &client : client_list) {
+      client = UtilFactory::CreateListenClient("localhost", kServerPort);
+      ASSERT_TRUE(client);
+    }
+    for (size_t index1 = 0;
+         index1 < 100 && server->NofConnections() < client_list.size();
+         ++index1) {
+      std::this_thread::sleep_for(10ms);
+    }
+    ASSERT_EQ(server->NofConnections(), client_list.size());
+
+    constexpr size_t kNofMessages = 10'000;
+    const uint64_t start_ns1970 = time::TimeStampToNs();
+    for (size_t index2 = 0; index2 < kNofMessages; ++index2) {
+      server->ListenText("Burst %d", static_cast<int>(index2));
+    }
+
+    for (auto &client : client_list) {
+      size_t count = 0;
+      for (size_t index3 = 0; index3 < 500 && count < kNofMessages; ++index3) {
+        std::unique_ptr<ListenMessage> msg;
+        while (client->GetMsg(msg)) {
+          const auto *text = dynamic_cast<const ListenTextMessage *>(msg.get());
+          if (text == nullptr) {
+            continue;
+          }
+          EXPECT_EQ(text->text_, "Burst " + std::to_string(count));
+          // Compact frames have delta time stamps
+          EXPECT_GE(text->ns1970_, start_ns1970);
+          ++count;
+        }
+        if (count < kNofMessages) {
+          std::this_thread::sleep_for(10ms);
+        }
+      }
+      EXPECT_EQ(count, kNofMessages);
+      client.reset();
+    }
+
+    EXPECT_TRUE(server->Stop());
+    server.reset();
+  }
+}
+
+TEST_F(TestListen, ListenMuxServer) {
+  auto server = UtilFactory::CreateListen(TypeOfListen::ListenMuxServerType, "");
+  ASSERT_TRUE(server);
+  server->Name(kServerName.data());
+  server->HostName("127.0.0.1");
+  server->Port(kServerPort);
+
+  constexpr std::array<std::string_view, 3> kShareList = {
+      "TestMux0", "TestMux1", "TestMux2"};
+  std::array<IListen *, 3> channel_list = {};
+  for (size_t index = 0; index < kShareList.size(); ++index) {
+    channel_list[index] = server->AddChannel(kShareList[index].data());
+    ASSERT_TRUE(channel_list[index] != nullptr);
+    channel_list[index]->PreText(kShareList[index].data());
+  }
+  channel_list[1]->BatchMessages(true);
+  EXPECT_TRUE(server->AddChannel("TestMux0") == nullptr);
+  EXPECT_TRUE(server->Start());
+
+  // Client 0 listen to channel 0 and 1 while client 1 listen to all.
+  std::array<std::unique_ptr<IListenClient>, 2> client_list;
+  for (auto &client : client_list) {
+    client = UtilFactory::CreateListenClient("localhost", kServerPort);
+    ASSERT_TRUE(client);
+  }
+  client_list[0]->Subscribe({"TestMux0", "TestMux1", "Unknown"});
+  client_list[1]->Subscribe({});
+  const std::array<size_t, 3> nof_connections = {2, 2, 1};
+  for (size_t index = 0; index < 100; ++index) {
+    const bool ready = channel_list[0]->NofConnections() == 2 &&
+                       channel_list[1]->NofConnections() == 2 &&
+                       channel_list[2]->NofConnections() == 1;
+    if (ready) {
+      break;
+    }
+    std::this_thread::sleep_for(10ms);
+  }
+  for (size_t index = 0; index < channel_list.size(); ++index) {
+    EXPECT_EQ(channel_list[index]->NofConnections(), nof_connections[index]);
+  }
+
+  constexpr size_t kNofMessages = 3'000;
+  const uint64_t start_ns1970 = time::TimeStampToNs();
+  for (size_t index = 0; index < kNofMessages; ++index) {
+    channel_list[index % 3]->ListenText("Mux %d", static_cast<int>(index));
+  }
+
+  for (size_t client_index = 0; client_index < client_list.size();
+       ++client_index) {
+    auto &client = client_list[client_index];
+    const size_t nof_channels = client_index == 0 ? 2 : 3;
+    const size_t expected = kNofMessages * nof_channels / 3;
+    std::map<std::string, uint32_t> subscribe_list;
+    std::array<size_t, 3> next_list = {0, 1, 2};
+    size_t count = 0;
+    for (size_t index = 0; index < 500 && count < expected; ++index) {
+      std::unique_ptr<ListenMessage> msg;
+      while (client->GetMsg(msg)) {
+        const auto *reply = dynamic_cast<const ListenSubscribeMessage *>(
+            msg.get());
+        if (reply != nullptr) {
+          subscribe_list = reply->channel_list_;
+          continue;
+        }
+        const auto *text = dynamic_cast<const ListenTextMessage *>(msg.get());
+        if (text == nullptr) {
+          continue;
+        }
+        ASSERT_LT(text->channel_, 3);
+        auto &next = next_list[text->channel_];
+        EXPECT_EQ(text->pre_text_, kShareList[text->channel_]);
+        EXPECT_EQ(text->text_, "Mux " + std::to_string(next));
+        EXPECT_GE(text->ns1970_, start_ns1970);
+        next += 3;
+        ++count;
+      }
+      if (count < expected) {
+        std::this_thread::sleep_for(10ms);
+      }
+    }
+    EXPECT_EQ(count, expected);
+    EXPECT_EQ(subscribe_list.size(), nof_channels);
+    EXPECT_EQ(subscribe_list["TestMux1"], 1);
+  }
+
+  // Log level on one channel
+  client_list[0]->SendLogLevel(1, 2);
+  for (size_t index = 0;
+       index < 100 && channel_list[1]->LogLevel() != 2; ++index) {
+    std::this_thread::sleep_for(10ms);
+  }
+  EXPECT_EQ(channel_list[1]->LogLevel(), 2);
+  EXPECT_EQ(channel_list[0]->LogLevel(), 0);
+
+  for (auto &client : client_list) {
+    client.reset();
+  }
+  EXPECT_TRUE(server->Stop());
+  server.reset();
+}
+
+TEST_F(TestListen, ListenSharedPool) {
+  auto pool = UtilFactory::CreateIoContextPool(2);
+  ASSERT_TRUE(pool);
+  EXPECT_EQ(pool->NofThreads(), 2);
+  const std::weak_ptr<IoContextPool> weak_pool = pool;
+
+  // Two servers and their clients share the two pool threads
+  std::array<std::unique_ptr<IListen>, 2> server_list;
+  std::array<std::unique_ptr<IListenClient>, 2> client_list;
+  for (size_t index = 0; index < server_list.size(); ++index) {
+    auto &server = server_list[index];
+    server = UtilFactory::CreateListen(TypeOfListen::ListenServerType, "",
+                                       pool);
+    ASSERT_TRUE(server);
+    server->Name(kServerName.data());
+    server->HostName("127.0.0.1");
+    server->Port(kServerPort + index);
+    EXPECT_TRUE(server->Start());
+    client_list[index] = UtilFactory::CreateListenClient(
+        "localhost", kServerPort + index, pool);
+    ASSERT_TRUE(client_list[index]);
+  }
+  pool.reset();  // The objects keep the pool alive
+  EXPECT_FALSE(weak_pool.expired());
+
+  for (size_t index = 0; index < 100; ++index) {
+    const bool ready = server_list[0]->NofConnections() == 1 &&
+                       server_list[1]->NofConnections() == 1;
+    if (ready) {
+      break;
+    }
+    std::this_thread::sleep_for(10ms);
+  }
+  for (auto &server : server_list) {
+    EXPECT_EQ(server->NofConnections(), 1);
+  }
+
+  constexpr size_t kNofMessages = 1'000;
+  for (size_t index = 0; index < kNofMessages; ++index) {
+    server_list[index % 2]->ListenText("Pool %d", static_cast<int>(index));
+  }
+
+  for (size_t client_index = 0; client_index < client_list.size();
+       ++client_index) {
+    auto &client = client_list[client_index];
+    size_t next = client_index;
+    size_t count = 0;
+    for (size_t index = 0; index < 500 && count < kNofMessages / 2; ++index) {
+      std::unique_ptr<ListenMessage> msg;
+      while (client->GetMsg(msg)) {
+        const auto *text = dynamic_cast<const ListenTextMessage *>(msg.get());
+        if (text == nullptr) {
+          continue;
+        }
+        EXPECT_EQ(text->text_, "Pool " + std::to_string(next));
+        next += 2;
+        ++count;
+      }
+      if (count < kNofMessages / 2) {
+        std::this_thread::sleep_for(10ms);
+      }
+    }
+    EXPECT_EQ(count, kNofMessages / 2);
+  }
+
+  // Stopping one server doesn't stop the shared context
+  EXPECT_TRUE(server_list[0]->Stop());
+  server_list[1]->ListenText("After stop");
+  bool found = false;
+  for (size_t index = 0; index < 100 && !found; ++index) {
+    std::unique_ptr<ListenMessage> msg;
+    while (!found && client_list[1]->GetMsg(msg)) {
+      const auto *text = dynamic_cast<const ListenTextMessage *>(msg.get());
+      found = text != nullptr && text->text_ == "After stop";
+    }
+    if (!found) {
+      std::this_thread::sleep_for(10ms);
+    }
+  }
+  EXPECT_TRUE(found);
+
+  for (auto &client : client_list) {
+    client.reset();
+  }
+  for (auto &server : server_list) {
+    server.reset();
+  }
+  EXPECT_TRUE(weak_pool.expired());
+}
+
+TEST_F(TestListen, ListenServerQueueLimit) {
+  // The viewer is a socket that never reads, so the server queue fills up.
+  for (const auto policy : {ListenOverflowPolicy::DropNewest,
+                            ListenOverflowPolicy::Disconnect}) {
+    auto server =
+        UtilFactory::CreateListen(TypeOfListen::ListenServerType, "");
+    ASSERT_TRUE(server);
+    server->Name(kServerName.data());
+    server->HostName("127.0.0.1");
+    server->Port(kServerPort);
+    server->QueueLimit(100, policy);
+    EXPECT_TRUE(server->Start());
+
+    boost::asio::io_context context;
+    boost::asio::ip::tcp::socket viewer(context);
+    viewer.connect({boost::asio::ip::make_address("127.0.0.1"), kServerPort});
+    for (size_t index1 = 0; index1 < 100 && !server->IsActive(); ++index1) {
+      std::this_thread::sleep_for(10ms);
+    }
+    ASSERT_TRUE(server->IsActive());
+
+    // The texts are paced, so the client queue drops them and not the
+    // server's input queue.
+    const std::string long_text(1'000, 'X');
+    for (size_t index2 = 0; index2 < 500'000 && server->IsActive() &&
+                            server->NofDroppedMessages() == 0;
+         ++index2) {
+      server->ListenString(long_text);
+      if (index2 % 50 == 0) {
+        std::this_thread::sleep_for(1ms);
+      }
+    }
+    for (size_t index3 = 0;
+         index3 < 100 && server->NofDroppedMessages() == 0; ++index3) {
+      std::this_thread::sleep_for(10ms);
+    }
+    EXPECT_GT(server->NofDroppedMessages(), 0);
+
+    if (policy == ListenOverflowPolicy::Disconnect) {
+      for (size_t index4 = 0; index4 < 50 && server->NofConnections() > 0;
+           ++index4) {
+        std::this_thread::sleep_for(100ms);
+      }
+      EXPECT_EQ(server->NofConnections(), 0);
+    }
+
+    viewer.close();
+    EXPECT_TRUE(server->Stop());
+  }
+}
+
+TEST_F(TestListen, ListenMuxServerQueueLimit) {
+  // The viewer subscribes to all channels but never reads.
+  auto server = UtilFactory::CreateListen(TypeOfListen::ListenMuxServerType, "");
+  ASSERT_TRUE(server);
+  server->Name(kServerName.data());
+  server->HostName("127.0.0.1");
+  server->Port(kServerPort);
+  server->QueueLimit(100, ListenOverflowPolicy::DropNewest);
+
+  std::array<IListen *, 2> channel_list = {};
+  channel_list[0] = server->AddChannel("TestMuxLimit0");
+  channel_list[1] = server->AddChannel("TestMuxLimit1");
+  for (const auto *channel : channel_list) {
+    ASSERT_TRUE(channel != nullptr);
+  }
+  EXPECT_TRUE(server->Start());
+
+  boost::asio::io_context context;
+  boost::asio::ip::tcp::socket viewer(context);
+  viewer.connect({boost::asio::ip::make_address("127.0.0.1"), kServerPort});
+  ListenSubscribeMessage subscribe;
+  boost::asio::write(viewer, boost::asio::buffer(*subscribe.ToFrame()));
+  for (size_t index1 = 0; index1 < 100 && !(channel_list[0]->IsActive() &&
+                                            channel_list[1]->IsActive());
+       ++index1) {
+    std::this_thread::sleep_for(10ms);
+  }
+  ASSERT_TRUE(channel_list[0]->IsActive());
+  ASSERT_TRUE(channel_list[1]->IsActive());
+
+  const std::string long_text(1'000, 'X');
+  for (size_t index2 = 0;
+       index2 < 500'000 && (channel_list[0]->NofDroppedMessages() == 0 ||
+                            channel_list[1]->NofDroppedMessages() == 0);
+       ++index2) {
+    channel_list[index2 % 2]->ListenString(long_text);
+    if (index2 % 50 == 0) {
+      std::this_thread::sleep_for(1ms);
+    }
+  }
+  // Let the channels empty their input queues.
+  std::this_thread::sleep_for(200ms);
+  const uint64_t dropped0 = channel_list[0]->NofDroppedMessages();
+  const uint64_t dropped1 = channel_list[1]->NofDroppedMessages();
+  EXPECT_GT(dropped0, 0);
+  EXPECT_GT(dropped1, 0);
+  EXPECT_EQ(server->NofDroppedMessages(), dropped0 + dropped1);
+
+  // The counters shall not change when the connection is removed.
+  viewer.close();
+  for (size_t index3 = 0; index3 < 50 && server->NofConnections() > 0;
+       ++index3) {
+    std::this_thread::sleep_for(100ms);
+  }
+  EXPECT_EQ(server->NofConnections(), 0);
+  EXPECT_EQ(channel_list[0]->NofConnections(), 0);
+  EXPECT_EQ(channel_list[1]->NofConnections(), 0);
+  EXPECT_EQ(channel_list[0]->NofDroppedMessages(), dropped0);
+  EXPECT_EQ(channel_list[1]->NofDroppedMessages(), dropped1);
+  EXPECT_EQ(server->NofDroppedMessages(), dropped0 + dropped1);
+
+  EXPECT_TRUE(server->Stop());
+}
+
 TEST_F(TestListen, ListenConfig) {
   ListenPortConfig devils_port;
   devils_port.port = 666;
@@ -18,10 +18,14 @@ class ListenMock : public util::log::IListen {
   ~ListenMock() override = default;
   [[nodiscard]] bool IsActive() const override;
   [[nodiscard]] size_t LogLevel() override;
+  void SetLogLevel(size_t log_level) override;
 
  protected:
   void AddMessage(uint64_t nano_sec_1970, const std::string &pre_text,
                   const std::string &text) override;
+
+ private:
+  size_t log_level_ = 0;
 };
 
 class TestListen : public ::testing::Test {